@@ -769,6 +769,120 @@ double BR_Envelope::ValueAtPosition (double position, bool fastMode /*= false*/)
 	}
 }
 
+void BR_Envelope::ValuesAtPositions (double position, double step, int count, double* values)
+{
+	if (count <= 0)
+		return;
+
+	// Segment walking presumes sorted points (don't sort here, point ids would change under the caller)
+	if (!m_sorted)
+	{
+		for (int i = 0; i < count; ++i)
+			values[i] = this->ValueAtPosition(position + step * i, true);
+		return;
+	}
+
+	position -= m_takeEnvOffset;
+
+	const bool faderMode = this->IsScaledToFader();
+	const int pointCount = (int)m_points.size();
+	int id = this->FindPrevious(position, 0);
+	int i  = 0;
+
+	while (i < count)
+	{
+		double currentPos = position + step * i;
+		while (id + 1 < pointCount && m_points[id + 1].position < currentPos)
+			++id;
+
+		// No previous point?
+		if (id < 0)
+		{
+			const double value = (pointCount > 0) ? m_points[0].value : this->LaneCenterValue();
+			const double end   = (pointCount > 0) ? m_points[0].position : numeric_limits<double>::max();
+			for (; i < count && position + step * i <= end; ++i)
+				values[i] = value;
+			continue;
+		}
+
+		// No next point?
+		const int nextId = id + 1;
+		if (nextId >= pointCount)
+		{
+			const double value = m_points[id].value;
+			for (; i < count; ++i)
+				values[i] = value;
+			break;
+		}
+
+		// Position at the end of transition ?
+		const double t1 = m_points[id].position;
+		const double t2 = m_points[nextId].position;
+		if (currentPos == t2)
+		{
+			values[i++] = m_points[this->LastPointAtPos(nextId)].value;
+			continue;
+		}
+
+		// Everything else - render whole segment with constants calculated only once
+		double v1 = m_points[id].value;
+		double v2 = m_points[nextId].value;
+		if (faderMode)
+		{
+			v1 = this->NormalizedDisplayValue(v1);
+			v2 = this->NormalizedDisplayValue(v2);
+		}
+
+		const int shape = m_points[id].shape;
+		double x1 = 0, x2 = 0, y1 = 0, y2 = 0;
+		if (shape == BEZIER)
+		{
+			double t0 = (!this->ValidateId(id - 1))     ? (t1) : (m_points[id - 1].position);
+			double v0 = (!this->ValidateId(id - 1))     ? (v1) : (m_points[id - 1].value);
+			double t3 = (!this->ValidateId(nextId + 1)) ? (t2) : (m_points[nextId + 1].position);
+			double v3 = (!this->ValidateId(nextId + 1)) ? (v2) : (m_points[nextId + 1].value);
+			if (faderMode)
+			{
+				v0 = this->NormalizedDisplayValue(v0);
+				v3 = this->NormalizedDisplayValue(v3);
+			}
+
+			double empty;
+			LICE_Bezier_FindCardinalCtlPts(0.25, t0, t1, t2, v0, v1, v2, &empty, &x1, &empty, &y1);
+			LICE_Bezier_FindCardinalCtlPts(0.25, t1, t2, t3, v1, v2, v3, &x2, &empty, &y2, &empty);
+
+			double tension = m_points[id].bezier;
+			x1 += tension * ((tension > 0) ? (t2-x1) : (x1-t1));
+			x2 += tension * ((tension > 0) ? (t2-x2) : (x2-t1));
+			y1 -= tension * ((tension > 0) ? (y1-v1) : (v2-y1));
+			y2 -= tension * ((tension > 0) ? (y2-v1) : (v2-y2));
+
+			x1 = SetToBounds(x1, t1, t2);
+			x2 = SetToBounds(x2, t1, t2);
+			y1 = SetToBounds(y1, this->MinValueAbs(), this->MaxValueAbs());
+			y2 = SetToBounds(y2, this->MinValueAbs(), this->MaxValueAbs());
+		}
+
+		const double invLen = 1 / (t2 - t1);
+		for (; i < count && (currentPos = position + step * i) < t2; ++i)
+		{
+			const double t = (currentPos - t1) * invLen;
+			double value;
+			switch (shape)
+			{
+				case SQUARE:         value = v1;                                                                                  break;
+				case LINEAR:         value = (!m_tempoMap) ? (v1 + (v2 - v1) * t) : CalculateTempoAtPosition(v1, v2, t1, t2, currentPos); break;
+				case FAST_END:       value = v1 + (v2 - v1) * (t * t * t);                                                        break;
+				case FAST_START:     value = v1 + (v2 - v1) * (1 - (1-t) * (1-t) * (1-t));                                        break;
+				case SLOW_START_END: value = v1 + (v2 - v1) * (t * t * (3 - 2*t));                                                break;
+				case BEZIER:         value = LICE_CBezier_GetY(t1, x1, x2, t2, v1, y1, y2, v2, currentPos);                       break;
+				default:             value = 0;                                                                                   break;
+			}
+			values[i] = (faderMode) ? this->RealValue(value) : value;
+		}
+	}
+}
+
 double BR_Envelope::NormalizedDisplayValue (double value)
 {
 	double min = this->LaneMinValue();
@@ -112,6 +112,7 @@ public:
 
 	/* Points properties */
 	double ValueAtPosition (double position, bool fastMode = false); // fastMode will not use native API which is more accurate in some cases (noticed it with bezier curves), but much slower with high point count (accuracy difference should be minimal but still important when dealing with things like mouse detection where every pixel counts!)
+	void ValuesAtPositions (double position, double step, int count, double* values); // same as ValueAtPosition() in fastMode, but renders count equally spaced positions walking envelope segments only once (use for audio rate evaluation)
 	double NormalizedDisplayValue (double value);                    // Convert point value to 0.0 - 1.0 range as displayed in arrange
 	double RealValue (double normalizedDisplayValue);                // Convert normalized display value in range 0.0 - 1.0 to real envelope value
 	double SnapValue (double value);                                 // Snaps value to current settings (only relevant for take pitch envelope)
@@ -35,7 +35,12 @@
 #include "../SnM/SnM.h"
 #include "../libebur128/ebur128.h"
 
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 #include <WDL/localize/localize.h>
+#include <WDL/sha.h>
 
 /******************************************************************************
 * Constants                                                                   *
@@ -65,6 +70,20 @@ const char* const EXPORT_FORMAT_RECENT = "BR - LoudnessExportFormat_Pattern_";
 const int EXPORT_FORMAT_RECENT_MAX      = 10;
 const int VERSION                       = 1;
 
+const char* const CACHE_DIR          = "SWS_LoudnessCache";
+const char* const CACHE_INDEX        = "index";
+const char* const CACHE_ENTRY_MAGIC  = "BRLC";
+const char* const CACHE_INDEX_MAGIC  = "BRLI";
+const int CACHE_VERSION              = 1;
+
+const double REANALYZE_WARMUP          = 0.5;  // seconds of unchanged audio K-weighting filters get before the edited range
+const double REANALYZE_MAX_PART        = 0.75; // re-analyze everything if incremental analysis would cover more than this part of the audio
+const double REANALYZE_TOLERANCE       = 1e-8; // relative difference of block energies still considered equal
+const int    REANALYZE_CONVERGE_BLOCKS = 30;   // equal gating blocks in a row needed to stop incremental analysis
+
+const double READ_AHEAD_BLOCK_TIME = 4; // seconds of audio read from accessor at once while analyzing
+const int    READ_AHEAD_BLOCKS     = 3; // blocks decoded ahead of analysis
+
 // Export format wildcards
 static const struct
 {
@@ -184,6 +203,206 @@ static HWND                                                           g_normaliz
 /******************************************************************************
 * Loudness object                                                             *
 ******************************************************************************/
+static void AddDirtyRange (double* start, double* end, double rangeStart, double rangeEnd)
+{
+	*start = std::min(*start, rangeStart);
+	*end   = std::max(*end,   rangeEnd);
+}
+
+static void AddEnvelopeDirtyRange (BR_Envelope& oldEnv, BR_Envelope& newEnv, double offset, double* start, double* end)
+{
+	// Same as in AnalyzeData(), points of inactive envelope don't matter
+	const int oldCount = (oldEnv.IsActive()) ? oldEnv.CountPoints() : 0;
+	const int newCount = (newEnv.IsActive()) ? newEnv.CountPoints() : 0;
+
+	// Skip points that didn't change at both ends of the envelope, everything between surrounding points of the rest got edited
+	struct Point
+	{
+		double position, value, bezier;
+		int shape;
+		bool operator== (const Point& p) const { return position == p.position && value == p.value && bezier == p.bezier && shape == p.shape; }
+	};
+	vector<Point> oldPoints(oldCount), newPoints(newCount);
+	for (int i = 0; i < oldCount; ++i)
+		oldEnv.GetPoint(i, &oldPoints[i].position, &oldPoints[i].value, &oldPoints[i].shape, &oldPoints[i].bezier);
+	for (int i = 0; i < newCount; ++i)
+		newEnv.GetPoint(i, &newPoints[i].position, &newPoints[i].value, &newPoints[i].shape, &newPoints[i].bezier);
+
+	int first = 0;
+	while (first < oldCount && first < newCount && oldPoints[first] == newPoints[first])
+		++first;
+	if (first == oldCount && first == newCount)
+		return;
+
+	int oldLast = oldCount, newLast = newCount;
+	while (oldLast > first && newLast > first && oldPoints[oldLast - 1] == newPoints[newLast - 1])
+	{
+		--oldLast;
+		--newLast;
+	}
+
+	double rangeStart = -HUGE_VAL, rangeEnd = HUGE_VAL;
+	if (first > 0)
+		rangeStart = oldPoints[first - 1].position;
+	if (oldLast < oldCount)
+		rangeEnd = oldPoints[oldLast].position;
+	AddDirtyRange(start, end, rangeStart - offset, rangeEnd - offset);
+}
+
+static bool BlocksMatch (const double* blocks1, const double* blocks2, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		if (fabs(blocks1[i] - blocks2[i]) > std::max(blocks1[i], blocks2[i]) * REANALYZE_TOLERANCE)
+			return false;
+	}
+	return true;
+}
+
+static size_t GetWarmupCount (double runStart, double firstEnd, double window, double interval)
+{
+	// Values measured by incremental analysis are valid once their window starts after filter warm-up (value i ends at firstEnd + i * interval),
+	// unless analysis started at the beginning of the audio like the full one does
+	if (runStart <= 0)
+		return 0;
+	const double count = ceil((REANALYZE_WARMUP + window - firstEnd) / interval - 0.001);
+	return (count > 0) ? (size_t)count : 0;
+}
+
+static void SpliceValues (vector<double>& values, const double* newValues, size_t newCount, size_t offset, size_t skip, double fill, bool toEnd)
+{
+	// Replaces values from offset + skip with newValues from skip on, toEnd means new values reached the end of the audio
+	if (skip >= newCount)
+		return;
+	if (values.size() < offset + newCount || toEnd)
+		values.resize(offset + newCount, fill);
+	std::copy(newValues + skip, newValues + newCount, values.begin() + offset + skip);
+}
+
+// Decodes audio accessor in big blocks on its own thread while analysis thread takes it in small slices
+class AudioReadAhead
+{
+public:
+	AudioReadAhead (AudioAccessor* audio, int samplerate, int channels, double audioStart, double audioEnd, double readEnd, int startFrame, int blockFrames) :
+	m_audio       (audio),
+	m_samplerate  (samplerate),
+	m_channels    (channels),
+	m_audioStart  (audioStart),
+	m_audioEnd    (audioEnd),
+	m_blockFrames (blockFrames),
+	m_readFrame   (startFrame),
+	m_endFrame    ((int)ceil((readEnd - audioStart) * samplerate)),
+	m_readBlock   (0),
+	m_readPos     (0),
+	m_filled      (0),
+	m_done        (false),
+	m_stop        (false)
+	{
+		for (int i = 0; i < READ_AHEAD_BLOCKS; ++i)
+		{
+			m_blocks[i].resize(blockFrames * channels);
+			m_blockSize[i] = 0;
+		}
+		m_thread = std::thread(&AudioReadAhead::Decode, this);
+	}
+
+	~AudioReadAhead ()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+		m_freed.notify_one();
+		m_thread.join();
+	}
+
+	// Same as GetAudioAccessorSamples() on the next frames, returns false past the decoded audio
+	bool Read (double* samples, int frames)
+	{
+		while (frames > 0)
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_decoded.wait(lock, [this] { return m_filled > 0 || m_done; });
+			if (!m_filled)
+			{
+				std::fill(samples, samples + frames * m_channels, 0.0);
+				return false;
+			}
+			lock.unlock();
+
+			const int count = std::min(frames, m_blockSize[m_readBlock] - m_readPos);
+			const double* block = &m_blocks[m_readBlock][0] + m_readPos * m_channels;
+			std::copy(block, block + count * m_channels, samples);
+			samples   += count * m_channels;
+			frames    -= count;
+			m_readPos += count;
+
+			if (m_readPos == m_blockSize[m_readBlock])
+			{
+				m_readBlock = (m_readBlock + 1) % READ_AHEAD_BLOCKS;
+				m_readPos   = 0;
+				lock.lock();
+				--m_filled;
+				lock.unlock();
+				m_freed.notify_one();
+			}
+		}
+		return true;
+	}
+
+private:
+	void Decode ()
+	{
+		int writeBlock = 0;
+		while (m_readFrame < m_endFrame)
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_freed.wait(lock, [this] { return m_filled < READ_AHEAD_BLOCKS || m_stop; });
+				if (m_stop)
+					break;
+			}
+
+			// Same timing as when reading frames one by one (see AnalyzeData())
+			const double time = m_audioStart + (double)m_readFrame / (double)m_samplerate;
+			const int frames = std::min(m_blockFrames, m_endFrame - m_readFrame);
+			double* samples = &m_blocks[writeBlock][0];
+
+			// GetAudioAccessorSamples() stops writing to the buffer once it reaches the item's end, make sure audio past it (see AnalyzeData()) is silent
+			if (time + (double)frames / (double)m_samplerate > m_audioEnd)
+				std::fill(samples, samples + frames * m_channels, 0.0);
+			GetAudioAccessorSamples(m_audio, m_samplerate, m_channels, time, frames, samples);
+			m_blockSize[writeBlock] = frames;
+			m_readFrame += frames;
+			writeBlock = (writeBlock + 1) % READ_AHEAD_BLOCKS;
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				++m_filled;
+			}
+			m_decoded.notify_one();
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_done = true;
+		}
+		m_decoded.notify_one();
+	}
+
+	AudioAccessor* m_audio;
+	int m_samplerate, m_channels;
+	double m_audioStart, m_audioEnd;
+	int m_blockFrames, m_readFrame, m_endFrame;
+	vector<double> m_blocks[READ_AHEAD_BLOCKS];
+	int m_blockSize[READ_AHEAD_BLOCKS];
+	int m_readBlock, m_readPos, m_filled;
+	bool m_done, m_stop;
+	std::mutex m_mutex;
+	std::condition_variable m_decoded, m_freed;
+	std::thread m_thread;
+};
+
 BR_LoudnessObject::BR_LoudnessObject () :
 m_track               (NULL),
 m_take                (NULL),
@@ -203,7 +422,8 @@ m_doTruePeak          (true),
 m_truePeakAnalyzed    (false),
 m_process             (NULL),
 m_doHighPrecisionMode (true),
-m_doDualMonoMode      (true)
+m_doDualMonoMode      (true),
+m_revision            (SWS_ListView::NewItemRevision())
 {
 }
 
@@ -226,7 +446,8 @@ m_doTruePeak          (true),
 m_truePeakAnalyzed    (false),
 m_process             (NULL),
 m_doHighPrecisionMode (true),
-m_doDualMonoMode      (true)
+m_doDualMonoMode      (true),
+m_revision            (SWS_ListView::NewItemRevision())
 {
 	this->CheckSetAudioData();
 }
@@ -250,7 +471,8 @@ m_doTruePeak          (true),
 m_truePeakAnalyzed    (false),
 m_process             (NULL),
 m_doHighPrecisionMode (true),
-m_doDualMonoMode      (true)
+m_doDualMonoMode      (true),
+m_revision            (SWS_ListView::NewItemRevision())
 {
 	this->CheckSetAudioData();
 }
@@ -279,9 +501,18 @@ bool BR_LoudnessObject::Analyze (bool integratedOnly, bool doTruePeak, bool doHi
 
 		if (!analyzed)
 		{
-			this->SetRunning(true);
-			this->SetProgress(0);
-			this->SetProcess((HANDLE)_beginthreadex(NULL, 0, this->AnalyzeData, (void*)this, 0, NULL));
+			if (this->RestoreFromCache())
+			{
+				this->SetRunning(false);
+				this->SetProgress(1);
+			}
+			else
+			{
+				this->SetRunning(true);
+				this->SetProgress(0);
+				this->PlanReanalysis();
+				this->SetProcess((HANDLE)_beginthreadex(NULL, 0, this->AnalyzeData, (void*)this, 0, NULL));
+			}
 		}
 		return true;
 	}
@@ -295,6 +526,24 @@ bool BR_LoudnessObject::Analyze (bool integratedOnly, bool doTruePeak, bool doHi
 	}
 }
 
+bool BR_LoudnessObject::LoadCachedAnalysis (bool integratedOnly, bool doTruePeak, bool doHighPrecisionMode, bool doDualMonoMode)
+{
+	this->AbortAnalyze();
+	this->SetIntegratedOnly(integratedOnly);
+	this->SetDoTruePeak(doTruePeak);
+	this->SetDoHighPrecisionMode(doHighPrecisionMode);
+	this->SetDoDualMonoMode(doDualMonoMode);
+
+	if (!this->CheckSetAudioData())
+		return false;
+
+	bool analyzed = this->GetAnalyzedStatus();
+	if (analyzed && doTruePeak && !this->GetTruePeakAnalyzeStatus())
+		analyzed = false;
+
+	return analyzed || this->RestoreFromCache();
+}
+
 void BR_LoudnessObject::AbortAnalyze ()
 {
 	if (this->GetProcess())
@@ -425,6 +674,12 @@ void BR_LoudnessObject::GetColumnStr (int column, char* str, int strSz, int mode
 	}
 }
 
+int BR_LoudnessObject::GetRevision ()
+{
+	SWS_SectionLock lock(&m_mutex);
+	return m_revision;
+}
+
 void BR_LoudnessObject::SaveObject (ProjectStateContext* ctx)
 {
 	if (this->CheckSetAudioData())
@@ -502,7 +757,7 @@ bool BR_LoudnessObject::RestoreObject (ProjectStateContext* ctx)
 
 			this->SetGuid(guid);
 			if (lp.gettoken_int(1) == 1) this->SetTrack(GuidToTrack(&guid));
-			else                         this->SetTake(GetMediaItemTakeByGUID(NULL, &guid));
+			else                         this->SetTake(GuidToTake(NULL, &guid));
 		}
 		else if (!strcmp(lp.gettoken_str(0), PROJ_OBJECT_KEY_MEASUREMENTS))
 		{
@@ -718,7 +973,7 @@ bool BR_LoudnessObject::IsTargetValid ()
 			
 		else
 		{
-			if (MediaItem_Take* newTake = GetMediaItemTakeByGUID(NULL, &guid))
+			if (MediaItem_Take* newTake = GuidToTake(NULL, &guid))
 			{
 				if (GuidsEqual(&guid, (GUID*)GetSetMediaItemTakeInfo(newTake, "GUID", NULL)))
 				{
@@ -1019,6 +1274,20 @@ unsigned WINAPI BR_LoudnessObject::AnalyzeData (void* loudnessObject)
 	// Get take/track info
 	BR_LoudnessObject* _this = (BR_LoudnessObject*)loudnessObject;
 	BR_LoudnessObject::AudioData data = _this->GetAudioData();
+	const BR_LoudnessObject::AudioData measuredData = data;
+
+	// Edited audio only needs to be measured from the edit on (until new blocks match old ones again)
+	const BR_LoudnessObject::Reanalysis reanalysis = _this->GetReanalysis();
+	BR_LoudnessObject::BlockData oldData;
+	double oldTruePeak = NEGATIVE_INF, oldTruePeakPos = -1;
+	vector<double> oldMomentaryValues, oldShortTermValues;
+	if (reanalysis.incremental)
+	{
+		SWS_SectionLock lock(&_this->m_mutex);
+		oldData = _this->GetBlockData();
+		_this->GetAnalyzeData(NULL, NULL, &oldTruePeak, &oldTruePeakPos, NULL, NULL, &oldShortTermValues, &oldMomentaryValues);
+	}
+	const bool incremental = reanalysis.incremental && !oldData.blocks.empty();
 
 	const bool doPan               = data.channels > 1              && data.pan != 0; // tracks will always get false here (see CheckSetAudioData())
 	const bool doVolEnv            = data.volEnv.CountPoints()      && data.volEnv.IsActive();
@@ -1028,6 +1297,11 @@ unsigned WINAPI BR_LoudnessObject::AnalyzeData (void* loudnessObject)
 	const bool doHighPrecisionMode = _this->GetDoHighPrecisionMode() && !integratedOnly;
 	const bool doDualMonoMode      = _this->GetDoDualMonoMode();
 
+	// Get cache key before audio data gets modified below. Incremental results are spliced with old ones that only match within
+	// REANALYZE_TOLERANCE, keep them out of the persistent cache which is served as exact analysis of the audio
+	unsigned char cacheKey[BR_LoudnessCache::KEY_SIZE];
+	const bool doCache = !incremental && g_pref.GetCacheSize() > 0 && BR_LoudnessObject::GetCacheKey(data, integratedOnly, doHighPrecisionMode, doDualMonoMode, cacheKey);
+
 	/*
 	NF: fix for wrong results when analyzing item, item is not at pos 0.0 and contains take vol. env.
 	https://github.com/reaper-oss/sws/issues/957#issuecomment-371233030
@@ -1040,7 +1314,7 @@ unsigned WINAPI BR_LoudnessObject::AnalyzeData (void* loudnessObject)
 
 	// Prepare ebur123_state
 	ebur128_state* loudnessState = NULL;
-	int mode = integratedOnly ? EBUR128_MODE_I : EBUR128_MODE_M | EBUR128_MODE_S | EBUR128_MODE_I | EBUR128_MODE_LRA;
+	int mode = integratedOnly ? EBUR128_MODE_I : EBUR128_MODE_M | EBUR128_MODE_S | EBUR128_MODE_I | EBUR128_MODE_LRA | EBUR128_MODE_BLOCK_LOG;
 	if (!integratedOnly && doTruePeak)
 		mode |= EBUR128_MODE_TRUE_PEAK;
 	loudnessState = ebur128_init((size_t)data.channels, (size_t)data.samplerate, mode);
@@ -1115,10 +1389,40 @@ unsigned WINAPI BR_LoudnessObject::AnalyzeData (void* loudnessObject)
 	const double audioLength = data.audioEnd - data.audioStart;
 
 	int sampleCount = data.samplerate / refreshRateInHz;
-	int bufSz = sampleCount * data.channels;
-	double currentTime = data.audioStart;
+
+	// Incremental analysis restarts at the beginning of momentary/short-term interval cycle (see PlanReanalysis())
+	const int startBuffer = incremental ? (int)(reanalysis.start / bufferTime + 0.5) : 0;
+	const double runStart = startBuffer * bufferTime;
+	const double runLength = incremental ? std::min(reanalysis.end + 3 + REANALYZE_WARMUP + REANALYZE_CONVERGE_BLOCKS * 0.1, audioLength) - runStart : audioLength;
+	const size_t blockOffset = (size_t)(runStart * 10 + 0.5);
+	bool converged = false;
+
+	double currentTime = data.audioStart + runStart;
+
+	// Decoding runs ahead on its own thread in blocks of whole buffers, so samples stay the same as when reading buffer by buffer
+	const int blockBuffers = std::max((int)(READ_AHEAD_BLOCK_TIME / bufferTime), 1);
+	AudioReadAhead reader(data.audio, data.samplerate, data.channels, data.audioStart, effectiveEndTime, data.audioEnd, startBuffer * sampleCount, blockBuffers * sampleCount);
+
+	// Buffers are reused for the whole analysis, gain curve is rendered per frame and shared by all channels
+	vector<double> samples(sampleCount * data.channels);
+	vector<double> frameGain((doVolEnv || doVolPreFXEnv) ? sampleCount : 0);
+	vector<double> envGain((doVolEnv && doVolPreFXEnv) ? sampleCount : 0);
+
+	// Volume and pan faders don't change during analysis so get per channel gain only once
+	vector<double> channelGain(data.channels, data.volume);
+	if (doPan)
+	{
+		for (int channel = 0; channel < data.channels; ++channel)
+		{
+			if (data.pan > 0 && channel % 2 == 0)
+				channelGain[channel] *= 1 - data.pan; // takes have no pan law!
+			else if (data.pan < 0 && channel % 2 == 1)
+				channelGain[channel] *= 1 + data.pan;
+		}
+	}
+
 	bool momentaryFilled = true;
-	int processedSamples = 0;
+	int processedSamples = startBuffer * sampleCount;
 	int i = 0;
 
 	while (currentTime < data.audioEnd && !_this->GetKillFlag())
@@ -1128,49 +1432,42 @@ unsigned WINAPI BR_LoudnessObject::AnalyzeData (void* loudnessObject)
 		const double remainingTime = data.audioEnd - currentTime; // how many seconds until the end of the audio source
 		if (remainingTime < bufferTime + numeric_limits<double>::epsilon())
 		{
-			sampleCount = static_cast<int>(data.samplerate * remainingTime);
-			bufSz = sampleCount * data.channels;
+			sampleCount = std::min(static_cast<int>(data.samplerate * remainingTime), sampleCount); // never past the reused buffers
 			skipIntervals = true;
 		}
 
 		// Get new 200 ms (or 10 ms in high precision mode) of samples
-		// GetAudioAccessorSamples() stops writing to the buffer once it reaches the item's end, everything from that point to sampleCount is garbage
-		std::vector<double> samples(bufSz);
-		GetAudioAccessorSamples(data.audio, data.samplerate, data.channels, currentTime, sampleCount, &samples[0]);
+		reader.Read(&samples[0], sampleCount);
 
 		// Correct for volume and pan/volume envelopes
-		int currentChannel = 1;
-		double sampleTime = currentTime;
-
-		for (double &sample : samples)
+		if (doVolEnv || doVolPreFXEnv)
 		{
-			double adjust = 1;
-
-			// Volume envelopes
 			if (doVolPreFXEnv)
-				adjust *= data.volEnvPreFX.ValueAtPosition(sampleTime, true);
-			if (doVolEnv) 
-				adjust *= data.volEnv.ValueAtPosition(sampleTime + itemPos, true);
-
-			// Volume fader
-			adjust *= data.volume;
-
-			// Pan fader (takes only)
-			if (doPan)
+				data.volEnvPreFX.ValuesAtPositions(currentTime, sampleTimeLen, sampleCount, &frameGain[0]);
+			if (doVolEnv)
+				data.volEnv.ValuesAtPositions(currentTime + itemPos, sampleTimeLen, sampleCount, doVolPreFXEnv ? &envGain[0] : &frameGain[0]);
+			if (doVolEnv && doVolPreFXEnv)
 			{
-				if (data.pan > 0 && (currentChannel % 2 == 1))
-					adjust *= 1 - data.pan; // takes have no pan law!
-				else if (data.pan < 0 && (currentChannel % 2 == 0))
-					adjust *= 1 + data.pan;
+				for (int frame = 0; frame < sampleCount; ++frame)
+					frameGain[frame] *= envGain[frame];
 			}
 
-			sample *= adjust;
-
-			if (++currentChannel > data.channels)
-				currentChannel = 1;
-
-			if (currentChannel + 1 > data.channels)
-				sampleTime = sampleTime + sampleTimeLen;
+			double* sample = &samples[0];
+			for (int frame = 0; frame < sampleCount; ++frame, sample += data.channels)
+			{
+				const double gain = frameGain[frame];
+				for (int channel = 0; channel < data.channels; ++channel)
+					sample[channel] *= gain * channelGain[channel];
+			}
+		}
+		else
+		{
+			double* sample = &samples[0];
+			for (int frame = 0; frame < sampleCount; ++frame, sample += data.channels)
+			{
+				for (int channel = 0; channel < data.channels; ++channel)
+					sample[channel] *= channelGain[channel];
+			}
 		}
 
 		ebur128_add_frames_double(loudnessState, &samples[0], sampleCount);
@@ -1212,8 +1509,8 @@ unsigned WINAPI BR_LoudnessObject::AnalyzeData (void* loudnessObject)
 		processedSamples += sampleCount;
 		currentTime = data.audioStart + ((double)processedSamples / (double)data.samplerate);
 
-		_this->SetProgress ((currentTime - data.audioStart) / audioLength * 0.95); // loudness_global and loudness_range seem rather fast and since we currently
-		if (++i == 15)                                                             // can't monitor their progress, leave last 10% of progress for them
+		_this->SetProgress (std::min((currentTime - data.audioStart - runStart) / runLength, 1.0) * 0.95); // loudness_global and loudness_range seem rather fast and since we currently
+		if (++i == 15)                                                                                       // can't monitor their progress, leave last 10% of progress for them
 		{
 			i = 0;
 			momentaryFilled = !momentaryFilled;
@@ -1222,15 +1519,61 @@ unsigned WINAPI BR_LoudnessObject::AnalyzeData (void* loudnessObject)
 		// We reached the end of the file, break without checking currentTime against endTime (rounding errors could make us go through loop one more time)
 		if (skipIntervals)
 			break;
+
+		// Past edited range and all the windows overlapping it, once new gating blocks match old ones rest of the old analysis is still valid
+		if (incremental && currentTime - data.audioStart >= reanalysis.end + 3 + REANALYZE_WARMUP)
+		{
+			const double* blocks;
+			size_t blocksSize;
+			ebur128_block_log(loudnessState, &blocks, &blocksSize, NULL, NULL);
+			if (blocksSize >= REANALYZE_CONVERGE_BLOCKS && blockOffset + blocksSize <= oldData.blocks.size())
+			{
+				const size_t first = blocksSize - REANALYZE_CONVERGE_BLOCKS;
+				if (BlocksMatch(blocks + first, &oldData.blocks[blockOffset + first], REANALYZE_CONVERGE_BLOCKS))
+				{
+					converged = true;
+					break;
+				}
+			}
+		}
 	}
 
 	// Get integrated and loudness range
+	BR_LoudnessObject::BlockData blockData;
 	if (!_this->GetKillFlag())
 	{
-		ebur128_loudness_global(loudnessState, &integrated);
 		if (!integratedOnly)
 		{
-			ebur128_loudness_range(loudnessState, &range);
+			const double* blocks;
+			const double* shortTermBlocks;
+			size_t blocksSize, shortTermBlocksSize;
+			ebur128_block_log(loudnessState, &blocks, &blocksSize, &shortTermBlocks, &shortTermBlocksSize);
+
+			// Replace old blocks and values from the point filters settled to where new ones started matching them (or to the end)
+			if (incremental)
+			{
+				blockData.blocks          = oldData.blocks;
+				blockData.shortTermBlocks = oldData.shortTermBlocks;
+				SpliceValues(blockData.blocks, blocks, blocksSize, blockOffset, GetWarmupCount(runStart, 0.4, 0.4, 0.1), 0, !converged);
+				SpliceValues(blockData.shortTermBlocks, shortTermBlocks, shortTermBlocksSize, (size_t)(runStart + 0.5), GetWarmupCount(runStart, 3, 3, 1), 0, !converged);
+				SpliceValues(oldMomentaryValues, momentaryValues.data(), momentaryValues.size(), startBuffer / 2, GetWarmupCount(runStart, 2 * bufferTime, 0.4, 2 * bufferTime), NEGATIVE_INF, !converged);
+				SpliceValues(oldShortTermValues, shortTermValues.data(), shortTermValues.size(), startBuffer / 15, GetWarmupCount(runStart, 15 * bufferTime, 3, 15 * bufferTime), NEGATIVE_INF, !converged);
+				momentaryValues.swap(oldMomentaryValues);
+				shortTermValues.swap(oldShortTermValues);
+
+				momentaryMax = (momentaryValues.empty()) ? NEGATIVE_INF : *std::max_element(momentaryValues.begin(), momentaryValues.end());
+				shortTermMax = (shortTermValues.empty()) ? NEGATIVE_INF : *std::max_element(shortTermValues.begin(), shortTermValues.end());
+				ebur128_loudness_global_blocks(blockData.blocks.data(), blockData.blocks.size(), &integrated);
+				ebur128_loudness_range_blocks(blockData.shortTermBlocks.data(), blockData.shortTermBlocks.size(), &range);
+			}
+			else
+			{
+				blockData.blocks.assign(blocks, blocks + blocksSize);
+				blockData.shortTermBlocks.assign(shortTermBlocks, shortTermBlocks + shortTermBlocksSize);
+				ebur128_loudness_global(loudnessState, &integrated);
+				ebur128_loudness_range(loudnessState, &range);
+			}
+
 			if (doTruePeak)
 			{
 				for (int i = 0; i < data.channels; ++i)
@@ -1240,14 +1583,23 @@ unsigned WINAPI BR_LoudnessObject::AnalyzeData (void* loudnessObject)
 					if (channelTruePeak > truePeak)
 					{
 						truePeak    = channelTruePeak;
-						truePeakPos = channelTruePeakPos;
+						truePeakPos = channelTruePeakPos + runStart;
 					}
 				}
 				truePeak = VAL2DB(truePeak);
+
+				// PlanReanalysis() made sure old true peak is not within edited audio
+				if (incremental && oldTruePeak > truePeak)
+				{
+					truePeak    = oldTruePeak;
+					truePeakPos = oldTruePeakPos;
+				}
 				_this->SetTruePeakAnalyzed(true);
 			}
 
 		}
+		else
+			ebur128_loudness_global(loudnessState, &integrated);
 	}
 	ebur128_destroy(&loudnessState);
 
@@ -1255,6 +1607,32 @@ unsigned WINAPI BR_LoudnessObject::AnalyzeData (void* loudnessObject)
 	if (!_this->GetKillFlag())
 	{
 		_this->SetAnalyzeData(integrated, range, truePeak, truePeakPos, shortTermMax, momentaryMax, shortTermValues, momentaryValues);
+		if (!integratedOnly)
+		{
+			blockData.audioData           = measuredData;
+			blockData.timeline            = reanalysis.timeline;
+			blockData.doHighPrecisionMode = doHighPrecisionMode;
+			blockData.doDualMonoMode      = doDualMonoMode;
+			blockData.truePeakAnalyzed    = doTruePeak;
+			_this->SetBlockData(blockData);
+		}
+
+		if (doCache)
+		{
+			BR_LoudnessCache::Result result;
+			result.integrated       = integrated;
+			result.range            = range;
+			result.truePeak         = truePeak;
+			result.truePeakPos      = truePeakPos;
+			result.shortTermMax     = shortTermMax;
+			result.momentaryMax     = momentaryMax;
+			result.shortTermValues  = shortTermValues;
+			result.momentaryValues  = momentaryValues;
+			result.integratedOnly   = integratedOnly;
+			result.truePeakAnalyzed = !integratedOnly && doTruePeak;
+			BR_LoudnessCache::Get().Store(cacheKey, result);
+		}
+
 		_this->SetProgress(1);
 		_this->SetRunning(false);
 		if (!integratedOnly)
@@ -1264,6 +1642,71 @@ unsigned WINAPI BR_LoudnessObject::AnalyzeData (void* loudnessObject)
 	return 0;
 }
 
+bool BR_LoudnessObject::GetCacheKey (BR_LoudnessObject::AudioData& data, bool integratedOnly, bool doHighPrecisionMode, bool doDualMonoMode, unsigned char* key)
+{
+	if (!data.audio || !data.audioHash[0])
+		return false;
+
+	// Everything that changes samples fed to ebur128 (or the way they get measured) goes into the key
+	const int version = CACHE_VERSION;
+	const char modes[2] = {doHighPrecisionMode && !integratedOnly, doDualMonoMode};
+
+	WDL_SHA1 sha;
+	sha.add(&version, sizeof(version));
+	sha.add(data.audioHash, (int)strlen(data.audioHash));
+	sha.add(&data.samplerate, sizeof(data.samplerate));
+	sha.add(&data.channels, sizeof(data.channels));
+	sha.add(&data.channelMode, sizeof(data.channelMode));
+	sha.add(&data.audioStart, sizeof(data.audioStart));
+	sha.add(&data.audioEnd, sizeof(data.audioEnd));
+	sha.add(&data.volume, sizeof(data.volume));
+	sha.add(&data.pan, sizeof(data.pan));
+	sha.add(modes, sizeof(modes));
+
+	BR_Envelope* envelopes[] = {&data.volEnv, &data.volEnvPreFX};
+	for (int i = 0; i < (int)(sizeof(envelopes) / sizeof(envelopes[0])); ++i)
+	{
+		// Same as in AnalyzeData(), points of inactive envelope don't matter
+		const int count = (envelopes[i]->IsActive()) ? envelopes[i]->CountPoints() : 0;
+		sha.add(&count, sizeof(count));
+		for (int j = 0; j < count; ++j)
+		{
+			double position, value, bezier;
+			int shape;
+			envelopes[i]->GetPoint(j, &position, &value, &shape, &bezier);
+			sha.add(&position, sizeof(position));
+			sha.add(&value, sizeof(value));
+			sha.add(&shape, sizeof(shape));
+			sha.add(&bezier, sizeof(bezier));
+		}
+	}
+
+	sha.result(key);
+	return true;
+}
+
+bool BR_LoudnessObject::RestoreFromCache ()
+{
+	if (g_pref.GetCacheSize() <= 0)
+		return false;
+
+	BR_LoudnessObject::AudioData data = this->GetAudioData();
+	const bool integratedOnly = this->GetIntegratedOnly();
+
+	unsigned char key[BR_LoudnessCache::KEY_SIZE];
+	BR_LoudnessCache::Result result;
+	if (!BR_LoudnessObject::GetCacheKey(data, integratedOnly, this->GetDoHighPrecisionMode(), this->GetDoDualMonoMode(), key) ||
+	    !BR_LoudnessCache::Get().Load(key, integratedOnly, this->GetDoTruePeak(), &result)
+	)
+		return false;
+
+	this->SetAnalyzeData(result.integrated, result.range, result.truePeak, result.truePeakPos, result.shortTermMax, result.momentaryMax, result.shortTermValues, result.momentaryValues);
+	this->SetTruePeakAnalyzed(result.truePeakAnalyzed);
+	if (!result.integratedOnly)
+		this->SetAnalyzedStatus(true);
+	return true;
+}
+
 int BR_LoudnessObject::CheckSetAudioData ()
 {
 	SWS_SectionLock lock(&m_mutex);
@@ -1327,6 +1770,7 @@ int BR_LoudnessObject::CheckSetAudioData ()
 		audioData.volEnvPreFX  = volEnvPreFX;
 
 		this->SetAudioData(audioData);
+		m_timeline = (this->GetIntegratedOnly()) ? (BR_LoudnessObject::Timeline()) : (this->GetCurrentTimeline());
 
 		this->SetAnalyzedStatus(false);
 		this->SetTruePeakAnalyzed(false);
@@ -1371,6 +1815,304 @@ void BR_LoudnessObject::SetAnalyzeData (double integrated, double range, double
 	m_momentaryMax    = momentaryMax;
 	m_shortTermValues = shortTermValues;
 	m_momentaryValues = momentaryValues;
+	m_blockData       = BR_LoudnessObject::BlockData();
+	m_revision        = SWS_ListView::NewItemRevision();
+}
+
+void BR_LoudnessObject::SetBlockData (const BR_LoudnessObject::BlockData& blockData)
+{
+	SWS_SectionLock lock(&m_mutex);
+	m_blockData = blockData;
+}
+
+BR_LoudnessObject::BlockData BR_LoudnessObject::GetBlockData ()
+{
+	SWS_SectionLock lock(&m_mutex);
+	return m_blockData;
+}
+
+// Cheap stand-ins for object states: values that change audio read through the API, no state chunks (GetCurrentTimeline() runs after every
+// audio edit). Anything not covered here (i.e. envelope bypass) can only go unnoticed when it comes together with item edits (see PlanReanalysis())
+static void AddValueToHash (WDL_SHA1* sha, double value)
+{
+	sha->add(&value, sizeof(value));
+}
+
+static void AddEnvelopeToHash (WDL_SHA1* sha, TrackEnvelope* envelope)
+{
+	static const char* const s_autoItemParams[] = {"D_POSITION", "D_LENGTH", "D_STARTOFFS", "D_PLAYRATE", "D_BASELINE", "D_AMPLITUDE", "D_LOOPSRC"};
+
+	const int autoItemCount = CountAutomationItems(envelope);
+	AddValueToHash(sha, autoItemCount);
+	for (int autoItem = -1; autoItem < autoItemCount; ++autoItem)
+	{
+		if (autoItem >= 0)
+		{
+			for (size_t i = 0; i < sizeof(s_autoItemParams) / sizeof(s_autoItemParams[0]); ++i)
+				AddValueToHash(sha, GetSetAutomationItemInfo(envelope, autoItem, s_autoItemParams[i], 0, false));
+		}
+
+		const int pointCount = CountEnvelopePointsEx(envelope, autoItem);
+		AddValueToHash(sha, pointCount);
+		for (int i = 0; i < pointCount; ++i)
+		{
+			double time, value, tension;
+			int shape;
+			if (GetEnvelopePointEx(envelope, autoItem, i, &time, &value, &shape, &tension, NULL))
+			{
+				AddValueToHash(sha, time);
+				AddValueToHash(sha, value);
+				AddValueToHash(sha, tension);
+				AddValueToHash(sha, shape);
+			}
+		}
+	}
+}
+
+static void AddTrackToHash (WDL_SHA1* sha, MediaTrack* track)
+{
+	static const char* const s_trackParams[] = {"D_VOL", "D_PAN", "D_WIDTH", "D_DUALPANL", "D_DUALPANR", "I_PANMODE", "D_PANLAW", "B_MUTE", "B_PHASE", "I_NCHAN", "B_MAINSEND", "C_MAINSEND_OFFS"};
+
+	sha->add(&track, sizeof(track));
+	for (size_t i = 0; i < sizeof(s_trackParams) / sizeof(s_trackParams[0]); ++i)
+		AddValueToHash(sha, GetMediaTrackInfo_Value(track, s_trackParams[i]));
+
+	const int fxCount = TrackFX_GetCount(track);
+	AddValueToHash(sha, fxCount);
+	for (int fx = 0; fx < fxCount; ++fx)
+	{
+		if (GUID* guid = TrackFX_GetFXGUID(track, fx))
+			sha->add(guid, sizeof(GUID));
+		AddValueToHash(sha, TrackFX_GetEnabled(track, fx));
+		AddValueToHash(sha, TrackFX_GetOffline(track, fx));
+		for (int i = 0; i < TrackFX_GetNumParams(track, fx); ++i)
+		{
+			double minVal, maxVal;
+			AddValueToHash(sha, TrackFX_GetParam(track, fx, i, &minVal, &maxVal));
+		}
+	}
+
+	const int envelopeCount = CountTrackEnvelopes(track);
+	AddValueToHash(sha, envelopeCount);
+	for (int i = 0; i < envelopeCount; ++i)
+		AddEnvelopeToHash(sha, GetTrackEnvelope(track, i));
+}
+
+static double GetReceiveValue (MediaTrack* track, int receiveIdx, const char* param)
+{
+	const void* value = GetSetTrackSendInfo(track, -1, receiveIdx, param, NULL);
+	if (!value)
+		return 0;
+
+	switch (param[0])
+	{
+		case 'D': return *(const double*)value;
+		case 'B': return *(const bool*)value;
+		default:  return *(const int*)value;
+	}
+}
+
+static void AddItemToHash (WDL_SHA1* sha, MediaItem* item)
+{
+	static const char* const s_itemParams[] = {"D_POSITION", "D_LENGTH", "D_VOL", "B_MUTE", "D_FADEINLEN", "D_FADEOUTLEN", "D_FADEINLEN_AUTO", "D_FADEOUTLEN_AUTO", "D_FADEINDIR", "D_FADEOUTDIR", "C_FADEINSHAPE", "C_FADEOUTSHAPE", "B_LOOPSRC"};
+	static const char* const s_takeParams[] = {"D_STARTOFFS", "D_VOL", "D_PAN", "D_PANLAW", "D_PLAYRATE", "D_PITCH", "B_PPITCH", "I_CHANMODE"};
+
+	for (size_t i = 0; i < sizeof(s_itemParams) / sizeof(s_itemParams[0]); ++i)
+		AddValueToHash(sha, GetMediaItemInfo_Value(item, s_itemParams[i]));
+
+	// Source pointer changes when source gets replaced, so does take pointer when switching takes
+	MediaItem_Take* take = GetActiveTake(item);
+	PCM_source* source = (take) ? (GetMediaItemTake_Source(take)) : (NULL);
+	sha->add(&take, sizeof(take));
+	sha->add(&source, sizeof(source));
+	if (!take)
+		return;
+
+	for (size_t i = 0; i < sizeof(s_takeParams) / sizeof(s_takeParams[0]); ++i)
+		AddValueToHash(sha, GetMediaItemTakeInfo_Value(take, s_takeParams[i]));
+
+	const int fxCount = TakeFX_GetCount(take);
+	AddValueToHash(sha, fxCount);
+	for (int fx = 0; fx < fxCount; ++fx)
+	{
+		if (GUID* guid = TakeFX_GetFXGUID(take, fx))
+			sha->add(guid, sizeof(GUID));
+		AddValueToHash(sha, TakeFX_GetEnabled(take, fx));
+		AddValueToHash(sha, TakeFX_GetOffline(take, fx));
+		for (int i = 0; i < TakeFX_GetNumParams(take, fx); ++i)
+		{
+			double minVal, maxVal;
+			AddValueToHash(sha, TakeFX_GetParam(take, fx, i, &minVal, &maxVal));
+		}
+	}
+
+	const int envelopeCount = CountTakeEnvelopes(take);
+	AddValueToHash(sha, envelopeCount);
+	for (int i = 0; i < envelopeCount; ++i)
+		AddEnvelopeToHash(sha, GetTakeEnvelope(take, i));
+}
+
+BR_LoudnessObject::Timeline BR_LoudnessObject::GetCurrentTimeline ()
+{
+	// Nothing changed in the project since last time (i.e. only source file got replaced on disk)
+	const int stateCount = GetProjectStateChangeCount(NULL);
+	if (m_timeline.stateCount == stateCount && m_timeline.valid)
+		return m_timeline;
+
+	BR_LoudnessObject::Timeline timeline;
+	timeline.stateCount = stateCount;
+	if (MediaItem_Take* take = this->GetTake())
+	{
+		timeline.valid   = true;
+		timeline.itemPos = GetMediaItemInfo_Value(GetMediaItemTake_Item(take), "D_POSITION");
+	}
+	else if (MediaTrack* track = this->GetTrack())
+	{
+		// Accessor of folder track reads child tracks too so edits there couldn't be located
+		timeline.valid = (int)GetMediaTrackInfo_Value(track, "I_FOLDERDEPTH") != 1;
+		for (int i = 0; timeline.valid && i < CountTrackMediaItems(track); ++i)
+		{
+			MediaItem* item = GetTrackMediaItem(track, i);
+
+			BR_LoudnessObject::TimelineItem timelineItem;
+			timelineItem.guid  = *(GUID*)GetSetMediaItemInfo(item, "GUID", NULL);
+			timelineItem.start = GetMediaItemInfo_Value(item, "D_POSITION");
+			timelineItem.end   = timelineItem.start + GetMediaItemInfo_Value(item, "D_LENGTH");
+
+			WDL_SHA1 sha;
+			AddItemToHash(&sha, item);
+			sha.result(timelineItem.hash);
+			timeline.items.push_back(timelineItem);
+		}
+
+		std::sort(timeline.items.begin(), timeline.items.end(), [](const BR_LoudnessObject::TimelineItem& item1, const BR_LoudnessObject::TimelineItem& item2) {
+			return memcmp(&item1.guid, &item2.guid, sizeof(GUID)) < 0;
+		});
+
+		// Anything else that could change the audio: FX, envelopes etc. of the track, of tracks it receives from (and their sends) and of the master
+		if (timeline.valid)
+		{
+			static const char* const s_sendParams[] = {"D_VOL", "D_PAN", "D_PANLAW", "B_MUTE", "B_PHASE", "B_MONO", "I_SENDMODE", "I_SRCCHAN", "I_DSTCHAN"};
+
+			WDL_SHA1 sha;
+			AddTrackToHash(&sha, track);
+			for (int i = 0; i < GetTrackNumSends(track, -1); ++i)
+			{
+				if (MediaTrack* srcTrack = (MediaTrack*)GetSetTrackSendInfo(track, -1, i, "P_SRCTRACK", NULL))
+				{
+					AddTrackToHash(&sha, srcTrack);
+					for (size_t j = 0; j < sizeof(s_sendParams) / sizeof(s_sendParams[0]); ++j)
+						AddValueToHash(&sha, GetReceiveValue(track, i, s_sendParams[j]));
+				}
+			}
+			AddTrackToHash(&sha, GetMasterTrack(NULL));
+			sha.result(timeline.stateHash);
+		}
+	}
+	return timeline;
+}
+
+void BR_LoudnessObject::PlanReanalysis ()
+{
+	SWS_SectionLock lock(&m_mutex);
+	m_reanalysis = BR_LoudnessObject::Reanalysis();
+	m_reanalysis.timeline = m_timeline;
+
+	// Only complete analysis of the same audio settings can be patched
+	BR_LoudnessObject::BlockData& old = m_blockData;
+	BR_LoudnessObject::AudioData& data = m_audioData;
+	const double audioLength = data.audioEnd - data.audioStart;
+	if (old.blocks.empty()                                             ||
+	    m_integratedOnly                                               ||
+	    !m_timeline.valid || !old.timeline.valid                       ||
+	    old.doHighPrecisionMode != m_doHighPrecisionMode               ||
+	    old.doDualMonoMode      != m_doDualMonoMode                    ||
+	    (m_doTruePeak && !old.truePeakAnalyzed)                        ||
+	    old.audioData.audioStart  != data.audioStart                   ||
+	    old.audioData.audioEnd    != data.audioEnd                     ||
+	    old.audioData.channels    != data.channels                     ||
+	    old.audioData.channelMode != data.channelMode                  ||
+	    old.audioData.samplerate  != data.samplerate                   ||
+	    data.samplerate % 100 != 0                                     || // buffers need to hold exact number of 100 ms blocks
+	    fabs(old.audioData.volume - data.volume) >= VOLUME_DELTA       ||
+	    fabs(old.audioData.pan    - data.pan)    >= PAN_DELTA          ||
+	    old.timeline.itemPos != m_timeline.itemPos                     ||
+	    audioLength < 3
+	)
+		return;
+
+	// Find edited range in accessor time
+	double start = HUGE_VAL, end = -HUGE_VAL;
+	AddEnvelopeDirtyRange(old.audioData.volEnv,      data.volEnv,      m_timeline.itemPos, &start, &end);
+	AddEnvelopeDirtyRange(old.audioData.volEnvPreFX, data.volEnvPreFX, m_timeline.itemPos, &start, &end);
+	if (strcmp(old.audioData.audioHash, data.audioHash))
+	{
+		// Only track audio can be located through items (anything else could be changed in a take)
+		if (this->GetTake())
+			return;
+
+		const vector<BR_LoudnessObject::TimelineItem>& oldItems = old.timeline.items;
+		const vector<BR_LoudnessObject::TimelineItem>& newItems = m_timeline.items;
+		size_t i = 0, j = 0;
+		bool itemsChanged = false;
+		while (i < oldItems.size() || j < newItems.size())
+		{
+			const int cmp = (i == oldItems.size()) ? 1 : (j == newItems.size()) ? -1 : memcmp(&oldItems[i].guid, &newItems[j].guid, sizeof(GUID));
+			if (cmp < 0)
+			{
+				AddDirtyRange(&start, &end, oldItems[i].start, oldItems[i].end);
+				itemsChanged = true;
+				++i;
+			}
+			else if (cmp > 0)
+			{
+				AddDirtyRange(&start, &end, newItems[j].start, newItems[j].end);
+				itemsChanged = true;
+				++j;
+			}
+			else
+			{
+				if (oldItems[i].start != newItems[j].start || oldItems[i].end != newItems[j].end || memcmp(oldItems[i].hash, newItems[j].hash, sizeof(oldItems[i].hash)))
+				{
+					AddDirtyRange(&start, &end, oldItems[i].start, oldItems[i].end);
+					AddDirtyRange(&start, &end, newItems[j].start, newItems[j].end);
+					itemsChanged = true;
+				}
+				++i;
+				++j;
+			}
+		}
+
+		// Audio changed but not (only) because of items, i.e. source file got replaced or track FX changed
+		if (!itemsChanged || memcmp(old.timeline.stateHash, m_timeline.stateHash, sizeof(m_timeline.stateHash)))
+			return;
+	}
+	if (start > end)
+		return;
+
+	start = std::max(start - data.audioStart, 0.0);
+	end   = std::min(end   - data.audioStart, audioLength);
+
+	// True peak of edited audio can't be found in old results
+	if (m_doTruePeak && m_truePeakPos >= start - REANALYZE_WARMUP && m_truePeakPos <= end + REANALYZE_WARMUP)
+		return;
+
+	// Start at the beginning of momentary/short-term interval cycle (30 buffers) that is also a whole second (short-term blocks),
+	// early enough for all values overlapping edited range to get measured again
+	const double period = m_doHighPrecisionMode ? 3 : 6;
+	const double restart = std::max(floor((start - 3 - REANALYZE_WARMUP) / period) * period, 0.0);
+	if (std::min(end + 3 + REANALYZE_WARMUP + REANALYZE_CONVERGE_BLOCKS * 0.1, audioLength) - restart > audioLength * REANALYZE_MAX_PART)
+		return;
+
+	m_reanalysis.incremental = true;
+	m_reanalysis.start       = restart;
+	m_reanalysis.end         = end;
+}
+
+BR_LoudnessObject::Reanalysis BR_LoudnessObject::GetReanalysis ()
+{
+	SWS_SectionLock lock(&m_mutex);
+	return m_reanalysis;
 }
 
 void BR_LoudnessObject::GetAnalyzeData (double* integrated, double* range, double* truePeak, double* truePeakPos, double* shortTermMax, double* momentaryMax, vector<double>* shortTermValues, vector<double>* momentaryValues)
@@ -1459,135 +2201,596 @@ bool BR_LoudnessObject::GetTruePeakAnalyzeStatus ()
 	return m_truePeakAnalyzed;
 }
 
-void BR_LoudnessObject::SetKillFlag (bool killFlag)
+void BR_LoudnessObject::SetKillFlag (bool killFlag)
+{
+	SWS_SectionLock lock(&m_mutex);
+	m_killFlag = killFlag;
+}
+
+bool BR_LoudnessObject::GetKillFlag ()
+{
+	SWS_SectionLock lock(&m_mutex);
+	return m_killFlag;
+}
+
+void BR_LoudnessObject::SetProcess (HANDLE process)
+{
+	SWS_SectionLock lock(&m_mutex);
+	m_process = process;
+}
+
+HANDLE BR_LoudnessObject::GetProcess ()
+{
+	SWS_SectionLock lock(&m_mutex);
+	return m_process;
+}
+
+WDL_FastString BR_LoudnessObject::GetTakeName ()
+{
+	SWS_SectionLock lock(&m_mutex);
+
+	WDL_FastString takeName;
+	if (m_track)
+	{
+		takeName.Set("-");
+	}
+	else
+	{
+		if (this->IsTargetValid())
+			takeName.Set((char*)GetSetMediaItemTakeInfo(this->GetTake(), "P_NAME", NULL));
+		else
+			takeName.Set(__LOCALIZE("--NO TAKE FOUND--", "sws_DLG_174")); // Analyze loudness window should remove invalid objects, but leave this anyway
+	}
+
+	return takeName;
+}
+
+WDL_FastString BR_LoudnessObject::GetTrackName ()
+{
+	SWS_SectionLock lock(&m_mutex);
+
+	WDL_FastString trackName;
+	if (this->GetTrack())
+	{
+		if (this->IsTargetValid())
+		{
+			if (this->GetTrack() == GetMasterTrack(NULL))
+				trackName.Set(__localizeFunc("MASTER", "track", 0));
+			else
+				trackName.Set((char*)GetSetMediaTrackInfo(this->GetTrack(), "P_NAME", NULL));
+		}
+		else
+			trackName.Set(__LOCALIZE("--NO TRACK FOUND--", "sws_DLG_174")); // Analyze loudness window should remove invalid objects, but leave this anyway
+	}
+	else
+	{
+		if (this->IsTargetValid())
+			trackName.Set((char*)GetSetMediaTrackInfo(GetMediaItemTake_Track(this->GetTake()), "P_NAME", NULL));
+		else
+			trackName.Set(__LOCALIZE("--NO TAKE FOUND--", "sws_DLG_174")); // Analyze loudness window should remove invalid objects, but leave this anyway
+	}
+
+	return trackName;
+}
+
+MediaItem* BR_LoudnessObject::GetItem ()
+{
+	SWS_SectionLock lock(&m_mutex);
+	MediaItem_Take* take = this->GetTake();
+	if (take)
+		return GetMediaItemTake_Item(take);
+	else
+		return NULL;
+}
+
+MediaTrack* BR_LoudnessObject::GetTrack ()
+{
+	SWS_SectionLock lock(&m_mutex);
+	return m_track;
+}
+
+MediaItem_Take* BR_LoudnessObject::GetTake ()
+{
+	SWS_SectionLock lock(&m_mutex);
+	return m_take;
+}
+
+GUID BR_LoudnessObject::GetGuid ()
+{
+	SWS_SectionLock lock(&m_mutex);
+	return m_guid;
+}
+
+void BR_LoudnessObject::SetTrack (MediaTrack* track)
+{
+	SWS_SectionLock lock(&m_mutex);
+	m_track = track;
+	m_revision = SWS_ListView::NewItemRevision();
+}
+
+void BR_LoudnessObject::SetTake (MediaItem_Take* take)
+{
+	SWS_SectionLock lock(&m_mutex);
+	m_take = take;
+	m_revision = SWS_ListView::NewItemRevision();
+}
+
+void BR_LoudnessObject::SetGuid (GUID guid)
+{
+	SWS_SectionLock lock(&m_mutex);
+	m_guid = guid;
+	m_revision = SWS_ListView::NewItemRevision();
+}
+
+BR_LoudnessObject::AudioData::AudioData () :
+audio        (NULL),
+samplerate   (0),
+channels     (0),
+channelMode  (0),
+audioStart   (0),
+audioEnd     (0),
+volume       (0),
+pan          (0)
+{
+	memset(audioHash, 0, 128);
+}
+
+BR_LoudnessObject::Timeline::Timeline () :
+valid      (false),
+itemPos    (0),
+stateCount (-1)
+{
+	memset(stateHash, 0, sizeof(stateHash));
+}
+
+BR_LoudnessObject::Reanalysis::Reanalysis () :
+incremental (false),
+start       (0),
+end         (0)
+{
+}
+
+/******************************************************************************
+* Loudness analyze pool                                                       *
+******************************************************************************/
+BR_LoudnessAnalyzePool::BR_LoudnessAnalyzePool () :
+m_totalLen    (0),
+m_finishedLen (0)
+{
+}
+
+void BR_LoudnessAnalyzePool::Add (BR_LoudnessObject* object, bool integratedOnly, bool doTruePeak, bool doHighPrecisionMode, bool doDualMonoMode)
+{
+	if (!object || this->IsPending(object))
+		return;
+
+	// New batch, reset progress
+	if (m_queued.empty() && m_running.empty())
+	{
+		m_totalLen    = 0;
+		m_finishedLen = 0;
+	}
+
+	Job job;
+	job.object              = object;
+	job.length              = std::max(object->GetAudioLength(), 0.0);
+	job.integratedOnly      = integratedOnly;
+	job.doTruePeak          = doTruePeak;
+	job.doHighPrecisionMode = doHighPrecisionMode;
+	job.doDualMonoMode      = doDualMonoMode;
+
+	m_totalLen += job.length;
+	m_queued.push_back(job);
+}
+
+void BR_LoudnessAnalyzePool::Remove (BR_LoudnessObject* object)
+{
+	for (list<Job>::iterator it = m_running.begin(); it != m_running.end(); ++it)
+	{
+		if (it->object == object)
+		{
+			object->AbortAnalyze();
+			m_finishedLen += it->length;
+			m_running.erase(it);
+			return;
+		}
+	}
+
+	for (list<Job>::iterator it = m_queued.begin(); it != m_queued.end(); ++it)
+	{
+		if (it->object == object)
+		{
+			m_finishedLen += it->length;
+			m_queued.erase(it);
+			return;
+		}
+	}
+}
+
+void BR_LoudnessAnalyzePool::Abort ()
+{
+	for (list<Job>::iterator it = m_running.begin(); it != m_running.end(); ++it)
+		it->object->AbortAnalyze();
+
+	m_running.clear();
+	m_queued.clear();
+	m_totalLen    = 0;
+	m_finishedLen = 0;
+	BR_LoudnessCache::Get().Flush(); // objects finished before aborting may have stored results
+}
+
+bool BR_LoudnessAnalyzePool::Run (WDL_PtrList<BR_LoudnessObject>* finishedObjects /*=NULL*/)
+{
+	// Reap finished objects first so their slots can be reused right away
+	bool reaped = false;
+	for (list<Job>::iterator it = m_running.begin(); it != m_running.end();)
+	{
+		if (it->object->IsRunning())
+		{
+			++it;
+		}
+		else
+		{
+			reaped = true;
+			m_finishedLen += it->length;
+			if (finishedObjects)
+				finishedObjects->Add(it->object);
+			it = m_running.erase(it);
+		}
+	}
+
+	// Analyze() spawns worker thread for each object so keep their number bounded
+	const size_t maxRunning = (size_t)g_pref.GetAnalyzeThreads();
+	while (m_running.size() < maxRunning && !m_queued.empty())
+	{
+		Job job = m_queued.front();
+		m_queued.pop_front();
+
+		job.object->Analyze(job.integratedOnly, job.doTruePeak, job.doHighPrecisionMode, job.doDualMonoMode);
+		m_running.push_back(job);
+	}
+
+	// Batch done, write result cache index once for all of it
+	const bool pending = !m_running.empty() || !m_queued.empty();
+	if (!pending && reaped)
+		BR_LoudnessCache::Get().Flush();
+	return pending;
+}
+
+bool BR_LoudnessAnalyzePool::IsPending (BR_LoudnessObject* object)
+{
+	for (list<Job>::iterator it = m_running.begin(); it != m_running.end(); ++it)
+		if (it->object == object) return true;
+	for (list<Job>::iterator it = m_queued.begin(); it != m_queued.end(); ++it)
+		if (it->object == object) return true;
+	return false;
+}
+
+double BR_LoudnessAnalyzePool::GetProgress ()
+{
+	double progressLen = m_finishedLen;
+	for (list<Job>::iterator it = m_running.begin(); it != m_running.end(); ++it)
+		progressLen += it->length * it->object->GetProgress();
+
+	return (m_totalLen > 0) ? std::min(progressLen / m_totalLen, 1.0) : ((m_queued.empty() && m_running.empty()) ? 1 : 0);
+}
+
+/******************************************************************************
+* Loudness result cache                                                       *
+******************************************************************************/
+static void AppendCacheData (vector<char>& data, const void* value, size_t size)
+{
+	const char* p = (const char*)value;
+	data.insert(data.end(), p, p + size);
+}
+
+static bool ReadCacheData (const vector<char>& data, size_t* pos, void* value, size_t size)
+{
+	if (*pos + size > data.size())
+		return false;
+
+	memcpy(value, &data[*pos], size);
+	*pos += size;
+	return true;
+}
+
+static bool ReadCacheFile (const char* path, vector<char>* data)
+{
+	FILE* f = fopenUTF8(path, "rb");
+	if (!f)
+		return false;
+
+	fseek(f, 0, SEEK_END);
+	const long size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+
+	bool success = size > 0;
+	if (success)
+	{
+		data->resize((size_t)size);
+		success = fread(&(*data)[0], 1, data->size(), f) == data->size();
+	}
+	fclose(f);
+	return success;
+}
+
+static bool WriteCacheFile (const char* path, const vector<char>& data)
 {
-	SWS_SectionLock lock(&m_mutex);
-	m_killFlag = killFlag;
-}
+	FILE* f = fopenUTF8(path, "wb");
+	if (!f)
+		return false;
 
-bool BR_LoudnessObject::GetKillFlag ()
-{
-	SWS_SectionLock lock(&m_mutex);
-	return m_killFlag;
+	const bool success = data.empty() || fwrite(&data[0], 1, data.size(), f) == data.size();
+	if (fclose(f) != 0 || !success)
+	{
+		DeleteFile(path);
+		return false;
+	}
+	return true;
 }
 
-void BR_LoudnessObject::SetProcess (HANDLE process)
+static string CacheKeyToString (const unsigned char* key)
 {
-	SWS_SectionLock lock(&m_mutex);
-	m_process = process;
+	char tmp[BR_LoudnessCache::KEY_SIZE * 2 + 1];
+	for (int i = 0; i < BR_LoudnessCache::KEY_SIZE; ++i)
+		snprintf(tmp + i * 2, 3, "%02x", key[i]);
+	return tmp;
 }
 
-HANDLE BR_LoudnessObject::GetProcess ()
+BR_LoudnessCache& BR_LoudnessCache::Get ()
 {
-	SWS_SectionLock lock(&m_mutex);
-	return m_process;
+	static BR_LoudnessCache s_instance;
+	return s_instance;
 }
 
-WDL_FastString BR_LoudnessObject::GetTakeName ()
+bool BR_LoudnessCache::Load (const unsigned char* key, bool integratedOnly, bool doTruePeak, BR_LoudnessCache::Result* result)
 {
 	SWS_SectionLock lock(&m_mutex);
+	this->LoadIndex();
 
-	WDL_FastString takeName;
-	if (m_track)
+	const string name = CacheKeyToString(key);
+	map<string, BR_LoudnessCache::Entry>::iterator it = m_entries.find(name);
+	if (it == m_entries.end())
+		return false;
+
+	// Integrated-only results can't be used for full analysis, same goes for true peak (mirrors BR_LoudnessObject::Analyze)
+	if (!integratedOnly && (it->second.integratedOnly || (doTruePeak && !it->second.truePeakAnalyzed)))
+		return false;
+
+	vector<char> data;
+	bool success = ReadCacheFile(this->GetPath(name.c_str()).Get(), &data);
+	if (success)
 	{
-		takeName.Set("-");
+		size_t pos = 0;
+		char magic[4];
+		int version;
+		unsigned char fileKey[BR_LoudnessCache::KEY_SIZE];
+		char flags[2];
+		unsigned int shortTermCount = 0, momentaryCount = 0;
+
+		success = ReadCacheData(data, &pos, magic, sizeof(magic))                            &&
+		          ReadCacheData(data, &pos, &version, sizeof(version))                       &&
+		          ReadCacheData(data, &pos, fileKey, sizeof(fileKey))                        &&
+		          ReadCacheData(data, &pos, flags, sizeof(flags))                            &&
+		          ReadCacheData(data, &pos, &result->integrated, sizeof(double))             &&
+		          ReadCacheData(data, &pos, &result->range, sizeof(double))                  &&
+		          ReadCacheData(data, &pos, &result->truePeak, sizeof(double))               &&
+		          ReadCacheData(data, &pos, &result->truePeakPos, sizeof(double))            &&
+		          ReadCacheData(data, &pos, &result->shortTermMax, sizeof(double))           &&
+		          ReadCacheData(data, &pos, &result->momentaryMax, sizeof(double))           &&
+		          ReadCacheData(data, &pos, &shortTermCount, sizeof(shortTermCount))         &&
+		          ReadCacheData(data, &pos, &momentaryCount, sizeof(momentaryCount))         &&
+		          !memcmp(magic, CACHE_ENTRY_MAGIC, sizeof(magic))                            &&
+		          version == CACHE_VERSION                                                   &&
+		          !memcmp(fileKey, key, sizeof(fileKey))                                     &&
+		          data.size() - pos == ((size_t)shortTermCount + momentaryCount) * sizeof(double);
+
+		if (success)
+		{
+			result->integratedOnly   = !!flags[0];
+			result->truePeakAnalyzed = !!flags[1];
+			result->shortTermValues.resize(shortTermCount);
+			result->momentaryValues.resize(momentaryCount);
+			if (shortTermCount) ReadCacheData(data, &pos, &result->shortTermValues[0], shortTermCount * sizeof(double));
+			if (momentaryCount) ReadCacheData(data, &pos, &result->momentaryValues[0], momentaryCount * sizeof(double));
+		}
 	}
-	else
+
+	// Missing or broken file, forget about it
+	if (!success)
 	{
-		if (this->IsTargetValid())
-			takeName.Set((char*)GetSetMediaItemTakeInfo(this->GetTake(), "P_NAME", NULL));
-		else
-			takeName.Set(__LOCALIZE("--NO TAKE FOUND--", "sws_DLG_174")); // Analyze loudness window should remove invalid objects, but leave this anyway
+		this->Erase(it);
+		return false;
 	}
 
-	return takeName;
+	this->Touch(it);
+	return true;
 }
 
-WDL_FastString BR_LoudnessObject::GetTrackName ()
+void BR_LoudnessCache::Store (const unsigned char* key, const BR_LoudnessCache::Result& result)
 {
+	const WDL_UINT64 maxSize = (WDL_UINT64)g_pref.GetCacheSize() * 1024 * 1024;
+	if (!maxSize)
+		return;
+
 	SWS_SectionLock lock(&m_mutex);
+	this->LoadIndex();
 
-	WDL_FastString trackName;
-	if (this->GetTrack())
+	// Never replace cached results with ones that have less data (integrated only or no true peak)
+	const string name = CacheKeyToString(key);
+	map<string, BR_LoudnessCache::Entry>::iterator it = m_entries.find(name);
+	if (it != m_entries.end())
 	{
-		if (this->IsTargetValid())
-		{
-			if (this->GetTrack() == GetMasterTrack(NULL))
-				trackName.Set(__localizeFunc("MASTER", "track", 0));
-			else
-				trackName.Set((char*)GetSetMediaTrackInfo(this->GetTrack(), "P_NAME", NULL));
-		}
-		else
-			trackName.Set(__LOCALIZE("--NO TRACK FOUND--", "sws_DLG_174")); // Analyze loudness window should remove invalid objects, but leave this anyway
+		const int oldData = (it->second.integratedOnly ? 0 : 2) + (it->second.truePeakAnalyzed ? 1 : 0);
+		const int newData = (result.integratedOnly     ? 0 : 2) + (result.truePeakAnalyzed     ? 1 : 0);
+		if (newData < oldData)
+			return;
 	}
+
+	const char flags[2] = {result.integratedOnly, result.truePeakAnalyzed};
+	const unsigned int shortTermCount = (unsigned int)result.shortTermValues.size();
+	const unsigned int momentaryCount = (unsigned int)result.momentaryValues.size();
+
+	vector<char> data;
+	data.reserve(128 + (shortTermCount + momentaryCount) * sizeof(double));
+	AppendCacheData(data, CACHE_ENTRY_MAGIC, 4);
+	AppendCacheData(data, &CACHE_VERSION, sizeof(CACHE_VERSION));
+	AppendCacheData(data, key, BR_LoudnessCache::KEY_SIZE);
+	AppendCacheData(data, flags, sizeof(flags));
+	AppendCacheData(data, &result.integrated, sizeof(double));
+	AppendCacheData(data, &result.range, sizeof(double));
+	AppendCacheData(data, &result.truePeak, sizeof(double));
+	AppendCacheData(data, &result.truePeakPos, sizeof(double));
+	AppendCacheData(data, &result.shortTermMax, sizeof(double));
+	AppendCacheData(data, &result.momentaryMax, sizeof(double));
+	AppendCacheData(data, &shortTermCount, sizeof(shortTermCount));
+	AppendCacheData(data, &momentaryCount, sizeof(momentaryCount));
+	if (shortTermCount) AppendCacheData(data, &result.shortTermValues[0], shortTermCount * sizeof(double));
+	if (momentaryCount) AppendCacheData(data, &result.momentaryValues[0], momentaryCount * sizeof(double));
+
+	CreateDirectory(this->GetPath().Get(), NULL);
+	if (!WriteCacheFile(this->GetPath(name.c_str()).Get(), data))
+		return;
+
+	if (it != m_entries.end())
+		m_size -= it->second.size;
 	else
 	{
-		if (this->IsTargetValid())
-			trackName.Set((char*)GetSetMediaTrackInfo(GetMediaItemTake_Track(this->GetTake()), "P_NAME", NULL));
-		else
-			trackName.Set(__LOCALIZE("--NO TAKE FOUND--", "sws_DLG_174")); // Analyze loudness window should remove invalid objects, but leave this anyway
+		it = m_entries.insert(make_pair(name, BR_LoudnessCache::Entry())).first;
+		it->second.lru = m_lru.insert(m_lru.end(), name);
 	}
 
-	return trackName;
+	BR_LoudnessCache::Entry& entry = it->second;
+	entry.size             = (unsigned int)data.size();
+	entry.integratedOnly   = result.integratedOnly;
+	entry.truePeakAnalyzed = result.truePeakAnalyzed;
+	m_size += entry.size;
+	this->Touch(it);
+
+	this->Evict(maxSize);
 }
 
-MediaItem* BR_LoudnessObject::GetItem ()
+void BR_LoudnessCache::Flush ()
 {
 	SWS_SectionLock lock(&m_mutex);
-	MediaItem_Take* take = this->GetTake();
-	if (take)
-		return GetMediaItemTake_Item(take);
-	else
-		return NULL;
+	if (m_indexDirty)
+		this->SaveIndex();
 }
 
-MediaTrack* BR_LoudnessObject::GetTrack ()
+BR_LoudnessCache::BR_LoudnessCache () :
+m_size        (0),
+m_lastUse     (0),
+m_indexLoaded (false),
+m_indexDirty  (false)
 {
-	SWS_SectionLock lock(&m_mutex);
-	return m_track;
 }
 
-MediaItem_Take* BR_LoudnessObject::GetTake ()
+WDL_FastString BR_LoudnessCache::GetPath (const char* name /*=NULL*/)
 {
-	SWS_SectionLock lock(&m_mutex);
-	return m_take;
+	WDL_FastString path;
+	path.SetFormatted(SNM_MAX_PATH, "%s%c%s", GetResourcePath(), PATH_SLASH_CHAR, CACHE_DIR);
+	if (name)
+		path.AppendFormatted(SNM_MAX_PATH, "%c%s.dat", PATH_SLASH_CHAR, name);
+	return path;
 }
 
-GUID BR_LoudnessObject::GetGuid ()
+void BR_LoudnessCache::LoadIndex ()
 {
-	SWS_SectionLock lock(&m_mutex);
-	return m_guid;
+	if (m_indexLoaded)
+		return;
+	m_indexLoaded = true;
+
+	vector<char> data;
+	if (!ReadCacheFile(this->GetPath(CACHE_INDEX).Get(), &data))
+		return;
+
+	size_t pos = 0;
+	char magic[4];
+	int version;
+	unsigned int count;
+	if (!ReadCacheData(data, &pos, magic, sizeof(magic))      ||
+	    !ReadCacheData(data, &pos, &version, sizeof(version)) ||
+	    !ReadCacheData(data, &pos, &count, sizeof(count))     ||
+	    memcmp(magic, CACHE_INDEX_MAGIC, sizeof(magic))       ||
+	    version != CACHE_VERSION
+	)
+		return;
+
+	for (unsigned int i = 0; i < count; ++i)
+	{
+		char name[BR_LoudnessCache::KEY_SIZE * 2 + 1] = "";
+		char flags[2];
+		BR_LoudnessCache::Entry entry;
+		if (!ReadCacheData(data, &pos, name, sizeof(name) - 1)                 ||
+		    !ReadCacheData(data, &pos, &entry.size, sizeof(entry.size))        ||
+		    !ReadCacheData(data, &pos, &entry.lastUse, sizeof(entry.lastUse))  ||
+		    !ReadCacheData(data, &pos, flags, sizeof(flags))
+		)
+			break;
+
+		entry.integratedOnly   = !!flags[0];
+		entry.truePeakAnalyzed = !!flags[1];
+		if (m_entries.insert(make_pair(string(name), entry)).second)
+		{
+			m_size   += entry.size;
+			m_lastUse = std::max(m_lastUse, entry.lastUse);
+		}
+	}
+
+	// Rebuild LRU list from saved use order
+	typedef map<string, BR_LoudnessCache::Entry>::iterator EntryIt;
+	vector<EntryIt> order;
+	order.reserve(m_entries.size());
+	for (EntryIt it = m_entries.begin(); it != m_entries.end(); ++it)
+		order.push_back(it);
+	std::sort(order.begin(), order.end(), [](const EntryIt& it1, const EntryIt& it2) { return it1->second.lastUse < it2->second.lastUse; });
+	for (size_t i = 0; i < order.size(); ++i)
+		order[i]->second.lru = m_lru.insert(m_lru.end(), order[i]->first);
 }
 
-void BR_LoudnessObject::SetTrack (MediaTrack* track)
+void BR_LoudnessCache::SaveIndex ()
 {
-	SWS_SectionLock lock(&m_mutex);
-	m_track = track;
+	const unsigned int count = (unsigned int)m_entries.size();
+
+	vector<char> data;
+	data.reserve(12 + count * (BR_LoudnessCache::KEY_SIZE * 2 + 14));
+	AppendCacheData(data, CACHE_INDEX_MAGIC, 4);
+	AppendCacheData(data, &CACHE_VERSION, sizeof(CACHE_VERSION));
+	AppendCacheData(data, &count, sizeof(count));
+	for (map<string, BR_LoudnessCache::Entry>::iterator it = m_entries.begin(); it != m_entries.end(); ++it)
+	{
+		const char flags[2] = {it->second.integratedOnly, it->second.truePeakAnalyzed};
+		AppendCacheData(data, it->first.c_str(), BR_LoudnessCache::KEY_SIZE * 2);
+		AppendCacheData(data, &it->second.size, sizeof(it->second.size));
+		AppendCacheData(data, &it->second.lastUse, sizeof(it->second.lastUse));
+		AppendCacheData(data, flags, sizeof(flags));
+	}
+
+	CreateDirectory(this->GetPath().Get(), NULL);
+	if (WriteCacheFile(this->GetPath(CACHE_INDEX).Get(), data))
+		m_indexDirty = false;
 }
 
-void BR_LoudnessObject::SetTake (MediaItem_Take* take)
+void BR_LoudnessCache::Evict (WDL_UINT64 maxSize)
 {
-	SWS_SectionLock lock(&m_mutex);
-	m_take = take;
+	while (m_size > maxSize && !m_lru.empty())
+		this->Erase(m_entries.find(m_lru.front()));
 }
 
-void BR_LoudnessObject::SetGuid (GUID guid)
+void BR_LoudnessCache::Touch (map<string, BR_LoudnessCache::Entry>::iterator it)
 {
-	SWS_SectionLock lock(&m_mutex);
-	m_guid = guid;
+	m_lru.splice(m_lru.end(), m_lru, it->second.lru);
+	it->second.lastUse = ++m_lastUse;
+	m_indexDirty = true;
 }
 
-BR_LoudnessObject::AudioData::AudioData () :
-audio        (NULL),
-samplerate   (0),
-channels     (0),
-channelMode  (0),
-audioStart   (0),
-audioEnd     (0),
-volume       (0),
-pan          (0)
+void BR_LoudnessCache::Erase (map<string, BR_LoudnessCache::Entry>::iterator it)
 {
-	memset(audioHash, 0, 128);
+	DeleteFile(this->GetPath(it->first.c_str()).Get());
+	m_size -= it->second.size;
+	m_lru.erase(it->second.lru);
+	m_entries.erase(it);
+	m_indexDirty = true;
 }
 
 /******************************************************************************
@@ -1681,6 +2884,20 @@ double BR_LoudnessPref::GetReferenceLU ()
 	return (m_projData.Get()->useProjLU) ? (m_projData.Get()->valueLU) : (m_valueLU);
 }
 
+int BR_LoudnessPref::GetAnalyzeThreads ()
+{
+	if (m_analyzeThreads > 0)
+		return m_analyzeThreads;
+
+	const int hardwareThreads = (int)std::thread::hardware_concurrency();
+	return (hardwareThreads > 0) ? hardwareThreads : 1;
+}
+
+int BR_LoudnessPref::GetCacheSize ()
+{
+	return std::max(m_cacheSize, 0);
+}
+
 WDL_FastString BR_LoudnessPref::GetFormatedLUString ()
 {
 	return m_projData.Get()->stringLU;
@@ -1729,7 +2946,7 @@ void BR_LoudnessPref::SaveGlobalPref ()
 	else                                                   luFormat = 0;
 
 	char tmp[966];
-	snprintf(tmp, sizeof(tmp), "%lf %d %lf %lf", m_valueLU, luFormat, m_graphMin, m_graphMax);
+	snprintf(tmp, sizeof(tmp), "%lf %d %lf %lf %d %d", m_valueLU, luFormat, m_graphMin, m_graphMax, m_analyzeThreads, m_cacheSize);
 	WritePrivateProfileString("SWS", PREF_KEY, tmp, get_ini_file());
 }
 
@@ -1744,6 +2961,8 @@ void BR_LoudnessPref::LoadGlobalPref ()
 	m_globalLUFormat  = (lp.getnumtokens() > 1) ? lp.gettoken_int(1)   : 0;
 	m_graphMin        = (lp.getnumtokens() > 2) ? lp.gettoken_float(2) : -41;
 	m_graphMax        = (lp.getnumtokens() > 3) ? lp.gettoken_float(3) : -14;
+	m_analyzeThreads  = (lp.getnumtokens() > 4) ? lp.gettoken_int(4)   : 0;   // 0 -> use hardware thread count
+	m_cacheSize       = (lp.getnumtokens() > 5) ? lp.gettoken_int(5)   : 256; // MB
 
 	if      (m_globalLUFormat == 0) m_globalLUFormat = BR_LoudnessPref::LU;  // don't rely on enum values
 	else if (m_globalLUFormat == 1) m_globalLUFormat = BR_LoudnessPref::LU_AT_K;
@@ -1982,7 +3201,9 @@ m_prefWnd        (NULL),
 m_valueLU        (-23),
 m_graphMin       (-41),
 m_graphMax       (-14),
-m_globalLUFormat (BR_LoudnessPref::LU_K)
+m_globalLUFormat (BR_LoudnessPref::LU_K),
+m_analyzeThreads (0),
+m_cacheSize      (256)
 {
 }
 
@@ -2007,14 +3228,8 @@ static WDL_DLGRET NormalizeProgressProc (HWND hwnd, UINT uMsg, WPARAM wParam, LP
 	if (INT_PTR r = SNM_HookThemeColorsMessage(hwnd, uMsg, wParam, lParam))
 		return r;
 
-	static BR_NormalizeData* s_normalizeData = NULL;
-	static BR_LoudnessObject* s_currentItem  = NULL;
-
-	static int  s_currentItemId      = 0;
-	static bool s_analyzeInProgress  = false;
-	static double s_itemsLen         = 0;
-	static double s_currentItemLen   = 0;
-	static double s_finishedItemsLen = 0;
+	static BR_NormalizeData*      s_normalizeData = NULL;
+	static BR_LoudnessAnalyzePool s_analyzePool;
 
 	#ifndef _WIN32
 		static bool s_positionSet = false;
@@ -2032,21 +3247,16 @@ static WDL_DLGRET NormalizeProgressProc (HWND hwnd, UINT uMsg, WPARAM wParam, LP
 				return 0;
 			}
 
-			s_currentItem = NULL;
-			s_currentItemId = 0;
-			s_analyzeInProgress = false;
-			s_itemsLen = 0;
-			s_currentItemLen = 0;
-			s_finishedItemsLen = 0;
+			// check if user set high precision mode
+			const bool doHighPrecisionMode = !s_normalizeData->quickMode && !!IsHighPrecisionOptionEnabled(NULL);
+			const bool doDualMonoMode      = !!IsDualMonoOptionEnabled(NULL);
 
-			// Get progress data
+			s_analyzePool.Abort();
 			for (int i = 0; i < s_normalizeData->items->GetSize(); ++i)
 			{
 				if (BR_LoudnessObject* item = s_normalizeData->items->Get(i))
-					s_itemsLen += item->GetAudioLength();
+					s_analyzePool.Add(item, s_normalizeData->quickMode, false, doHighPrecisionMode, doDualMonoMode);
 			}
-			if (s_itemsLen == 0) s_itemsLen = 1; // to prevent division by zero
-
 
 			#ifdef _WIN32
 				CenterDialog(hwnd, g_hwndParent, HWND_TOPMOST);
@@ -2077,10 +3287,9 @@ static WDL_DLGRET NormalizeProgressProc (HWND hwnd, UINT uMsg, WPARAM wParam, LP
 			{
 				case IDCANCEL:
 				{
-					KillTimer(hwnd, 1);
+					KillTimer(hwnd, ANALYZE_TIMER_FREQ);
 					s_normalizeData = NULL;
-					if (s_currentItem)
-						s_currentItem->AbortAnalyze();
+					s_analyzePool.Abort();
 					EndDialog(hwnd, 0);
 				}
 				break;
@@ -2093,88 +3302,50 @@ static WDL_DLGRET NormalizeProgressProc (HWND hwnd, UINT uMsg, WPARAM wParam, LP
 			if (!s_normalizeData)
 				return 0;
 
-			if (!s_analyzeInProgress)
+			// No more objects to analyze, normalize them
+			if (!s_analyzePool.Run())
 			{
-				// No more objects to analyze, normalize them
-				if (s_currentItemId >= s_normalizeData->items->GetSize())
+				KillTimer(hwnd, ANALYZE_TIMER_FREQ);
+
+				bool undoTrack = false;
+				bool undoItem  = false;
+				for (int i = 0; i < s_normalizeData->items->GetSize(); ++i)
 				{
-					bool undoTrack = false;
-					bool undoItem  = false;
-					for (int i = 0; i < s_normalizeData->items->GetSize(); ++i)
+					if (BR_LoudnessObject* item = s_normalizeData->items->Get(i))
 					{
-						if (BR_LoudnessObject* item = s_normalizeData->items->Get(i))
+						if (item->NormalizeIntegrated(s_normalizeData->targetLufs))
 						{
-							if (item->NormalizeIntegrated(s_normalizeData->targetLufs))
-							{
-								if (!undoTrack && item->IsTrack()) undoTrack = true;
-								if (!undoItem && !item->IsTrack()) undoItem = true;
-							}
+							if (!undoTrack && item->IsTrack()) undoTrack = true;
+							if (!undoItem && !item->IsTrack()) undoItem = true;
 						}
 					}
-
-					if (undoTrack || undoItem)
-					{
-						if (undoTrack && !undoItem)
-							Undo_OnStateChangeEx2(NULL, __LOCALIZE("Normalize track loudness", "sws_undo"), UNDO_STATE_TRACKCFG, -1);
-						else if (!undoTrack && undoItem)
-							Undo_OnStateChangeEx2(NULL, __LOCALIZE("Normalize item loudness", "sws_undo"), UNDO_STATE_ITEMS, -1);
-						else
-							Undo_OnStateChangeEx2(NULL, __LOCALIZE("Normalize item and track loudness", "sws_undo"), UNDO_STATE_TRACKCFG | UNDO_STATE_ITEMS, -1);
-					}
-
-					s_normalizeData->normalized = true;
-					UpdateTimeline();
-					EndDialog(hwnd, 0);
-					return 0;
 				}
 
-				// Start analysis of the next item
-				if ((s_currentItem = s_normalizeData->items->Get(s_currentItemId)))
-				{
-					s_currentItemLen = s_currentItem->GetAudioLength();
-
-					// check if user set high precision mode 
-					bool doHighPrecisionMode = false;
-					if (!s_normalizeData->quickMode) 
-					{
-						doHighPrecisionMode = !!IsHighPrecisionOptionEnabled(NULL);
-
-					}
-
-					bool doDualMonoMode = !!IsDualMonoOptionEnabled(NULL);
-					s_currentItem->Analyze(s_normalizeData->quickMode, false, doHighPrecisionMode, doDualMonoMode);
-					s_analyzeInProgress = true;
-				}
-				else
-					++s_currentItemId;
-			}
-			else
-			{
-				if (s_currentItem->IsRunning())
+				if (undoTrack || undoItem)
 				{
-					double progress = (s_finishedItemsLen + s_currentItemLen * s_currentItem->GetProgress()) / s_itemsLen;
-					SendMessage(GetDlgItem(hwnd, IDC_PROGRESS), PBM_SETPOS, (int)(progress*100), 0);
+					if (undoTrack && !undoItem)
+						Undo_OnStateChangeEx2(NULL, __LOCALIZE("Normalize track loudness", "sws_undo"), UNDO_STATE_TRACKCFG, -1);
+					else if (!undoTrack && undoItem)
+						Undo_OnStateChangeEx2(NULL, __LOCALIZE("Normalize item loudness", "sws_undo"), UNDO_STATE_ITEMS, -1);
+					else
+						Undo_OnStateChangeEx2(NULL, __LOCALIZE("Normalize item and track loudness", "sws_undo"), UNDO_STATE_TRACKCFG | UNDO_STATE_ITEMS, -1);
 				}
-				else
-				{
-					s_finishedItemsLen += s_currentItemLen;
-					double progress = s_finishedItemsLen / s_itemsLen;
-					SendMessage(GetDlgItem(hwnd, IDC_PROGRESS), PBM_SETPOS, (int)(progress*100), 0);
 
-					s_analyzeInProgress = false;
-					++s_currentItemId;
-				}
+				s_normalizeData->normalized = true;
+				UpdateTimeline();
+				EndDialog(hwnd, 0);
+				return 0;
 			}
+
+			SendMessage(GetDlgItem(hwnd, IDC_PROGRESS), PBM_SETPOS, (int)(s_analyzePool.GetProgress()*100), 0);
 		}
 		break;
 
 		case WM_DESTROY:
 		{
-			KillTimer(hwnd, 1);
+			KillTimer(hwnd, ANALYZE_TIMER_FREQ);
 			s_normalizeData = NULL;
-			if (s_currentItem)
-				s_currentItem->AbortAnalyze();
-			s_analyzeInProgress = false;
+			s_analyzePool.Abort();
 		}
 		break;
 	}
@@ -2220,8 +3391,32 @@ void BR_AnalyzeLoudnessView::GetItemText (SWS_ListItem* item, int iCol, char* st
 
 void BR_AnalyzeLoudnessView::GetItemList (SWS_ListItemList* pList)
 {
+	m_ids.clear();
 	for (int i = 0; i < g_analyzedObjects.Get()->GetSize(); ++i)
+	{
 		pList->Add((SWS_ListItem*)g_analyzedObjects.Get()->Get(i));
+		m_ids[(SWS_ListItem*)g_analyzedObjects.Get()->Get(i)] = i;
+	}
+}
+
+bool BR_AnalyzeLoudnessView::IsItemDirty (SWS_ListItem* item)
+{
+	// Row texts depend on measurements/target (object revision), list position (ID column), track/take names (project state) and display mode
+	BR_LoudnessObject* listItem = (BR_LoudnessObject*)item;
+	unordered_map<SWS_ListItem*,int>::const_iterator it = m_ids.find(item);
+	const bool usingLU = g_loudnessWndManager.Get()->GetProperty(BR_AnalyzeLoudnessWnd::USING_LU);
+	const double luOffset = usingLU ? g_pref.LUFStoLU(0) : 0;
+
+	WDL_INT64 state[] = {
+		listItem->GetRevision(),
+		(it != m_ids.end()) ? it->second : -1,
+		GetProjectStateChangeCount(NULL),
+		(WDL_INT64)(INT_PTR)EnumProjects(-1, NULL, 0),
+		usingLU,
+		0
+	};
+	memcpy(&state[5], &luOffset, sizeof(luOffset));
+	return this->IsRowStateChanged(item, state, sizeof(state) / sizeof(WDL_INT64));
 }
 
 void BR_AnalyzeLoudnessView::OnItemSelChanged (SWS_ListItem* item, int iState)
@@ -2269,6 +3464,18 @@ int BR_AnalyzeLoudnessView::OnItemSort (SWS_ListItem* item1, SWS_ListItem* item2
 		return SWS_ListView::OnItemSort(item1, item2);
 }
 
+bool BR_AnalyzeLoudnessView::GetItemSortKey (SWS_ListItem* item, int iCol, SWS_SortKey* key)
+{
+	if (item && (iCol == COL_INTEGRATED || iCol == COL_RANGE || iCol == COL_TRUEPEAK || iCol == COL_SHORTTERM || iCol == COL_MOMENTARY))
+	{
+		key->bNum = true;
+		key->dNum = ((BR_LoudnessObject*)item)->GetColumnVal(iCol, g_loudnessWndManager.Get()->GetProperty(BR_AnalyzeLoudnessWnd::USING_LU));
+		return true;
+	}
+	else
+		return this->GetTextSortKey(item, iCol, key);
+}
+
 void BR_AnalyzeLoudnessView::OnItemSortEnd ()
 {
 	if (g_loudnessWndManager.Get()) // prevent crash on reaper startup (calling object still in construction)
@@ -2280,9 +3487,6 @@ void BR_AnalyzeLoudnessView::OnItemSortEnd ()
 ******************************************************************************/
 BR_AnalyzeLoudnessWnd::BR_AnalyzeLoudnessWnd () :
 SWS_DockWnd(IDD_BR_LOUDNESS_ANALYZER, __LOCALIZE("Loudness", "sws_DLG_174"), ""),
-m_objectsLen        (0),
-m_currentObjectId   (0),
-m_analyzeInProgress (false),
 m_list              (NULL),
 m_normalizeWnd      (NULL),
 m_exportFormatWnd   (NULL)
@@ -2376,6 +3580,7 @@ BR_LoudnessObject* BR_AnalyzeLoudnessWnd::IsObjectInList (MediaItem_Take* take)
 void BR_AnalyzeLoudnessWnd::AbortAnalyze ()
 {
 	SetAnalyzing(false, false);
+	m_analyzePool.Abort();
 
 	// Make sure objects already in the list are NOT destroyed
 	for (int i = 0; i < m_analyzeQueue.GetSize(); ++i)
@@ -2384,17 +3589,14 @@ void BR_AnalyzeLoudnessWnd::AbortAnalyze ()
 			m_analyzeQueue.Delete(i--, false);
 	}
 	m_analyzeQueue.Empty(true);
-	m_objectsLen      = 0;
-	m_currentObjectId = 0;
 }
 
 void BR_AnalyzeLoudnessWnd::AbortReanalyze ()
 {
 	SetAnalyzing(false, true);
+	m_analyzePool.Abort();
 
 	m_reanalyzeQueue.Empty(false);
-	m_objectsLen      = 0;
-	m_currentObjectId = 0;
 }
 
 void BR_AnalyzeLoudnessWnd::SetAnalyzing (const bool analyzing, const bool reanalyze)
@@ -2408,15 +3610,16 @@ void BR_AnalyzeLoudnessWnd::SetAnalyzing (const bool analyzing, const bool reana
 
 	if (analyzing)
 		SetTimer(m_hwnd, timer, ANALYZE_TIMER_FREQ, NULL);
-	else {
+	else
 		KillTimer(m_hwnd, timer);
-
-		m_analyzeInProgress = false;
-	}
 }
 
 void BR_AnalyzeLoudnessWnd::ClearList ()
 {
+	// Objects in reanalyze queue are owned by the list so they have to stop first
+	if (m_reanalyzeQueue.GetSize())
+		this->AbortReanalyze();
+
 	// Make sure objects in analyze queue are not destroyed (prior to clearing the list, existing objects are put there to make analysis faster)
 	for (int i = 0; i < m_analyzeQueue.GetSize(); ++i)
 	{
@@ -3261,12 +4464,9 @@ void BR_AnalyzeLoudnessWnd::OnCommand (WPARAM wParam, LPARAM lParam)
 			if (m_analyzeQueue.GetSize())
 			{
 				for (int i = 0; i < m_analyzeQueue.GetSize(); ++i)
-					m_objectsLen += m_analyzeQueue.Get(i)->GetAudioLength();
-
-				// Prevent division by zero when calculating progress
-				if (m_objectsLen == 0) m_objectsLen = 1;
+					m_analyzePool.Add(m_analyzeQueue.Get(i), false, m_properties.doTruePeak, m_properties.doHighPrecisionMode, m_properties.doDualMonoMode);
 
-				// Start timer which will analyze each object and finally update the list view
+				// Start timer which will analyze objects and finally update the list view
 				SetAnalyzing(true, false);
 			}
 		}
@@ -3285,12 +4485,9 @@ void BR_AnalyzeLoudnessWnd::OnCommand (WPARAM wParam, LPARAM lParam)
 			if (m_reanalyzeQueue.GetSize())
 			{
 				for (int i = 0; i < m_reanalyzeQueue.GetSize(); ++i)
-					m_objectsLen += m_reanalyzeQueue.Get(i)->GetAudioLength();
+					m_analyzePool.Add(m_reanalyzeQueue.Get(i), false, m_properties.doTruePeak, m_properties.doHighPrecisionMode, m_properties.doDualMonoMode);
 
-				// Prevent division by zero when calculating progress
-				if (m_objectsLen == 0) m_objectsLen = 1;
-
-				// Start timer which will analyze each object and finally update the list view
+				// Start timer which will analyze objects and finally update the list view
 				SetAnalyzing(true, true);
 			}
 		}
@@ -3363,6 +4560,7 @@ void BR_AnalyzeLoudnessWnd::OnCommand (WPARAM wParam, LPARAM lParam)
 			int x = 0;
 			while (BR_LoudnessObject* listItem = (BR_LoudnessObject*)m_list->EnumSelected(&x))
 			{
+				m_analyzePool.Remove(listItem);
 				m_reanalyzeQueue.Delete(m_reanalyzeQueue.Find(listItem), false);
 				m_analyzeQueue.Delete(m_analyzeQueue.Find(listItem), true);
 
@@ -3595,119 +4793,66 @@ void BR_AnalyzeLoudnessWnd::OnCommand (WPARAM wParam, LPARAM lParam)
 
 void BR_AnalyzeLoudnessWnd::OnTimer (WPARAM wParam)
 {
-	static BR_LoudnessObject* s_currentObject      = NULL;
-	static double             s_currentObjectLen   = 0;
-	static double             s_finishedObjectsLen = 0;
-
 	if (wParam == ANALYZE_TIMER)
 	{
-		if (!m_analyzeInProgress)
-		{
-			// New analyze task began, reset variables
-			if (m_currentObjectId == 0)
-				s_finishedObjectsLen = 0;
+		const bool analyzing = m_analyzePool.Run();
 
-			if (!m_analyzeQueue.GetSize())
+		// Move analyzed objects to the list view, keeping the order in which they were queued
+		bool update = false;
+		while (m_analyzeQueue.GetSize() && !m_analyzePool.IsPending(m_analyzeQueue.Get(0)))
+		{
+			if (BR_LoudnessObject* object = m_analyzeQueue.Get(0))
 			{
-				// Make sure list view isn't populated with invalid items (i.e. user could have deleted them during analysis)
-				for (int i = 0; i < g_analyzedObjects.Get()->GetSize(); ++i)
-				{
-					if (BR_LoudnessObject* object = g_analyzedObjects.Get()->Get(i))
-					{
-						if (!object->IsTargetValid())
-							g_analyzedObjects.Get()->Delete(i--, true);
-					}
-				}
-
-				this->Update();
-				SetAnalyzing(false, false);
-
-				return;
+				// Sometimes the analyzed object can already be in the list (if option to clear list upon analyzing is disabled)
+				if (g_analyzedObjects.Get()->Find(object) == -1)
+					g_analyzedObjects.Get()->Add(object);
+				m_analyzeQueue.Delete(0, false);
+				update = true;
 			}
 			else
-			{
-				if ((s_currentObject = m_analyzeQueue.Get(0)))
-				{
-					s_currentObjectLen = s_currentObject->GetAudioLength();
-					s_currentObject->Analyze(false, m_properties.doTruePeak, m_properties.doHighPrecisionMode, m_properties.doDualMonoMode);
-					m_analyzeInProgress = true;
-				}
-				else
-					m_analyzeQueue.Delete(0, true);
-				++m_currentObjectId;
-			}
+				m_analyzeQueue.Delete(0, true);
 		}
-		else
+
+		if (!analyzing)
 		{
-			// Make sure our object is still here
-			double progress = 1;
-			if (m_analyzeQueue.Find(s_currentObject) != -1 && s_currentObject->IsRunning())
-				progress = (s_finishedObjectsLen + s_currentObjectLen * s_currentObject->GetProgress()) / m_objectsLen;
-			else
+			// Make sure list view isn't populated with invalid items (i.e. user could have deleted them during analysis)
+			for (int i = 0; i < g_analyzedObjects.Get()->GetSize(); ++i)
 			{
-				if (m_analyzeQueue.Find(s_currentObject) != -1)
+				if (BR_LoudnessObject* object = g_analyzedObjects.Get()->Get(i))
 				{
-					// Sometimes the analyzed object can already be in the list (if option to clear list upon analyzing is disabled)
-					if (g_analyzedObjects.Get()->Find(s_currentObject) == -1)
-						g_analyzedObjects.Get()->Add(s_currentObject);
-					m_analyzeQueue.Delete(m_analyzeQueue.Find(s_currentObject), false);
-					this->Update();
+					if (!object->IsTargetValid())
+						g_analyzedObjects.Get()->Delete(i--, true);
 				}
-
-				s_finishedObjectsLen += s_currentObjectLen;
-				progress = s_finishedObjectsLen / m_objectsLen;
-
-				m_analyzeInProgress = false;
 			}
-			SendMessage(GetDlgItem(m_hwnd, IDC_PROGRESS), PBM_SETPOS, (int)(progress*100), 0);
+
+			this->Update();
+			SetAnalyzing(false, false);
+			return;
 		}
+
+		if (update)
+			this->Update();
+		SendMessage(GetDlgItem(m_hwnd, IDC_PROGRESS), PBM_SETPOS, (int)(m_analyzePool.GetProgress()*100), 0);
 	}
 	else if (wParam == REANALYZE_TIMER)
 	{
-		if (!m_analyzeInProgress)
-		{
-			// New analyze task began, reset variables
-			if (m_currentObjectId == 0)
-				s_finishedObjectsLen = 0;
+		const bool analyzing = m_analyzePool.Run();
 
-			if (!m_reanalyzeQueue.GetSize())
-			{
-				this->Update();
-				SetAnalyzing(false, true);
-				return;
-			}
-			else
-			{
-				if ((s_currentObject = m_reanalyzeQueue.Get(0)))
-				{
-					s_currentObjectLen = s_currentObject->GetAudioLength();
-					s_currentObject->Analyze(false, m_properties.doTruePeak, m_properties.doHighPrecisionMode, m_properties.doDualMonoMode);
-					m_analyzeInProgress = true;
-				}
-				else
-					m_reanalyzeQueue.Delete(0, false);
-				++m_currentObjectId;
-			}
-		}
-		else
+		// Objects in reanalyze queue are already in the list, just drop the finished ones
+		for (int i = 0; i < m_reanalyzeQueue.GetSize(); ++i)
 		{
-			// Make sure our object is still here (user could have deleted it)
-			if (m_reanalyzeQueue.Find(s_currentObject) != -1 && s_currentObject->IsRunning())
-			{
-				double progress = (s_finishedObjectsLen + s_currentObjectLen * s_currentObject->GetProgress()) / m_objectsLen;
-				SendMessage(GetDlgItem(m_hwnd, IDC_PROGRESS), PBM_SETPOS, (int)(progress*100), 0);
-			}
-			else
-			{
-				if (m_reanalyzeQueue.Find(s_currentObject) != -1)
-					m_reanalyzeQueue.Delete(m_reanalyzeQueue.Find(s_currentObject), false);
+			if (!m_analyzePool.IsPending(m_reanalyzeQueue.Get(i)))
+				m_reanalyzeQueue.Delete(i--, false);
+		}
 
-				s_finishedObjectsLen += s_currentObjectLen;
-				double progress = s_finishedObjectsLen / m_objectsLen;
-				SendMessage(GetDlgItem(m_hwnd, IDC_PROGRESS), PBM_SETPOS, (int)(progress*100), 0);
-				m_analyzeInProgress = false;
-			}
+		if (!analyzing)
+		{
+			this->Update();
+			SetAnalyzing(false, true);
+			return;
 		}
+
+		SendMessage(GetDlgItem(m_hwnd, IDC_PROGRESS), PBM_SETPOS, (int)(m_analyzePool.GetProgress()*100), 0);
 	}
 	else if (wParam == UPDATE_TIMER)
 	{
@@ -3750,6 +4895,7 @@ void BR_AnalyzeLoudnessWnd::OnTimer (WPARAM wParam)
 					else
 					{
 						// Remove from reanalyze and analyze queues first!
+						m_analyzePool.Remove(listItem);
 						m_reanalyzeQueue.Delete(m_reanalyzeQueue.Find(listItem), false);
 						m_analyzeQueue.Delete(m_analyzeQueue.Find(listItem), true);
 
@@ -3972,6 +5118,7 @@ int LoudnessInitExit (bool init)
 	else
 	{
 		g_pref.SaveGlobalPref();
+		BR_LoudnessCache::Get().Flush();
 		g_loudnessWndManager.Delete();
 		plugin_register("-projectconfig", &s_projectconfig);
 		return 1;
@@ -4266,13 +5413,7 @@ static WDL_DLGRET NFAnalyzeLUFSProgressProc(HWND hwnd, UINT uMsg, WPARAM wParam,
 		return r;
 
 	static BR_NormalizeData* s_normalizeData = NULL;
-	static BR_LoudnessObject* s_currentItem = NULL;
-
-	static int  s_currentItemId = 0;
-	static bool s_analyzeInProgress = false;
-	static double s_itemsLen = 0;
-	static double s_currentItemLen = 0;
-	static double s_finishedItemsLen = 0;
+	static BR_LoudnessAnalyzePool s_analyzePool;
 
 #ifndef _WIN32
 	static bool s_positionSet = false;
@@ -4290,19 +5431,16 @@ static WDL_DLGRET NFAnalyzeLUFSProgressProc(HWND hwnd, UINT uMsg, WPARAM wParam,
 			return 0;
 		}
 
-		s_currentItemId = 0;
-		s_analyzeInProgress = false;
-		s_itemsLen = 0;
-		s_currentItemLen = 0;
-		s_finishedItemsLen = 0;
-
-		// Get progress data
+		s_analyzePool.Abort();
 		for (int i = 0; i < s_normalizeData->items->GetSize(); ++i)
 		{
 			if (BR_LoudnessObject* item = s_normalizeData->items->Get(i))
-				s_itemsLen += item->GetAudioLength();
+			{
+				// NF: only use high prec. mode in full analyzing mode (and user has set it in Options), disable in quick mode
+				const bool wantHighPrecisionMode = !s_normalizeData->quickMode;
+				s_analyzePool.Add(item, s_normalizeData->quickMode, item->GetDoTruePeak(), wantHighPrecisionMode ? item->GetDoHighPrecisionMode() : false, item->GetDoDualMonoMode());
+			}
 		}
-		if (s_itemsLen == 0) s_itemsLen = 1; // to prevent division by zero
 
 
 #ifdef _WIN32
@@ -4334,10 +5472,9 @@ static WDL_DLGRET NFAnalyzeLUFSProgressProc(HWND hwnd, UINT uMsg, WPARAM wParam,
 		{
 		case IDCANCEL:
 		{
-			KillTimer(hwnd, 1);
+			KillTimer(hwnd, ANALYZE_TIMER_FREQ);
 			s_normalizeData = NULL;
-			if (s_currentItem)
-				s_currentItem->AbortAnalyze();
+			s_analyzePool.Abort();
 			EndDialog(hwnd, 0);
 		}
 		break;
@@ -4350,63 +5487,25 @@ static WDL_DLGRET NFAnalyzeLUFSProgressProc(HWND hwnd, UINT uMsg, WPARAM wParam,
 		if (!s_normalizeData)
 			return 0;
 
-		if (!s_analyzeInProgress)
+		// No more objects to analyze
+		if (!s_analyzePool.Run())
 		{
-			// No more objects to analyze, normalize them
-			if (s_currentItemId >= s_normalizeData->items->GetSize())
-
-			{
-				s_normalizeData->normalized = true;
-				UpdateTimeline();
-				EndDialog(hwnd, 0);
-				return 0;
-			}
-
-
-			// Start analysis of the next item
-			if ((s_currentItem = s_normalizeData->items->Get(s_currentItemId)))
-			{
-				s_currentItemLen = s_currentItem->GetAudioLength();
-
-				// NF: only use high prec. mode in full analyzing mode (and user has set it in Options), disable in quick mode
-				bool wantHighPrecisionMode = false;
-				if (!s_normalizeData->quickMode)
-					wantHighPrecisionMode = true;
-
-				s_currentItem->Analyze(s_normalizeData->quickMode, s_normalizeData->items->Get(s_currentItemId)->GetDoTruePeak(), wantHighPrecisionMode ? s_normalizeData->items->Get(s_currentItemId)->GetDoHighPrecisionMode() : false, s_normalizeData->items->Get(s_currentItemId)->GetDoDualMonoMode());
-
-				s_analyzeInProgress = true;
-			}
-			else
-				++s_currentItemId;
+			KillTimer(hwnd, ANALYZE_TIMER_FREQ);
+			s_normalizeData->normalized = true;
+			UpdateTimeline();
+			EndDialog(hwnd, 0);
+			return 0;
 		}
-		else
-		{
-			if (s_currentItem->IsRunning())
-			{
-				double progress = (s_finishedItemsLen + s_currentItemLen * s_currentItem->GetProgress()) / s_itemsLen;
-				SendMessage(GetDlgItem(hwnd, IDC_PROGRESS), PBM_SETPOS, (int)(progress * 100), 0);
-			}
-			else
-			{
-				s_finishedItemsLen += s_currentItemLen;
-				double progress = s_finishedItemsLen / s_itemsLen;
-				SendMessage(GetDlgItem(hwnd, IDC_PROGRESS), PBM_SETPOS, (int)(progress * 100), 0);
 
-				s_analyzeInProgress = false;
-				++s_currentItemId;
-			}
-		}
+		SendMessage(GetDlgItem(hwnd, IDC_PROGRESS), PBM_SETPOS, (int)(s_analyzePool.GetProgress() * 100), 0);
 	}
 	break;
 
 	case WM_DESTROY:
 	{
-		KillTimer(hwnd, 1);
+		KillTimer(hwnd, ANALYZE_TIMER_FREQ);
 		s_normalizeData = NULL;
-		if (s_currentItem)
-			s_currentItem->AbortAnalyze();
-		s_analyzeInProgress = false;
+		s_analyzePool.Abort();
 	}
 	break;
 	}
@@ -4449,7 +5548,10 @@ bool NFDoAnalyzeTakeLoudness_IntegratedOnly(MediaItem_Take* take, double* lufsIn
 		bool isTargetValid = objects.Get(0)->CheckTarget(take);
 		if (isTargetValid) {
 			BR_NormalizeData analyzeData = { &objects, -23, true, false }; // quick mode, integrated only, targetLUFS isn't used here
-			NFAnalyzeItemsLoudnessAndShowProgress(&analyzeData);
+			if (objects.Get(0)->LoadCachedAnalysis(true, objects.Get(0)->GetDoTruePeak(), false, objects.Get(0)->GetDoDualMonoMode()))
+				analyzeData.normalized = true; // no need for progress dialog
+			else
+				NFAnalyzeItemsLoudnessAndShowProgress(&analyzeData);
 
 			if (analyzeData.normalized) { // here: checks if analysis is completed, returns false if e.g. user cancels analyse process
 				double returnLUFSintegrated;
@@ -4486,7 +5588,10 @@ bool NFDoAnalyzeTakeLoudness(MediaItem_Take* take, bool analyzeTruePeak, double*
 			objects.Get(0)->SetDoHighPrecisionMode(doHighPrecisionMode);
 
 			BR_NormalizeData analyzeData = { &objects, -23, false, false }; // full analyze mode
-			NFAnalyzeItemsLoudnessAndShowProgress(&analyzeData);
+			if (objects.Get(0)->LoadCachedAnalysis(false, analyzeTruePeak, doHighPrecisionMode, objects.Get(0)->GetDoDualMonoMode()))
+				analyzeData.normalized = true;
+			else
+				NFAnalyzeItemsLoudnessAndShowProgress(&analyzeData);
 
 			if (analyzeData.normalized) {
 				double returnLUFSintegrated, returnRange, returnTruePeak, returnTruePeakPos, returnShortTermMax, returnMomentaryMax;
@@ -4527,7 +5632,10 @@ bool NFDoAnalyzeTakeLoudness2(MediaItem_Take* take, bool analyzeTruePeak, double
 			objects.Get(0)->SetDoHighPrecisionMode(false);
 
 			BR_NormalizeData analyzeData = { &objects, -23, false, false }; // full analyze mode
-			NFAnalyzeItemsLoudnessAndShowProgress(&analyzeData);
+			if (objects.Get(0)->LoadCachedAnalysis(false, analyzeTruePeak, false, objects.Get(0)->GetDoDualMonoMode()))
+				analyzeData.normalized = true;
+			else
+				NFAnalyzeItemsLoudnessAndShowProgress(&analyzeData);
 
 			if (analyzeData.normalized) {
 				double returnLUFSintegrated, returnRange, returnTruePeak, returnTruePeakPos, returnShortTermMax, returnMomentaryMax, returnShortTermMaxPos, returnMomentaryMaxPos;
@@ -40,7 +40,8 @@ public:
 	~BR_LoudnessObject ();
 
 	/* Analyze */
-	bool Analyze (bool integratedOnly, bool doTruePeak, bool doHighPrecisionMode, bool doDualMonoMode);
+	bool Analyze (bool integratedOnly, bool doTruePeak, bool doHighPrecisionMode, bool doDualMonoMode); // uses loudness result cache when possible
+	bool LoadCachedAnalysis (bool integratedOnly, bool doTruePeak, bool doHighPrecisionMode, bool doDualMonoMode); // call from the main thread only, returns false if results are not cached
 	void AbortAnalyze ();
 	bool IsRunning ();
 	double GetProgress ();
@@ -48,6 +49,7 @@ public:
 	/* For populating list view in analyze loudness dialog */
 	double GetColumnVal (int column, int mode);                    // mode: 0->LUFS, 1->LU (LU will follow global format settings)
 	void GetColumnStr (int column, char* str, int strSz, int mode);
+	int GetRevision ();                                            // changes whenever column strings may change (except track/take names)
 
 	/* For serializing */
 	void SaveObject (ProjectStateContext* ctx);
@@ -98,14 +100,50 @@ private:
 		BR_Envelope volEnv, volEnvPreFX;
 		AudioData();
 	};
+	struct TimelineItem
+	{
+		GUID guid;
+		double start, end;
+		unsigned char hash[20]; // SHA-1 of item and active take values that change audio (see AddItemToHash())
+	};
+	struct Timeline // whatever audio accessor reads from, used to find edited parts of the audio
+	{
+		bool valid;                 // false if edits can't be located (i.e. folder tracks)
+		double itemPos;             // take objects only
+		vector<TimelineItem> items; // track objects only, sorted by GUID
+		unsigned char stateHash[20]; // track objects only, SHA-1 of everything else the audio depends on (track without items, receives, master)
+		int stateCount;              // project state change count it was built at
+		Timeline();
+	};
+	struct BlockData // block energies of the last analysis, they let AnalyzeData() re-analyze only edited parts of the audio
+	{
+		vector<double> blocks, shortTermBlocks; // energies of all 400 ms and 3 s blocks (see ebur128_block_log())
+		AudioData audioData;                    // audio and timeline blocks were measured from
+		Timeline timeline;
+		bool doHighPrecisionMode, doDualMonoMode, truePeakAnalyzed;
+	};
+	struct Reanalysis
+	{
+		bool incremental;
+		double start, end; // edited range (relative to audio start) with start already moved back so filters can settle before it
+		Timeline timeline;
+		Reanalysis();
+	};
 
 	static unsigned WINAPI AnalyzeData (void* loudnessObject);
+	static bool GetCacheKey (AudioData& data, bool integratedOnly, bool doHighPrecisionMode, bool doDualMonoMode, unsigned char* key); // false if audio can't be identified
+	bool RestoreFromCache ();
 	int CheckSetAudioData (); // call from the main thread only, returns 0->target doesn't exist anymore, 1->old accessor still valid, 2->accessor got updated
 	void SetAudioData (const AudioData& audioData);
 	AudioData GetAudioData ();
 	void SetRunning (bool running);
 	void SetProgress (double progress);
-	void SetAnalyzeData (double integrated, double range, double truePeak, double truePeakPos, double shortTermMax, double momentaryMax, const vector<double>& shortTermValues, const vector<double>& momentaryValues);	
+	void SetAnalyzeData (double integrated, double range, double truePeak, double truePeakPos, double shortTermMax, double momentaryMax, const vector<double>& shortTermValues, const vector<double>& momentaryValues); // also drops block data
+	void SetBlockData (const BlockData& blockData);
+	BlockData GetBlockData ();
+	Timeline GetCurrentTimeline (); // call from the main thread only
+	void PlanReanalysis ();         // call from the main thread only, before starting AnalyzeData()
+	Reanalysis GetReanalysis ();
 	void SetAnalyzedStatus (bool analyzed);
 	bool GetAnalyzedStatus ();
 	void SetIntegratedOnly (bool integratedOnly);
@@ -139,6 +177,88 @@ private:
 	SWS_Mutex m_mutex;
 	vector<double> m_shortTermValues;
 	vector<double> m_momentaryValues;
+	int m_revision;
+	Timeline m_timeline;
+	BlockData m_blockData;
+	Reanalysis m_reanalysis;
+};
+
+/******************************************************************************
+* Loudness analyze pool                                                       *
+******************************************************************************/
+class BR_LoudnessAnalyzePool
+{
+public:
+	BR_LoudnessAnalyzePool ();
+
+	/* Objects are not owned by the pool, call Remove() before deleting queued object */
+	void Add (BR_LoudnessObject* object, bool integratedOnly, bool doTruePeak, bool doHighPrecisionMode, bool doDualMonoMode);
+	void Remove (BR_LoudnessObject* object);
+	void Abort ();
+
+	/* Call from the main thread (timer) - reaps finished objects and starts queued ones until all worker slots are full */
+	bool Run (WDL_PtrList<BR_LoudnessObject>* finishedObjects = NULL); // returns false when there is nothing left to analyze
+	bool IsPending (BR_LoudnessObject* object);
+	double GetProgress ();                                              // aggregated per audio length of all added objects
+
+private:
+	struct Job
+	{
+		BR_LoudnessObject* object;
+		double length;
+		bool integratedOnly, doTruePeak, doHighPrecisionMode, doDualMonoMode;
+	};
+
+	list<Job> m_queued, m_running;
+	double m_totalLen, m_finishedLen;
+};
+
+/******************************************************************************
+* Loudness result cache                                                       *
+******************************************************************************/
+class BR_LoudnessCache
+{
+public:
+	/* No constructor - singleton design */
+	static BR_LoudnessCache& Get ();
+
+	static const int KEY_SIZE = 20; // SHA-1 of audio accessor hash and everything else that affects analyze results
+	struct Result
+	{
+		double integrated, range, truePeak, truePeakPos, shortTermMax, momentaryMax;
+		vector<double> shortTermValues, momentaryValues;
+		bool integratedOnly, truePeakAnalyzed;
+	};
+
+	/* Thread safe. Results are kept in the resource path, one file per key, least recently used get evicted once over size limit */
+	bool Load (const unsigned char* key, bool integratedOnly, bool doTruePeak, BR_LoudnessCache::Result* result); // fails if cached result has less data than requested
+	void Store (const unsigned char* key, const BR_LoudnessCache::Result& result);                                 // index is only updated in memory...
+	void Flush ();                                                                                                 // ...and written here (end of analyze batch, exit)
+
+private:
+	struct Entry
+	{
+		unsigned int size;
+		WDL_UINT64 lastUse; // LRU order saved in the index
+		bool integratedOnly, truePeakAnalyzed;
+		list<string>::iterator lru;
+	};
+
+	BR_LoudnessCache ();
+	BR_LoudnessCache (const BR_LoudnessCache&);
+	void operator=   (const BR_LoudnessCache&);
+	WDL_FastString GetPath (const char* name = NULL); // cache directory or file in it
+	void LoadIndex ();
+	void SaveIndex ();
+	void Evict (WDL_UINT64 maxSize);
+	void Touch (map<string, BR_LoudnessCache::Entry>::iterator it); // mark as most recently used
+	void Erase (map<string, BR_LoudnessCache::Entry>::iterator it); // delete file and entry
+
+	map<string, BR_LoudnessCache::Entry> m_entries; // key is hex string of cache key (also file name)
+	list<string> m_lru;                             // keys of m_entries, least recently used first
+	WDL_UINT64 m_size, m_lastUse;
+	bool m_indexLoaded, m_indexDirty;
+	SWS_Mutex m_mutex;
 };
 
 /******************************************************************************
@@ -154,6 +274,8 @@ public:
 	double GetGraphMin ();
 	double GetGraphMax ();
 	double GetReferenceLU ();
+	int GetAnalyzeThreads (); // maximum number of objects analyzed at once, defaults to hardware thread count
+	int GetCacheSize ();      // in MB, 0 disables loudness result cache
 	double LUtoLUFS (double lu);
 	double LUFStoLU (double lufs);
 	WDL_FastString GetFormatedLUString ();
@@ -190,7 +312,7 @@ private:
 	SWSProjConfig<BR_LoudnessPref::ProjData> m_projData;
 	HWND m_prefWnd;
 	double m_valueLU, m_graphMin, m_graphMax;
-	int m_globalLUFormat;
+	int m_globalLUFormat, m_analyzeThreads, m_cacheSize;
 };
 
 /******************************************************************************
@@ -220,10 +342,15 @@ public:
 protected:
 	virtual void GetItemText (SWS_ListItem* item, int iCol, char* str, int iStrMax);
 	virtual void GetItemList (SWS_ListItemList* pList);
+	virtual bool IsItemDirty (SWS_ListItem* item);
 	virtual void OnItemSelChanged (SWS_ListItem* item, int iState);
 	virtual void OnItemDblClk (SWS_ListItem* item, int iCol);
 	virtual void OnItemSortEnd ();
 	virtual int OnItemSort (SWS_ListItem* item1, SWS_ListItem* item2);
+	virtual bool GetItemSortKey (SWS_ListItem* item, int iCol, SWS_SortKey* key);
+
+private:
+	unordered_map<SWS_ListItem*,int> m_ids; // list position of each object, see GetItemList()
 };
 
 /******************************************************************************
@@ -288,9 +415,7 @@ protected:
 		void Load ();
 		void Save ();
 	} m_properties;
-	double m_objectsLen;
-	int m_currentObjectId;
-	bool m_analyzeInProgress;
+	BR_LoudnessAnalyzePool m_analyzePool; // shared by analyze and reanalyze (they never run at the same time)
 	BR_AnalyzeLoudnessView* m_list;
 	HWND m_normalizeWnd, m_exportFormatWnd;                                          // never delete objects in reanalyzeQueue when removing them from list!!
 	WDL_PtrList_DeleteOnDestroy<BR_LoudnessObject> m_analyzeQueue, m_reanalyzeQueue; // m_analyzeQueue is ok if the object didn't enter g_analyzedObjects
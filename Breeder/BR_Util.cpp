@@ -1361,17 +1361,7 @@ GUID GetItemGuid (MediaItem* item)
 
 MediaItem* GuidToItem (const GUID* guid, ReaProject* proj /*=NULL*/)
 {
-	if (guid)
-	{
-		const int itemCount = CountMediaItems(proj);
-		for (int i = 0; i < itemCount; ++i)
-		{
-			MediaItem* item = GetMediaItem(proj, i);
-			if (GuidsEqual((GUID*)GetSetMediaItemInfo(item, "GUID", NULL), guid))
-				return item;
-		}
-	}
-	return NULL;
+	return GuidToMediaItem(proj, guid);
 }
 
 WDL_FastString GetSourceChunk (PCM_source* source)
@@ -0,0 +1,345 @@
+/******************************************************************************
+/ Base64Check.cpp
+/
+/ A little console application comparing the current Base64 codec
+/ (Utility/Base64.cpp) against the original SWS implementation, on random
+/ and malformed input, with and without padding.
+/ Usage: base64check [iterations] [seed], returns 0 if both agree everywhere
+/
+/ Copyright (c) 2009 Tim Payne (SWS)
+/
+/ Permission is hereby granted, free of charge, to any person obtaining a copy
+/ of this software and associated documentation files (the "Software"), to deal
+/ in the Software without restriction, including without limitation the rights to
+/ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+/ of the Software, and to permit persons to whom the Software is furnished to
+/ do so, subject to the following conditions:
+/
+/ The above copyright notice and this permission notice shall be included in all
+/ copies or substantial portions of the Software.
+/
+/ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+/ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+/ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+/ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+/ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+/ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+/ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+/ OTHER DEALINGS IN THE SOFTWARE.
+/
+******************************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include <string>
+
+// the codec under test, built as is (its "stdafx.h" is the one in Base64Check/)
+#include "../Utility/Base64.cpp"
+
+// Original implementation (SWS 2.x, before the lookup table rework), verbatim
+// except for:
+// - new[]/delete[] pairing (the original free()'d new[]'ed buffers)
+// - too much padding returns NULL (the original did new char[<negative>])
+// - 4 bytes of slack in the decoded buffer (the original could write past it
+//   when the input held more data than predicted, e.g. "AAAA=")
+// None of these change the returned data.
+static const char old_cb64[]="ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+static const char old_cd64[]="|$$$}rstuvwxyz{$$$>$$$>?@ABCDEFGHIJKLMNOPQRSTUVW$$$$$$XYZ[\\]^_`abcdefghijklmnopq";
+
+class OldBase64
+{
+public:
+	OldBase64() : m_pEncodedBuf(NULL), m_pDecodedBuf(NULL) {}
+	~OldBase64() { delete [] m_pEncodedBuf; delete [] m_pDecodedBuf; }
+
+	char* Encode(const char* pInput, int iInputLen, const bool pad)
+	{
+		int iLen = iInputLen;
+		int iEncodedLen;
+
+		//calculate encoded buffer size
+		if (pad)
+			iEncodedLen = static_cast<int>(4 * ceil(iLen / 3.f));
+		else
+			iEncodedLen = static_cast<int>(ceil(4 * iLen / 3.f));
+
+		// allocate:
+		delete [] m_pEncodedBuf;
+		m_pEncodedBuf = new char[iEncodedLen + 1];
+		char* pOutput = m_pEncodedBuf;
+
+		//let's step through the buffer (in groups of three bytes) and encode it...
+		while (iLen >= 3)
+		{
+			*(pOutput++) = old_cb64[(unsigned char)pInput[0] >> 2];
+			*(pOutput++) = old_cb64[(((unsigned char)pInput[0] & 0x03) << 4) | (((unsigned char)pInput[1] & 0xF0) >> 4)];
+			*(pOutput++) = old_cb64[(((unsigned char)pInput[1] & 0x0F) << 2) | (((unsigned char)pInput[2] & 0xC0) >> 6)];
+			*(pOutput++) = old_cb64[(unsigned char)pInput[2] & 0x3F];
+			iLen -= 3;
+			pInput += 3;
+		}
+
+		//do we have some chars left?
+		if (iLen != 0)
+		{
+			*(pOutput++) = old_cb64[(unsigned char)pInput[0] >> 2];
+
+			if (iLen == 1)
+			{
+				*(pOutput++) = old_cb64[((unsigned char)pInput[0] & 0x03) << 4];
+			}
+			else // iLen == 2
+			{
+				*(pOutput++) = old_cb64[(((unsigned char)pInput[0] & 0x03) << 4) | (((unsigned char)pInput[1] & 0xF0) >> 4)];
+				*(pOutput++) = old_cb64[(((unsigned char)pInput[1] & 0x0F) << 2)];
+			}
+		}
+
+		while (pad && pOutput < m_pEncodedBuf + iEncodedLen)
+			*(pOutput++) = '=';
+
+		// Null terminate
+		*pOutput = 0;
+
+		return m_pEncodedBuf;
+	}
+
+	char* Decode(const char* pEncodedBuf, int *iOutLen)
+	{
+		int iDecodedLen;
+		int iLen, iBlock, i;
+		if (iOutLen)
+			*iOutLen = 0;
+
+		// allocate buffer to hold the decoded string:
+		const int iEncodedLen = (int)strlen(pEncodedBuf);
+		iDecodedLen = static_cast<int>(3 * (iEncodedLen / 4.f));
+
+		// remove padding from decoded length
+		for(int i = iEncodedLen - 1; i >= 0 && pEncodedBuf[i] == '='; --i, --iDecodedLen);
+		if (iDecodedLen < 0)
+			return NULL;
+
+		delete [] m_pDecodedBuf;
+		m_pDecodedBuf = new char[iDecodedLen + 4];
+
+		// allocate a local scratch buffer for decoding - work with BYTE's to avoid fatal sign extensions by compiler:
+		char* pInput = new char[iEncodedLen+1];
+		strcpy(pInput, pEncodedBuf);
+
+		// Loop for each byte of input:
+		iLen = iBlock = i = 0;
+		while (pInput[iBlock+i])
+		{
+			if ((unsigned char)pInput[iBlock+i] < 0x2B || (unsigned char)pInput[iBlock+i] > 0x7A)
+			{
+				delete [] pInput;
+				return NULL;
+			}
+			if (pInput[iBlock+i] == '=')
+				break;
+			pInput[iBlock+i] = old_cd64[(unsigned char)pInput[iBlock+i] - 0x2B];
+			if (pInput[iBlock+i] == '$')
+			{
+				delete [] pInput;
+				return NULL;
+			}
+			pInput[iBlock+i] -= 0x3E;
+
+			switch(i++)
+			{
+				// case 0: no data to copy yet!
+			case 1:
+				m_pDecodedBuf[iLen++] = ((unsigned char)pInput[iBlock+0] << 2 | (unsigned char)pInput[iBlock+1] >> 4);
+				break;
+			case 2:
+				m_pDecodedBuf[iLen++] = ((unsigned char)pInput[iBlock+1] << 4 | (unsigned char)pInput[iBlock+2] >> 2);
+				break;
+			case 3:
+				m_pDecodedBuf[iLen++] = ((((unsigned char)pInput[iBlock+2] << 6) & 0xC0) | (unsigned char)pInput[iBlock+3]);
+				i = 0;
+				iBlock += 4;
+				break;
+			}
+		}
+
+		// clean and check:
+		delete [] pInput;
+		if (iLen != iDecodedLen)
+			return NULL;
+
+		// done:
+		if (iOutLen)
+			*iOutLen = iLen;
+		return m_pDecodedBuf;
+	}
+
+private:
+	char* m_pEncodedBuf;
+	char* m_pDecodedBuf;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+static unsigned int g_seed = 1;
+static unsigned int Rand() // xorshift32, reproducible across platforms
+{
+	g_seed ^= g_seed << 13;
+	g_seed ^= g_seed >> 17;
+	g_seed ^= g_seed << 5;
+	return g_seed;
+}
+
+static int g_failures = 0;
+static void Fail(const char* what, const std::string& input)
+{
+	if (++g_failures <= 20)
+	{
+		printf("FAILED: %s, input (%d bytes):", what, (int)input.size());
+		for (size_t i = 0; i < input.size() && i < 64; i++)
+			printf(" %02x", (unsigned char)input[i]);
+		printf("%s\n", input.size() > 64 ? " ..." : "");
+	}
+}
+
+static void CheckEncode(const std::string& data, bool pad)
+{
+	Base64 b64;
+	OldBase64 old;
+	const char* pNew = b64.Encode(data.data(), (int)data.size(), pad);
+	const char* pOld = old.Encode(data.data(), (int)data.size(), pad);
+	if (!pNew || strcmp(pNew, pOld))
+	{
+		Fail(pad ? "Encode() (padded) differs" : "Encode() differs", data);
+		return;
+	}
+	if (Base64::EncodedSize((int)data.size(), pad) != (int)strlen(pNew))
+		Fail("EncodedSize() differs from Encode()", data);
+
+	// caller-owned buffers, exact size and one byte short
+	std::string out(strlen(pNew), '\0');
+	if (Base64::EncodeTo(data.data(), (int)data.size(), pad, &out[0], (int)out.size()) != (int)out.size() || out != pNew)
+		Fail("EncodeTo() differs from Encode()", data);
+	if (!out.empty() && Base64::EncodeTo(data.data(), (int)data.size(), pad, &out[0], (int)out.size() - 1) != -1)
+		Fail("EncodeTo() accepted a short buffer", data);
+
+	// round trip
+	int iLen = -1;
+	const char* pDecoded = b64.Decode(pNew, &iLen);
+	if (!pDecoded || iLen != (int)data.size() || memcmp(pDecoded, data.data(), iLen))
+		Fail(pad ? "Decode(Encode()) (padded) round trip" : "Decode(Encode()) round trip", data);
+}
+
+// both implementations must accept/reject the same inputs and return the same data
+static void CheckDecode(const std::string& input)
+{
+	Base64 b64;
+	OldBase64 old;
+	int iNewLen = -1, iOldLen = -1;
+	const char* pNew = b64.Decode(input.c_str(), &iNewLen);
+	const char* pOld = old.Decode(input.c_str(), &iOldLen);
+	if (!pNew != !pOld || iNewLen != iOldLen || (pNew && memcmp(pNew, pOld, iNewLen)))
+	{
+		Fail(pNew ? (pOld ? "Decode() returns different data" : "Decode() accepts input the original rejects")
+		          : "Decode() rejects input the original accepts", input);
+		return;
+	}
+
+	// caller-owned buffers (Decode() stops at the first null char, damaged inputs can hold some)
+	const int iInputLen = (int)strlen(input.c_str());
+	const int iSize = Base64::DecodedSize(input.c_str(), iInputLen);
+	std::string out(iSize > 0 ? iSize : 0, '\0');
+	const int iDecoded = iSize >= 0 ? Base64::DecodeTo(input.c_str(), iInputLen, &out[0], iSize) : -1;
+	if (pNew ? (iDecoded != iNewLen || memcmp(out.data(), pNew, iNewLen)) : iDecoded != -1)
+		Fail("DecodeTo() differs from Decode()", input);
+}
+
+static std::string RandomBytes(int iLen)
+{
+	std::string s(iLen, '\0');
+	for (int i = 0; i < iLen; i++)
+		s[i] = (char)(Rand() & 0xFF);
+	return s;
+}
+
+// mostly valid chars, with some padding and junk mixed in
+static std::string RandomEncoded(int iLen)
+{
+	static const char junk[] = "=\t\n -.,*!~\x7F\x80\xFF";
+	std::string s(iLen, '\0');
+	for (int i = 0; i < iLen; i++)
+	{
+		const unsigned int r = Rand() % 100;
+		s[i] = r < 85 ? old_cb64[Rand() & 0x3F] : r < 95 ? '=' : junk[Rand() % (sizeof(junk) - 1)];
+	}
+	return s;
+}
+
+int main(int argc, char* argv[])
+{
+	const int iIterations = argc > 1 ? atoi(argv[1]) : 100000;
+	g_seed = argc > 2 ? (unsigned int)strtoul(argv[2], NULL, 10) : 0x5735u;
+	if (!g_seed)
+		g_seed = 1;
+
+	// edge cases
+	static const char* const s_cases[] = {
+		"", "=", "==", "===", "====", "A", "AA", "AAA", "AAAA", "AA==", "AAA=", "AA=", "A===",
+		"AAAA=", "AAAA==", "AA=A", "AA==AAAA", "AAAA====", "QUJD", "QUJDRA", "QUJDRA==", "QUJDRA=",
+		"QU JD", "QUJD\n", "*UJD", "QUJ{", "QUJ@", "QUJ[", "QUJ`", "+/+/", "-_-_",
+	};
+	for (size_t i = 0; i < sizeof(s_cases) / sizeof(s_cases[0]); i++)
+		CheckDecode(s_cases[i]);
+
+	// sizes
+	for (int i = 0; i <= 1000; i++)
+		for (int pad = 0; pad < 2; pad++)
+		{
+			OldBase64 old;
+			std::string data(i, 'x');
+			if (Base64::EncodedSize(i, !!pad) != (int)strlen(old.Encode(data.data(), i, !!pad)))
+				Fail("EncodedSize()", data);
+		}
+	if (Base64::EncodedSize(INT_MAX, false) != -1 || Base64::EncodedSize(INT_MAX, true) != -1)
+		Fail("EncodedSize() overflow not rejected", std::string());
+	if (Base64::EncodedSize(1 << 29, true) != 4 * (((1 << 29) + 2) / 3))
+		Fail("EncodedSize() of 512MB", std::string());
+
+	for (int n = 0; n < iIterations; n++)
+	{
+		const int iLen = (Rand() & 7) ? Rand() % 64 : Rand() % 4096;
+
+		// random data, round trips and old/new encodings
+		const std::string data = RandomBytes(iLen);
+		CheckEncode(data, false);
+		CheckEncode(data, true);
+
+		// valid encodings, as is and damaged
+		OldBase64 old;
+		std::string encoded = old.Encode(data.data(), iLen, !!(Rand() & 1));
+		CheckDecode(encoded);
+		if (!encoded.empty())
+		{
+			switch (Rand() % 4)
+			{
+			case 0: encoded[Rand() % encoded.size()] = (char)(Rand() & 0xFF); break;
+			case 1: encoded.insert(Rand() % encoded.size(), 1, '='); break;
+			case 2: encoded.erase(Rand() % encoded.size(), 1); break;
+			case 3: encoded.append(1 + Rand() % 3, '='); break;
+			}
+			CheckDecode(encoded);
+		}
+
+		// garbage
+		CheckDecode(RandomEncoded(Rand() % 64));
+	}
+
+	if (g_failures)
+		printf("%d failure(s)\n", g_failures);
+	else
+		printf("OK, %d iterations\n", iIterations);
+	return g_failures ? 1 : 0;
+}
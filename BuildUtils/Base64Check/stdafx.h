@@ -0,0 +1,4 @@
+// Minimal precompiled header stand-in so ../../Utility/Base64.cpp builds standalone
+// in Base64Check.cpp, without the REAPER/SWS headers
+#pragma once
+#include <WDL/heapbuf.h>
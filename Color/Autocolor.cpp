@@ -735,7 +735,6 @@ void ApplyColorRuleToTrack(FlatSet<SWS_RuleTrack> *activeRules, SWS_RuleItem* ru
 			UpdateCustomColors();
 
 		// Check all tracks for matching strings/properties
-		MediaTrack* temp = NULL;
 		const int numTracks = GetNumTracks();
 		activeRules->reserve(numTracks);
 		for (int i = 0; i <= numTracks; i++)
@@ -774,14 +773,13 @@ void ApplyColorRuleToTrack(FlatSet<SWS_RuleTrack> *activeRules, SWS_RuleItem* ru
 					if (strcmp(rule->m_str_filter.Get(), cFilterTypes[AC_FOLDER]) == 0)
 					{
 						int iType;
-						GetFolderDepth(tr, &iType, &temp);
+						GetFolderDepth(tr, &iType);
 						if (iType == 1)
 							bMatch = true;
 					}
 					else if (strcmp(rule->m_str_filter.Get(), cFilterTypes[AC_CHILDREN]) == 0)
 					{
-						temp = CSurf_TrackFromID(0, false); // JFB fix: 'temp' could be out of sync
-						if (GetFolderDepth(tr, NULL, &temp) >= 1)
+						if (GetFolderDepth(tr) >= 1)
 							bMatch = true;
 					}
 					else if (strcmp(rule->m_str_filter.Get(), cFilterTypes[AC_RECEIVE]) == 0)
@@ -73,6 +73,7 @@ protected:
 	void SetItemText(SWS_ListItem* item, int iCol, const char* str);
 	void GetItemText(SWS_ListItem* item, int iCol, char* str, int iStrMax);
 	void GetItemList(SWS_ListItemList* pList);
+	bool GetItemSortKey(SWS_ListItem* item, int iCol, SWS_SortKey* key) { return GetTextSortKey(item, iCol, key); }
 	void OnItemDblClk(SWS_ListItem* item, int iCol);
 	void OnItemSelChanged(SWS_ListItem* item, int iState);
 	void OnBeginDrag(SWS_ListItem* item);
@@ -338,12 +338,11 @@ void ColorChildren(COMMAND_T* = NULL)
 	int iParentDepth;
 	COLORREF crParentColor;
 	bool bSelected = false;
-	MediaTrack* gfd = NULL;
 	for (int i = 1; i <= GetNumTracks(); i++)
 	{
 		MediaTrack* tr = CSurf_TrackFromID(i, false);
 		int iType;
-		int iFolder = GetFolderDepth(tr, &iType, &gfd);
+		int iFolder = GetFolderDepth(tr, &iType);
 
 		if (bSelected)
 			GetSetMediaTrackInfo(tr, "I_CUSTOMCOLOR", &crParentColor);
@@ -349,12 +349,11 @@ void ParseTrackId(char* strId, bool bReset)
 	{
 		int iParentDepth;
 		bool bSelected = false;
-		MediaTrack* gfd = NULL;
 		for (int i = 0; i < GetNumTracks(); i++)
 		{
 			MediaTrack* tr = CSurf_TrackFromID(i+1, false);
 			int iType;
-			int iFolder = GetFolderDepth(tr, &iType, &gfd);
+			int iFolder = GetFolderDepth(tr, &iType);
 
 			if (bSelected)
 				g_selTracks.Get()[i] = 1;
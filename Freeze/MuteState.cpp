@@ -52,22 +52,16 @@ MuteItem::MuteItem(LineParser* lp)
 MuteState::MuteState(MediaTrack* tr)
 {	// Remember states of this track
 	int iType;
-	MediaTrack* gfd = NULL;
-	int iFolder = GetFolderDepth(tr, &iType, &gfd);
+	GetFolderDepth(tr, &iType);
 	if (iType == 1)
 	{
-		int iChild = CSurf_TrackToID(tr, false) + 1;
-		while(true)
+		const int iLastChild = GetFolderSubtreeEnd(tr);
+		for (int iChild = CSurf_TrackToID(tr, false) + 1; iChild <= iLastChild; iChild++)
 		{
-			MediaTrack* trChild = CSurf_TrackFromID(iChild++, false);
-			if (!trChild)
-				break;
-			int iChildFolder = GetFolderDepth(trChild, &iType, &gfd);
+			MediaTrack* trChild = CSurf_TrackFromID(iChild, false);
 			GUID* guid = (GUID*)GetSetMediaTrackInfo(trChild, "GUID", NULL);
 			bool bMute = *(bool*)GetSetMediaTrackInfo(trChild, "B_MUTE", NULL);
 			m_children.Add(new MuteItem(guid, bMute));
-			if (iChildFolder + iType <= iFolder)
-				break;
 		}
 	}
 
@@ -109,22 +103,16 @@ void MuteState::Restore(MediaTrack* tr)
 	if (m_children.GetSize())
 	{
 		int iType;
-		MediaTrack* gfd = NULL;
-		int iFolder = GetFolderDepth(tr, &iType, &gfd);
+		GetFolderDepth(tr, &iType);
 		if (iType == 1)
 		{
-			int iChild = CSurf_TrackToID(tr, false) + 1;
-			while(true)
+			const int iLastChild = GetFolderSubtreeEnd(tr);
+			for (int iChild = CSurf_TrackToID(tr, false) + 1; iChild <= iLastChild; iChild++)
 			{
-				MediaTrack* trChild = CSurf_TrackFromID(iChild++, false);
-				if (!trChild)
-					break;
-				int iChildFolder = GetFolderDepth(trChild, &iType, &gfd);
+				MediaTrack* trChild = CSurf_TrackFromID(iChild, false);
 				for (int i = 0; i < m_children.GetSize(); i++)
 					if (TrackMatchesGuid(trChild, &m_children.Get(i)->m_guid))
 						GetSetMediaTrackInfo(trChild, "B_MUTE", &m_children.Get(i)->m_bState);
-				if (iChildFolder + iType <= iFolder)
-					break;
 			}
 		}
 	}
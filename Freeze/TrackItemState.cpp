@@ -74,14 +74,8 @@ ItemState::ItemState(MediaItem* mi)
 MediaItem* ItemState::FindItem(MediaTrack* tr)
 {
 	// Find the media item in the track
-	MediaItem* mi = NULL;
-	for (int i = 0; i < GetTrackNumMediaItems(tr); i++)
-	{
-		mi = GetTrackMediaItem(tr, i);
-		if (GuidsEqual(&m_guid, (GUID*)GetSetMediaItemInfo(mi, "GUID", NULL)))
-			return mi;
-	}
-	return NULL;
+	MediaItem* mi = GuidToMediaItem(NULL, &m_guid);
+	return mi && GetMediaItem_Track(mi) == tr ? mi : NULL;
 }
 
 void ItemState::Restore(MediaTrack* tr, bool bSelOnly)
@@ -176,6 +176,18 @@ int SWS_MarkerListView::OnItemSort(SWS_ListItem* item1, SWS_ListItem* item2)
 	return SWS_ListView::OnItemSort(item1, item2);
 }
 
+bool SWS_MarkerListView::GetItemSortKey(SWS_ListItem* item, int iCol, SWS_SortKey* key)
+{
+	MarkerItem* mi = (MarkerItem*)item;
+	if (iCol == 0 || iCol == 2)
+	{
+		key->bNum = true;
+		key->dNum = iCol == 0 ? mi->GetPos() : mi->GetNum();
+		return true;
+	}
+	return GetTextSortKey(item, iCol, key);
+}
+
 void SWS_MarkerListView::SetItemText(SWS_ListItem* item, int iCol, const char* str)
 {
 	if (iCol == 3)
@@ -42,6 +42,7 @@ protected:
 	void OnItemClk(SWS_ListItem* item, int iCol, int iKeyState);
 	void OnItemDblClk(SWS_ListItem* item, int iCol);
 	int  OnItemSort(SWS_ListItem* item1, SWS_ListItem* item2);
+	bool GetItemSortKey(SWS_ListItem* item, int iCol, SWS_SortKey* key);
 	void GetItemList(SWS_ListItemList* pList);
 	int  GetItemState(SWS_ListItem* item);
 
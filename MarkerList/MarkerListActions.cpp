@@ -37,10 +37,7 @@
 
 void ListToClipboard(COMMAND_T*)
 {
-	if (!g_curList)
-		g_curList = new MarkerList("CurrentList", true);
-	else
-		g_curList->BuildFromReaper();
+	g_pMarkerList->Update(); // (re)builds g_curList, also keeps the list view in sync with its items
 	g_curList->ListToClipboard();
 }
 
@@ -63,10 +60,7 @@ void ExportToClipboard(COMMAND_T*)
 	char format[256];
 	GetPrivateProfileString(SWS_INI, EXPORT_FORMAT_KEY, EXPORT_FORMAT_DEFAULT, format, 256, get_ini_file());
 
-	if (!g_curList)
-		g_curList = new MarkerList("CurrentList", true);
-	else
-		g_curList->BuildFromReaper();
+	g_pMarkerList->Update(); // (re)builds g_curList, also keeps the list view in sync with its items
 
 	g_curList->ExportToClipboard(format);
 }
@@ -76,10 +70,7 @@ void ExportToFile(COMMAND_T*)
 	char format[256];
 	GetPrivateProfileString(SWS_INI, EXPORT_FORMAT_KEY, EXPORT_FORMAT_DEFAULT, format, 256, get_ini_file());
 
-	if (!g_curList)
-		g_curList = new MarkerList("CurrentList", true);
-	else
-		g_curList->BuildFromReaper();
+	g_pMarkerList->Update(); // (re)builds g_curList, also keeps the list view in sync with its items
 
 	g_curList->ExportToFile(format);
 }
@@ -2377,6 +2377,7 @@ void AWBusDelete(COMMAND_T* t)
 			if (GetMediaTrackInfo_Value(GetSelectedTrack(0, i), "I_FOLDERDEPTH") == 1)
 				SetMediaTrackInfo_Value(GetSelectedTrack(0, i), "I_FOLDERDEPTH", 0);
 		}
+		InvalidateFolderIndex();
 	}
 
 	SmartRemove(NULL);
@@ -29,49 +29,182 @@
 
 #include "Analysis.h"
 #include "../sws_waitdlg.h"
+#include "../libebur128/ebur128.h"
 
 #include <WDL/localize/localize.h>
+#include <WDL/sha.h>
+
+#include <thread>
 
 static void GetRMSOptions(double *target, double *windowSize);
 
+/****** Analysis buffers ******/
+// Sample buffers are pooled and reused by subsequent analyses instead of being allocated for every item,
+// one set per concurrently running analysis. Very big ones (long RMS windows) aren't kept around
+#define ANALYSIS_POOL_SIZE        8
+#define ANALYSIS_POOL_MAX_SAMPLES (4*1024*1024)
+#define ANALYSIS_CHUNK            2048 // frames
+
+struct AnalysisChannel
+{
+	double sumSquares;    // entire item
+	double sum;           // for DC offset
+	double peak;
+	double winSumSquares; // current window
+	double maxWinSumSquares;
+	INT64 peakSample;
+	INT64 maxWinSample;   // end of window with max sum of squares, -1 if none
+	INT64 clips;
+};
+
+struct AnalysisBuffers
+{
+	WDL_TypedBuf<ReaSample> cur, prev; // interleaved blocks as returned by GetSamples(), previous one only in windowed mode
+	WDL_TypedBuf<AnalysisChannel> channels;
+};
+
+static SWS_Mutex g_analysisBuffersMutex;
+static WDL_PtrList<AnalysisBuffers> g_analysisBuffers;
+
+static AnalysisBuffers* GetAnalysisBuffers()
+{
+	SWS_SectionLock lock(&g_analysisBuffersMutex);
+	const int last = g_analysisBuffers.GetSize() - 1;
+	if (last < 0)
+		return new (nothrow) AnalysisBuffers;
+
+	AnalysisBuffers* buffers = g_analysisBuffers.Get(last);
+	g_analysisBuffers.Delete(last, false);
+	return buffers;
+}
+
+static void ReleaseAnalysisBuffers(AnalysisBuffers* buffers)
+{
+	SWS_SectionLock lock(&g_analysisBuffersMutex);
+	if (g_analysisBuffers.GetSize() < ANALYSIS_POOL_SIZE && buffers->cur.GetSize() <= ANALYSIS_POOL_MAX_SAMPLES)
+		g_analysisBuffers.Add(buffers);
+	else
+		delete buffers;
+}
+
+// Per lane accumulators of AnalyzeChannelBlock()
+struct AnalysisLanes
+{
+	double ss[4], sum[4], peak[4], clips[4], w[4], maxW[4];
+	int maxPos[4];
+};
+
+template <bool windowed>
+static inline void AnalyzeSample(AnalysisLanes& l, int j, int s, double v, double vPrev)
+{
+	const double absv = fabs(v);
+	l.ss[j] += v * v;
+	l.sum[j] += v;
+	l.peak[j] = absv > l.peak[j] ? absv : l.peak[j];
+	l.clips[j] += absv >= 1.0 ? 1.0 : 0.0;
+	if (windowed)
+	{
+		l.w[j] += v * v - vPrev * vPrev;
+		const bool newMax = l.w[j] > l.maxW[j];
+		l.maxW[j] = newMax ? l.w[j] : l.maxW[j];
+		l.maxPos[j] = newMax ? s : l.maxPos[j];
+	}
+}
+
+// Analyzes one channel of an interleaved block, returns block peak.
+// The block is split into 4 segments that are summed in independent lanes, so the loop isn't serialized by
+// its dependency chains and has no branches. Windowed: window length equals block length, so the window ending
+// at sample i of the current block starts right after sample i of the previous one. Every lane tracks its max
+// relative to its own start (offsets are only known at the end but don't change where the max is), on the sum
+// of squares, sqrt happens only once when analysis is done
+template <bool windowed>
+static double AnalyzeChannelBlock(const ReaSample* x, const ReaSample* prev, int n, int nch, INT64 blockStart, AnalysisChannel* c)
+{
+	AnalysisLanes l;
+	for (int j = 0; j < 4; j++)
+	{
+		l.ss[j] = l.sum[j] = l.peak[j] = l.clips[j] = l.w[j] = 0.0;
+		l.maxW[j] = -DBL_MAX;
+		l.maxPos[j] = -1;
+	}
+
+	const int m = n / 4;
+	for (int i = 0; i < m; i++)
+		for (int j = 0; j < 4; j++)
+		{
+			const int s = j*m + i;
+			AnalyzeSample<windowed>(l, j, s, x[s * nch], windowed ? prev[s * nch] : 0.0);
+		}
+
+	// Last lane also takes whatever doesn't fit into the segments
+	for (int s = 4*m; s < n; s++)
+		AnalyzeSample<windowed>(l, 3, s, x[s * nch], windowed ? prev[s * nch] : 0.0);
+
+	c->sumSquares += (l.ss[0] + l.ss[1]) + (l.ss[2] + l.ss[3]);
+	c->sum += (l.sum[0] + l.sum[1]) + (l.sum[2] + l.sum[3]);
+	c->clips += (INT64)((l.clips[0] + l.clips[1]) + (l.clips[2] + l.clips[3]));
+
+	if (windowed)
+	{
+		// Segments are in time order, so strict comparison keeps the earliest max.
+		// Rounding errors could make sums slightly negative, doesn't matter for max tracking
+		double offset = c->winSumSquares;
+		for (int j = 0; j < 4; j++)
+		{
+			if (l.maxPos[j] >= 0 && offset + l.maxW[j] > c->maxWinSumSquares)
+			{
+				c->maxWinSumSquares = offset + l.maxW[j];
+				c->maxWinSample = blockStart + l.maxPos[j];
+			}
+			offset += l.w[j];
+		}
+		c->winSumSquares = offset;
+	}
+
+	const double p01 = l.peak[0] > l.peak[1] ? l.peak[0] : l.peak[1];
+	const double p23 = l.peak[2] > l.peak[3] ? l.peak[2] : l.peak[3];
+	return p01 > p23 ? p01 : p23;
+}
+
 static bool AnalyzePCMSource(ANALYZE_PCM* a)
 {
-	// Init local transfer block "t" and sum of squares
+	AnalysisBuffers* buffers = GetAnalysisBuffers();
+	if (!buffers)
+		return false;
+
+	// Init local transfer block "t"
 	PCM_source_transfer_t t={0,};
 	t.samplerate = a->pcm->GetSampleRate();
 	t.nch = a->pcm->GetNumChannels();
 	t.length = a->dWindowSize == 0.0 ? 16384 : (int)(a->dWindowSize * t.samplerate);
-	t.samples = new (nothrow) ReaSample[t.length * t.nch];
-
-	if(!t.samples)
-		return false;
 
-	ReaSample* prevBuf = NULL;
-	INT64 tempPeakRMSsample = 0;
-	if (a->dWindowSize != 0.0)
+	const bool windowed = a->dWindowSize != 0.0;
+	const int bufSize = t.length * t.nch;
+	t.samples = buffers->cur.ResizeOK(bufSize, false);
+	ReaSample* prevBuf = windowed ? buffers->prev.ResizeOK(bufSize, false) : NULL;
+	AnalysisChannel* channels = buffers->channels.ResizeOK(t.nch, false);
+	if (!t.samples || (windowed && !prevBuf) || !channels)
 	{
-		if((prevBuf = new (nothrow) ReaSample[t.length * t.nch]))
-			memset(prevBuf, 0, t.length * t.nch * sizeof(*prevBuf));
-		else
-			return false;
+		ReleaseAnalysisBuffers(buffers);
+		return false;
 	}
-
-	double* dSumSquares = new double[t.nch];
+	if (prevBuf)
+		memset(prevBuf, 0, bufSize * sizeof(*prevBuf));
+	memset(channels, 0, t.nch * sizeof(*channels));
 	for (int i = 0; i < t.nch; i++)
-		dSumSquares[i] = 0.0;
+		channels[i].maxWinSample = -1;
 
-	// Init output variables.  Note can have different channel count.
-	for (int i = 0; i < a->iChannels; i++)
+	// True peak is measured by libebur128, fed with the same blocks
+	ebur128_state* loudness = NULL;
+	if (a->iMetrics & ANALYZE_TRUEPEAK)
 	{
-		if (a->dPeakVals) a->dPeakVals[i] = 0.0;
-		if (a->dRMSs) a->dRMSs[i] = 0.0;
-		if (a->peakSamples) a->peakSamples[i] = 0;
-		if (a->peakRMSsamples) a->peakRMSsamples[i] = -666;
+		if (!(loudness = ebur128_init((unsigned int)t.nch, (unsigned long)t.samplerate, EBUR128_MODE_TRUE_PEAK)))
+		{
+			ReleaseAnalysisBuffers(buffers);
+			return false;
+		}
 	}
-	a->dPeakVal = 0.0;
-	a->dRMS = 0.0;
-	a->peakRMSsample = -666;
-	a->peakSample = 0;
+
 	a->dProgress = 0.0;
 	a->sampleCount = 0;
 
@@ -79,50 +212,41 @@ static bool AnalyzePCMSource(ANALYZE_PCM* a)
 	int iFrame = 0;
 
 	a->pcm->GetSamples(&t);
-	while (t.samples_out)
+	while (t.samples_out && !(a->bCancel && *a->bCancel))
 	{
-		for (int samp = 0; samp < t.samples_out; samp++)
+		const int n = t.samples_out;
+
+		if (loudness)
+			ebur128_add_frames_double(loudness, t.samples, (size_t)n);
+
+		// Channels are analyzed one after another in cache sized chunks of the (interleaved) block
+		for (int start = 0; start < n; start += ANALYSIS_CHUNK)
 		{
+			const int len = min(ANALYSIS_CHUNK, n - start);
+			const INT64 chunkStart = a->sampleCount + start;
 			for (int chan = 0; chan < t.nch; chan++)
 			{
-				int i = samp*t.nch + chan;
-				dSumSquares[chan] += t.samples[i] * t.samples[i];
-				double absamp = fabs(t.samples[i]);
-				if (absamp > a->dPeakVal)
-				{
-					a->dPeakVal = absamp;
-					a->peakSample = a->sampleCount;
-				}
+				AnalysisChannel* c = &channels[chan];
+				const ReaSample* x = t.samples + start * t.nch + chan;
+				const double chunkPeak = windowed ?
+					AnalyzeChannelBlock<true>(x, prevBuf + start * t.nch + chan, len, t.nch, chunkStart, c) :
+					AnalyzeChannelBlock<false>(x, NULL, len, t.nch, chunkStart, c);
 
-				if (a->dPeakVals && chan < a->iChannels && absamp > a->dPeakVals[chan])
-				{
-					a->dPeakVals[chan] = absamp;
-					if (a->peakSamples)
-						a->peakSamples[chan] = a->sampleCount;
-				}
-				if (a->dWindowSize != 0.0)
-				{
-					dSumSquares[chan] -= prevBuf[i] * prevBuf[i];
-					if (dSumSquares[chan] < 0.0) // Unlikely but possible with rounding errors
-						dSumSquares[chan] = 0.0;
-					double curRMS = sqrt(dSumSquares[chan] / t.length);
-					if (curRMS > a->dRMS) // Overall
-					{ 
-						a->dRMS = curRMS;
-						tempPeakRMSsample = a->sampleCount;
-					}
-					if (a->dRMSs && curRMS > a->dRMSs[chan]) // Single channel, if enabled
-					{ 
-						a->dRMSs[chan] = curRMS;
-						if (a->peakRMSsamples)
-							a->peakRMSsamples[chan] = a->sampleCount;
-					}
-						
+				if (chunkPeak > c->peak)
+				{	// New peak somewhere in this chunk, only now look for its position
+					c->peak = chunkPeak;
+					for (int i = 0; i < len; i++)
+						if (fabs(x[i * t.nch]) == chunkPeak)
+						{
+							c->peakSample = chunkStart + i;
+							break;
+						}
 				}
 			}
-			a->sampleCount++;
 		}
-		if (a->dWindowSize != 0.0)
+		a->sampleCount += n;
+
+		if (windowed)
 		{	// Swap buffers in windowed mode for history
 			ReaSample* temp = t.samples;
 			t.samples = prevBuf;
@@ -138,36 +262,88 @@ static bool AnalyzePCMSource(ANALYZE_PCM* a)
 		a->pcm->GetSamples(&t);
 	}
 
-	if (a->dWindowSize == 0.0)
+	if (a->bCancel && *a->bCancel)
 	{
-		// Non-windowed mode.  Calculate the RMS for the entire item
-		// First per channel
-		if (a->dRMSs && a->sampleCount)
-			for (int i = 0; i < a->iChannels && i < t.nch; i++)
-				a->dRMSs[i] = sqrt(dSumSquares[i] / a->sampleCount);
-
-		// Then for all channels combined
-		double dSS = 0.0;
-		for (int i = 0; i < t.nch; i++)
-			dSS += dSumSquares[i];
-		a->dRMS = sqrt(dSS / (a->sampleCount * t.nch));
+		if (loudness)
+			ebur128_destroy(&loudness);
+		ReleaseAnalysisBuffers(buffers);
+		return false;
 	}
-	else // calculate pos. of peak RMS samples
-	{	
-		a->peakRMSsample = tempPeakRMSsample - t.length;
 
-		if (a->peakRMSsamples) {
-			for (int chan = 0; chan < t.nch; chan++) {
-				a->peakRMSsamples[chan] -= t.length;
-			}
+	// Collect results.  Note can have different channel count.
+	a->dPeakVal = 0.0;
+	a->peakSample = 0;
+	a->dRMS = 0.0;
+	a->peakRMSsample = -666;
+	a->dAvgRMS = 0.0;
+	a->dTruePeakVal = 0.0;
+	a->clipCount = 0;
+
+	double dSS = 0.0;
+	double dMaxWinSS = 0.0;
+	INT64 maxWinSample = -1;
+	for (int chan = 0; chan < t.nch; chan++)
+	{
+		const AnalysisChannel& c = channels[chan];
+
+		// Overall values come from the earliest channel max, same as scanning samples in order
+		if (c.peak > a->dPeakVal || (c.peak == a->dPeakVal && c.peak > 0.0 && c.peakSample < a->peakSample))
+		{
+			a->dPeakVal = c.peak;
+			a->peakSample = c.peakSample;
+		}
+		if (c.maxWinSample >= 0 && (c.maxWinSumSquares > dMaxWinSS || (c.maxWinSumSquares == dMaxWinSS && c.maxWinSample < maxWinSample)))
+		{
+			dMaxWinSS = c.maxWinSumSquares;
+			maxWinSample = c.maxWinSample;
 		}
+		dSS += c.sumSquares;
+		a->clipCount += c.clips;
+	}
 
+	// RMS over the entire item, available in both modes
+	if (a->sampleCount)
+		a->dAvgRMS = sqrt(dSS / (a->sampleCount * t.nch));
+
+	if (!windowed)
+		a->dRMS = a->dAvgRMS;
+	else if (maxWinSample >= 0) // calculate pos. of peak RMS samples
+	{
+		a->dRMS = sqrt(dMaxWinSS / t.length);
+		a->peakRMSsample = maxWinSample - t.length;
 	}
 
-	delete[] t.samples;
-	delete[] prevBuf;
-	delete[] dSumSquares;
+	for (int i = 0; i < a->iChannels; i++)
+	{
+		const bool valid = i < t.nch;
+		const AnalysisChannel& c = channels[valid ? i : 0];
+		const double dAvgRMS = valid && a->sampleCount ? sqrt(c.sumSquares / a->sampleCount) : 0.0;
+
+		if (a->dPeakVals)      a->dPeakVals[i] = valid ? c.peak : 0.0;
+		if (a->peakSamples)    a->peakSamples[i] = valid ? c.peakSample : 0;
+		if (a->dAvgRMSs)       a->dAvgRMSs[i] = dAvgRMS;
+		if (a->dDCOffsets)     a->dDCOffsets[i] = valid && a->sampleCount ? c.sum / a->sampleCount : 0.0;
+		if (a->clipCounts)     a->clipCounts[i] = valid ? c.clips : 0;
+		if (a->dTruePeakVals)  a->dTruePeakVals[i] = 0.0;
+		if (a->dRMSs)          a->dRMSs[i] = windowed ? (valid ? sqrt(c.maxWinSumSquares / t.length) : 0.0) : dAvgRMS;
+		if (a->peakRMSsamples) a->peakRMSsamples[i] = windowed && valid && c.maxWinSample >= 0 ? c.maxWinSample - t.length : -666;
+	}
+
+	if (loudness)
+	{
+		for (int i = 0; i < t.nch; i++)
+		{
+			double truePeak = 0.0, truePeakPos = 0.0;
+			ebur128_true_peak(loudness, (unsigned int)i, &truePeak, &truePeakPos);
+			if (truePeak > a->dTruePeakVal)
+				a->dTruePeakVal = truePeak;
+			if (a->dTruePeakVals && i < a->iChannels)
+				a->dTruePeakVals[i] = truePeak;
+		}
+		ebur128_destroy(&loudness);
+	}
 
+	ReleaseAnalysisBuffers(buffers);
 	return true;
 }
 
@@ -179,45 +355,417 @@ unsigned int WINAPI AnalyzePCMThread(void* pAnalyze)
 	return 0;
 }
 
-// return true for successful analysis
-// wraps AnalyzePCM to check item validity and create a wait dialog
-bool AnalyzeItem(MediaItem* item, ANALYZE_PCM* a)
+/****** Memoized item analysis ******/
+// Every analysis runs with all channel arrays and is kept per item, so subsequent requests for the same item
+// (i.e. a script calling all NF_ peak/RMS functions) are served without decoding the source again.
+// The key covers everything that changes the samples AnalyzeItem() gets from the item
+#define ANALYSIS_MEMO_SIZE 256
+
+struct AnalysisMemo
 {
-	a->dProgress = 0.0;
-	a->pcm = (PCM_source*)item;
+	unsigned char key[WDL_SHA1SIZE];
+	unsigned int lastUse;
+	ANALYZE_PCM a; // arrays point to the buffers below
+	WDL_TypedBuf<double> peakVals, RMSs, avgRMSs, truePeakVals, DCOffsets;
+	WDL_TypedBuf<INT64> peakSamples, peakRMSsamples, clipCounts;
+
+	void Init(int iChannels, double dWindowSize, int iMetrics)
+	{
+		memset(&a, 0, sizeof(a));
+		a.iChannels      = iChannels;
+		a.dWindowSize    = dWindowSize;
+		a.iMetrics       = iMetrics;
+		a.dPeakVals      = peakVals.Resize(iChannels, false);
+		a.dRMSs          = RMSs.Resize(iChannels, false);
+		a.dAvgRMSs       = avgRMSs.Resize(iChannels, false);
+		a.dTruePeakVals  = truePeakVals.Resize(iChannels, false);
+		a.dDCOffsets     = DCOffsets.Resize(iChannels, false);
+		a.peakSamples    = peakSamples.Resize(iChannels, false);
+		a.peakRMSsamples = peakRMSsamples.Resize(iChannels, false);
+		a.clipCounts     = clipCounts.Resize(iChannels, false);
+	}
+};
+
+static map<MediaItem*, AnalysisMemo*> g_analysisMemos;
+static unsigned int g_analysisMemoUse = 0;
+
+// Source samples: the source chain (sections, reversed...) and the file behind it, no audio accessor
+// needed. Replacing/reloading a source creates a new one, the file time covers edits in place
+static void AddSourceToAnalysisKey(WDL_SHA1* sha, PCM_source* source)
+{
+	for (; source; source = source->GetSource())
+	{
+		const double length = source->GetLength(), samplerate = source->GetSampleRate();
+		const int nch = source->GetNumChannels();
+		sha->add(&source, sizeof(source));
+		sha->add(&length, sizeof(length));
+		sha->add(&samplerate, sizeof(samplerate));
+		sha->add(&nch, sizeof(nch));
+
+		const char* fn = source->GetFileName();
+		if (fn && *fn)
+		{
+			sha->add(fn, (int)strlen(fn));
+			struct stat st;
+#ifdef _WIN32
+			if (statUTF8(fn, &st) == 0)
+#else
+			if (stat(fn, &st) == 0)
+#endif
+			{
+				const WDL_INT64 size = (WDL_INT64)st.st_size, mtime = (WDL_INT64)st.st_mtime;
+				sha->add(&size, sizeof(size));
+				sha->add(&mtime, sizeof(mtime));
+			}
+		}
+	}
+}
 
-	if (!a->pcm || strcmp(a->pcm->GetType(), "MIDI") == 0 || strcmp(a->pcm->GetType(), "MIDIPOOL") == 0)
+static bool GetAnalysisKey(MediaItem* item, unsigned char* key)
+{
+	MediaItem_Take* take = GetMediaItemTake(item, -1);
+	if (!take)
 		return false;
 
-	a->pcm = a->pcm->Duplicate();
-	if (!a->pcm || !a->pcm->GetNumChannels())
+	PCM_source* source = GetMediaItemTake_Source(take);
+	if (!source)
 		return false;
 
+	WDL_SHA1 sha;
+	AddSourceToAnalysisKey(&sha, source);
+	sha.add(GetSetMediaItemInfo(item, "GUID", NULL), sizeof(GUID));
+	sha.add(GetSetMediaItemTakeInfo(take, "GUID", NULL), sizeof(GUID));
+
+	static const char* const s_itemParams[] = { "D_LENGTH", "D_VOL", "D_FADEINLEN", "D_FADEOUTLEN", "D_FADEINLEN_AUTO", "D_FADEOUTLEN_AUTO", "D_FADEINDIR", "D_FADEOUTDIR", "C_FADEINSHAPE", "C_FADEOUTSHAPE", "B_LOOPSRC" };
+	static const char* const s_takeParams[] = { "D_STARTOFFS", "D_VOL", "D_PAN", "D_PANLAW", "D_PLAYRATE", "D_PITCH", "B_PPITCH", "I_CHANMODE" };
+	for (int i = 0; i < (int)(sizeof(s_itemParams) / sizeof(s_itemParams[0])); i++)
+	{
+		const double val = GetMediaItemInfo_Value(item, s_itemParams[i]);
+		sha.add(&val, sizeof(val));
+	}
+	for (int i = 0; i < (int)(sizeof(s_takeParams) / sizeof(s_takeParams[0])); i++)
+	{
+		const double val = GetMediaItemTakeInfo_Value(take, s_takeParams[i]);
+		sha.add(&val, sizeof(val));
+	}
+
+	// All take envelopes (volume, pan, mute, pitch...), whole state so that bypass, etc. is taken into account too
+	const int envCount = CountTakeEnvelopes(take);
+	sha.add(&envCount, sizeof(envCount));
+	for (int i = 0; i < envCount; i++)
+	{
+		if (char* state = GetSetObjectState(GetTakeEnvelope(take, i), NULL))
+		{
+			sha.add(state, (int)strlen(state) + 1);
+			FreeHeapPtr(state);
+		}
+	}
+
+	sha.result(key);
+	return true;
+}
+
+static AnalysisMemo* GetAnalysisMemo(MediaItem* item, const unsigned char* key)
+{
+	map<MediaItem*, AnalysisMemo*>::iterator it = g_analysisMemos.find(item);
+	if (it == g_analysisMemos.end())
+		return NULL;
+
+	if (memcmp(it->second->key, key, WDL_SHA1SIZE))
+	{	// item changed, results are useless now
+		delete it->second;
+		g_analysisMemos.erase(it);
+		return NULL;
+	}
+	it->second->lastUse = ++g_analysisMemoUse;
+	return it->second;
+}
+
+static void StoreAnalysisMemo(MediaItem* item, AnalysisMemo* memo)
+{
+	map<MediaItem*, AnalysisMemo*>::iterator it = g_analysisMemos.find(item);
+	if (it != g_analysisMemos.end())
+	{
+		if (it->second != memo)
+			delete it->second;
+		g_analysisMemos.erase(it);
+	}
+	else if (g_analysisMemos.size() >= ANALYSIS_MEMO_SIZE)
+	{
+		map<MediaItem*, AnalysisMemo*>::iterator oldest = g_analysisMemos.begin();
+		for (it = g_analysisMemos.begin(); it != g_analysisMemos.end(); ++it)
+			if (it->second->lastUse < oldest->second->lastUse)
+				oldest = it;
+		delete oldest->second;
+		g_analysisMemos.erase(oldest);
+	}
+
+	memo->lastUse = ++g_analysisMemoUse;
+	g_analysisMemos[item] = memo;
+}
+
+// Copy memoized results into caller's struct, non-windowed requests get overall RMS no matter the memo's window
+static void CopyAnalysis(const ANALYZE_PCM& src, ANALYZE_PCM* dst)
+{
+	const bool windowed = dst->dWindowSize != 0.0;
+	for (int i = 0; i < dst->iChannels; i++)
+	{
+		const bool valid = i < src.iChannels;
+		if (dst->dPeakVals)      dst->dPeakVals[i]      = valid ? src.dPeakVals[i] : 0.0;
+		if (dst->peakSamples)    dst->peakSamples[i]    = valid ? src.peakSamples[i] : 0;
+		if (dst->dRMSs)          dst->dRMSs[i]          = valid ? (windowed ? src.dRMSs[i] : src.dAvgRMSs[i]) : 0.0;
+		if (dst->peakRMSsamples) dst->peakRMSsamples[i] = valid && windowed ? src.peakRMSsamples[i] : -666;
+		if (dst->dAvgRMSs)       dst->dAvgRMSs[i]       = valid ? src.dAvgRMSs[i] : 0.0;
+		if (dst->dTruePeakVals)  dst->dTruePeakVals[i]  = valid ? src.dTruePeakVals[i] : 0.0;
+		if (dst->dDCOffsets)     dst->dDCOffsets[i]     = valid ? src.dDCOffsets[i] : 0.0;
+		if (dst->clipCounts)     dst->clipCounts[i]     = valid ? src.clipCounts[i] : 0;
+	}
+	dst->dPeakVal      = src.dPeakVal;
+	dst->peakSample    = src.peakSample;
+	dst->dRMS          = windowed ? src.dRMS : src.dAvgRMS;
+	dst->peakRMSsample = windowed ? src.peakRMSsample : -666;
+	dst->sampleCount   = src.sampleCount;
+	dst->dAvgRMS       = src.dAvgRMS;
+	dst->dTruePeakVal  = src.dTruePeakVal;
+	dst->clipCount     = src.clipCount;
+	dst->dProgress     = 1.0;
+	dst->success       = true;
+}
+
+// Main thread part of an analysis: checks item validity and either serves results from the memo (returns 0)
+// or sets up the job for AnalyzePCMThread (returns 1). Returns -1 if the item can't be analyzed.
+// A fresh memo is analyzed every time, the old one (if any) stays valid until FinishItemAnalysis() replaces it
+struct AnalysisJob
+{
+	MediaItem* item;
+	ANALYZE_PCM* a;
+	AnalysisMemo* memo;
+	unsigned char key[WDL_SHA1SIZE];
+	bool memoize;
+	double dOldWinSize;
+};
+
+static int PrepareItemAnalysis(MediaItem* item, ANALYZE_PCM* a, AnalysisJob* job)
+{
+	a->dProgress = 0.0;
+	a->success = false;
+	PCM_source* pcm = (PCM_source*)item;
+
+	if (!pcm || strcmp(pcm->GetType(), "MIDI") == 0 || strcmp(pcm->GetType(), "MIDIPOOL") == 0)
+		return -1;
+
+	pcm = pcm->Duplicate();
+	if (!pcm || !pcm->GetNumChannels())
+	{
+		delete pcm;
+		return -1;
+	}
+
 	double dZero = 0.0;
-	GetSetMediaItemInfo((MediaItem*)a->pcm, "D_POSITION", &dZero);
+	GetSetMediaItemInfo((MediaItem*)pcm, "D_POSITION", &dZero);
+
+	job->item = item;
+	job->a = a;
+	job->memo = NULL;
+
+	// window larger than the item's length means non-windowed
+	job->dOldWinSize = a->dWindowSize;
+	if (a->dWindowSize > pcm->GetLength())
+		a->dWindowSize = 0.0;
+
+	job->memoize = GetAnalysisKey(item, job->key);
+	AnalysisMemo* memo = job->memoize ? GetAnalysisMemo(item, job->key) : NULL;
+	if (memo && (a->iMetrics & ~memo->a.iMetrics) == 0 && (a->dWindowSize == 0.0 || a->dWindowSize == memo->a.dWindowSize))
+	{
+		CopyAnalysis(memo->a, a);
+		a->dWindowSize = job->dOldWinSize;
+		delete pcm;
+		return 0;
+	}
+
+	// Analyze everything the memo already had too, so we never end up with less than before
+	job->memo = new AnalysisMemo;
+	job->memo->Init(pcm->GetNumChannels(), (a->dWindowSize == 0.0 && memo) ? memo->a.dWindowSize : a->dWindowSize, a->iMetrics | (memo ? memo->a.iMetrics : 0));
+	job->memo->a.pcm = pcm;
+	job->memo->a.bCancel = a->bCancel;
+	return 1;
+}
+
+static bool FinishItemAnalysis(AnalysisJob* job)
+{
+	ANALYZE_PCM* a = job->a;
+	AnalysisMemo* memo = job->memo;
+
+	delete memo->a.pcm;
+	memo->a.pcm = NULL;
+	memo->a.bCancel = NULL;
 
+	const bool success = memo->a.success;
+	if (success)
+		CopyAnalysis(memo->a, a);
+	a->success = success;
+	a->dProgress = 1.0;
+
+	// restore original window if it was larger than the item's length
+	a->dWindowSize = job->dOldWinSize;
+
+	if (success && job->memoize)
+	{
+		memcpy(memo->key, job->key, WDL_SHA1SIZE);
+		StoreAnalysisMemo(job->item, memo);
+	}
+	else
+		delete memo;
+	job->memo = NULL;
+	return success;
+}
+
+static const char* GetAnalysisName(MediaItem* item)
+{
 	const char* cName = NULL;
 	MediaItem_Take* take = GetMediaItemTake(item, -1);
 	if (take)
 		cName = (const char*)GetSetMediaItemTakeInfo(take, "P_NAME", NULL);
+	return cName ? cName : __LOCALIZE("item","sws_analysis");
+}
 
-	const double oldWinSize = a->dWindowSize;
-	if (a->dWindowSize > a->pcm->GetLength())
-		a->dWindowSize = 0.0;
+// return true for successful analysis
+// wraps AnalyzePCM to check item validity, create a wait dialog and memoize results
+bool AnalyzeItem(MediaItem* item, ANALYZE_PCM* a)
+{
+	AnalysisJob job;
+	const int prepared = PrepareItemAnalysis(item, a, &job);
+	if (prepared <= 0)
+		return prepared == 0;
 
-	HANDLE hThread = (HANDLE)_beginthreadex(NULL, 0, AnalyzePCMThread, a, 0, NULL);
+	HANDLE hThread = (HANDLE)_beginthreadex(NULL, 0, AnalyzePCMThread, &job.memo->a, 0, NULL);
 
 	WDL_String title;
-	title.AppendFormatted(100, __LOCALIZE_VERFMT("Please wait, analyzing %s...","sws_analysis"), cName ? cName : __LOCALIZE("item","sws_analysis"));
-	SWS_WaitDlg wait(title.Get(), &a->dProgress);
+	title.AppendFormatted(100, __LOCALIZE_VERFMT("Please wait, analyzing %s...","sws_analysis"), GetAnalysisName(item));
+	SWS_WaitDlg wait(title.Get(), &job.memo->a.dProgress);
 
 	CloseHandle(hThread);
+	return FinishItemAnalysis(&job);
+}
 
-	// restore original window if it was larger than the item's length
-	a->dWindowSize = oldWinSize;
+/****** Batch analysis ******/
+// Items are analyzed by a pool of worker threads (one duplicated PCM_source per item), a single wait dialog
+// shows overall progress and cancels all of them
+struct AnalysisBatch
+{
+	WDL_PtrList<AnalysisJob> jobs;
+	WDL_TypedBuf<double> lengths;
+	double totalLength;
+	int nextJob;
+	int finishedJobs;
+	int workers;
+	SWS_Mutex mutex;
+	double dProgress;
+	std::atomic<bool> bCancel; // set by the wait dialog (UI thread), polled by the workers
+};
+
+static void AnalysisBatchWorker(AnalysisBatch* batch)
+{
+	while (!batch->bCancel)
+	{
+		AnalysisJob* job = NULL;
+		{
+			SWS_SectionLock lock(&batch->mutex);
+			if (batch->nextJob < batch->jobs.GetSize())
+				job = batch->jobs.Get(batch->nextJob++);
+		}
+		if (!job)
+			break;
+
+		ANALYZE_PCM* a = &job->memo->a;
+		a->success = AnalyzePCMSource(a);
+		a->dProgress = 1.0;
+
+		SWS_SectionLock lock(&batch->mutex);
+		batch->finishedJobs++;
+	}
+}
+
+unsigned int WINAPI AnalysisBatchThread(void* pBatch)
+{
+	AnalysisBatch* batch = static_cast<AnalysisBatch*>(pBatch);
+
+	vector<std::thread> workers;
+	for (int i = 0; i < batch->workers; i++)
+		workers.push_back(std::thread(AnalysisBatchWorker, batch));
+
+	// Overall progress weighted by item length, 1.0 closes the wait dialog so only set it once everything is done
+	bool done = false;
+	while (!done)
+	{
+		Sleep(20);
+		{
+			SWS_SectionLock lock(&batch->mutex);
+			done = batch->finishedJobs >= batch->jobs.GetSize() || batch->bCancel;
+		}
+
+		double progress = 0.0;
+		for (int i = 0; i < batch->jobs.GetSize(); i++)
+			progress += batch->jobs.Get(i)->memo->a.dProgress * batch->lengths.Get()[i];
+		batch->dProgress = min(batch->totalLength > 0.0 ? progress / batch->totalLength : 0.0, 0.99);
+	}
+
+	for (size_t i = 0; i < workers.size(); i++)
+		workers[i].join();
+
+	batch->dProgress = 1.0;
+	return 0;
+}
+
+// Analyze several items at once, every ANALYZE_PCM is set up like for AnalyzeItem() and gets its success flag.
+// Returns false if canceled by the user (results are incomplete then)
+bool AnalyzeItems(MediaItem** items, ANALYZE_PCM* a, int count)
+{
+	AnalysisBatch batch;
+	batch.totalLength = 0.0;
+	batch.nextJob = 0;
+	batch.finishedJobs = 0;
+	batch.dProgress = 0.0;
+	batch.bCancel = false;
+
+	for (int i = 0; i < count; i++)
+	{
+		AnalysisJob* job = new AnalysisJob;
+		a[i].bCancel = &batch.bCancel;
+		if (PrepareItemAnalysis(items[i], &a[i], job) == 1)
+		{
+			const double length = job->memo->a.pcm->GetLength();
+			batch.jobs.Add(job);
+			batch.lengths.Add(length);
+			batch.totalLength += length;
+		}
+		else
+			delete job;
+		a[i].bCancel = NULL;
+	}
+
+	if (batch.jobs.GetSize())
+	{
+		const int hardwareThreads = (int)std::thread::hardware_concurrency();
+		batch.workers = min(batch.jobs.GetSize(), hardwareThreads > 0 ? hardwareThreads : 1);
+
+		HANDLE hThread = (HANDLE)_beginthreadex(NULL, 0, AnalysisBatchThread, &batch, 0, NULL);
+
+		WDL_String title;
+		if (batch.jobs.GetSize() == 1)
+			title.AppendFormatted(100, __LOCALIZE_VERFMT("Please wait, analyzing %s...","sws_analysis"), GetAnalysisName(batch.jobs.Get(0)->item));
+		else
+			title.AppendFormatted(100, __LOCALIZE_VERFMT("Please wait, analyzing %d items...","sws_analysis"), batch.jobs.GetSize());
+		SWS_WaitDlg wait(title.Get(), &batch.dProgress, NULL, &batch.bCancel);
+
+		CloseHandle(hThread);
+
+		for (int i = 0; i < batch.jobs.GetSize(); i++)
+			FinishItemAnalysis(batch.jobs.Get(i));
+		batch.jobs.Empty(true);
+	}
 
-	delete a->pcm;
-	return a->success;
+	return !batch.bCancel;
 }
 
 void DoAnalyzeItem(COMMAND_T*)
@@ -331,20 +879,36 @@ void OrganizeByVol(COMMAND_T* ct)
 	}
 }
 
+// Selected items with an active take and their analysis, analyzed in parallel.  Returns false if canceled
+static bool AnalyzeSelectedItems(double dWindowSize, WDL_TypedBuf<MediaItem*>* items, WDL_TypedBuf<ANALYZE_PCM>* analysis)
+{
+	WDL_TypedBuf<MediaItem*> selItems;
+	SWS_GetSelectedMediaItems(&selItems);
+	for (int i = 0; i < selItems.GetSize(); i++)
+		if (GetMediaItemTake(selItems.Get()[i], -1))
+			items->Add(selItems.Get()[i]);
+
+	ANALYZE_PCM* a = analysis->Resize(items->GetSize());
+	memset(a, 0, items->GetSize() * sizeof(ANALYZE_PCM));
+	for (int i = 0; i < items->GetSize(); i++)
+		a[i].dWindowSize = dWindowSize;
+
+	return AnalyzeItems(items->Get(), a, items->GetSize());
+}
+
 void RMSNormalize(double dTargetDb, double dWindowSize)
 {
 	WDL_TypedBuf<MediaItem*> items;
-	SWS_GetSelectedMediaItems(&items);
-	bool bDidWork = false;
-	ANALYZE_PCM a;
-	memset(&a, 0, sizeof(a));
-	a.dWindowSize = dWindowSize;
+	WDL_TypedBuf<ANALYZE_PCM> analysis;
+	if (!AnalyzeSelectedItems(dWindowSize, &items, &analysis))
+		return;
 
+	bool bDidWork = false;
 	for (int i = 0; i < items.GetSize(); i++)
 	{
-		MediaItem* item = items.Get()[i];
-		MediaItem_Take* take = GetMediaItemTake(item, -1);
-		if (take && AnalyzeItem(item, &a) && a.dRMS != 0.0)
+		const ANALYZE_PCM& a = analysis.Get()[i];
+		MediaItem_Take* take = GetMediaItemTake(items.Get()[i], -1);
+		if (take && a.success && a.dRMS != 0.0)
 		{
 			bDidWork = true;
 			double dVol = *(double*)GetSetMediaItemTakeInfo(take, "D_VOL", NULL);
@@ -362,17 +926,15 @@ void RMSNormalize(double dTargetDb, double dWindowSize)
 void RMSNormalizeAll(double dTargetDb, double dWindowSize)
 {
 	WDL_TypedBuf<MediaItem*> items;
-	SWS_GetSelectedMediaItems(&items);
-	double dMaxRMS = -DBL_MAX;
-	ANALYZE_PCM a;
-	memset(&a, 0, sizeof(a));
-	a.dWindowSize = dWindowSize;
+	WDL_TypedBuf<ANALYZE_PCM> analysis;
+	if (!AnalyzeSelectedItems(dWindowSize, &items, &analysis))
+		return;
 
+	double dMaxRMS = -DBL_MAX;
 	for (int i = 0; i < items.GetSize(); i++)
 	{
-		MediaItem* item = items.Get()[i];
-		MediaItem_Take* take = GetMediaItemTake(item, -1);
-		if (take && AnalyzeItem(item, &a) && a.dRMS != 0.0 && a.dRMS > dMaxRMS)
+		const ANALYZE_PCM& a = analysis.Get()[i];
+		if (a.success && a.dRMS != 0.0 && a.dRMS > dMaxRMS)
 			dMaxRMS = a.dRMS;
 	}
 
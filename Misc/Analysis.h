@@ -27,8 +27,16 @@
 
 #pragma once
 
+#include <atomic>
+
 #define SWS_RMS_KEY "RMS normalize params"
 
+// Extra metrics for ANALYZE_PCM::iMetrics, computed in the same pass as peak/RMS
+enum
+{
+	ANALYZE_TRUEPEAK = 0x01, // 4x oversampled peak (BS.1770), into dTruePeakVal(s)
+};
+
 // Data passing to/from the Analyze functions.
 // All array pointers are caller alloc'ed and optional (NULL)
 typedef struct ANALYZE_PCM
@@ -47,11 +55,23 @@ typedef struct ANALYZE_PCM
 	INT64 sampleCount;      // out # of samples analyzed
 	double dWindowSize;     // RMS window in seconds.  If this is != 0.0, then RMS is calculated/returned as max within window
 	bool success;
+
+	// Everything below is computed in the same pass as the above (zero/NULL disables)
+	int iMetrics;           // in  ANALYZE_* flags for the metrics that need extra work
+	double* dAvgRMSs;       // i/o Array of channel RMS over entire item, also in windowed mode
+	double dAvgRMS;         // out RMS of all channels over entire item, also in windowed mode
+	double* dTruePeakVals;  // i/o Array of channel true peaks (requires ANALYZE_TRUEPEAK)
+	double dTruePeakVal;    // out Maximum true peak over all channels (requires ANALYZE_TRUEPEAK)
+	double* dDCOffsets;     // i/o Array of channel DC offsets (mean sample value)
+	INT64* clipCounts;      // i/o Array of channel counts of clipped samples (>= 0 dBFS)
+	INT64 clipCount;        // out # of clipped samples over all channels
+	std::atomic<bool>* bCancel; // in  Analysis stops (and fails) as soon as this is set, from any thread (optional)
 } ANALYZE_PCM;
 
 int AnalysisInit();
 
-bool AnalyzeItem(MediaItem* mi, ANALYZE_PCM* a);
+bool AnalyzeItem(MediaItem* mi, ANALYZE_PCM* a); // results are memoized until the item or its active take changes
+bool AnalyzeItems(MediaItem** items, ANALYZE_PCM* a, int count); // same as above in parallel, returns false if canceled
 
 // #781 Export to ReaScript
 void NF_GetRMSOptions(double *targetOut, double *winSizeOut);
@@ -65,15 +65,15 @@ void FolderLikePrev(COMMAND_T* = NULL)
 {
 	MediaTrack* prevTr = CSurf_TrackFromID(1, false);
 	bool bUndo = false;
-	MediaTrack* gfd = NULL;
 	for (int i = 2; i <= GetNumTracks(); i++)
 	{
 		MediaTrack* tr = CSurf_TrackFromID(i, false);
 		int iDelta;
-		if (*(int*)GetSetMediaTrackInfo(tr, "I_SELECTED", NULL) && GetFolderDepth(prevTr, NULL, &gfd) != GetFolderDepth(tr, &iDelta, &gfd))
+		if (*(int*)GetSetMediaTrackInfo(tr, "I_SELECTED", NULL) && GetFolderDepth(prevTr, NULL) != GetFolderDepth(tr, &iDelta))
 		{
 			GetSetMediaTrackInfo(tr, "I_FOLDERDEPTH", GetSetMediaTrackInfo(prevTr, "I_FOLDERDEPTH", NULL));
 			GetSetMediaTrackInfo(prevTr, "I_FOLDERDEPTH", &g_i0);
+			InvalidateFolderIndex();
 			bUndo = true;
 		}
 		prevTr = tr;
@@ -106,6 +106,7 @@ void MakeFolder(COMMAND_T* = NULL)
 
 			iDepth = *(int*)GetSetMediaTrackInfo(tr, "I_FOLDERDEPTH", NULL) - 1;
 			GetSetMediaTrackInfo(tr, "I_FOLDERDEPTH", &iDepth);
+			InvalidateFolderIndex();
 		}
 		tr = nextTr;
 	}
@@ -146,6 +147,7 @@ void IndentTracks(const int increment)
 
 		delta = GetMediaTrackInfo_Value(tracks[1], "I_FOLDERDEPTH") - depthChange;
 		SetMediaTrackInfo_Value(tracks[1], "I_FOLDERDEPTH", delta);
+		InvalidateFolderIndex();
 
 		depth += increment;
 		undo = true;
@@ -162,13 +164,12 @@ void IndentTracks(COMMAND_T *cmd)
 
 void CollapseFolder(COMMAND_T* ct)
 {
-	MediaTrack* gfd = NULL;
 	int iCompact = (int)ct->user;
 	for (int i = 1; i <= GetNumTracks(); i++)
 	{
 		MediaTrack* tr = CSurf_TrackFromID(i, false);
 		int iType;
-		GetFolderDepth(tr, &iType, &gfd);
+		GetFolderDepth(tr, &iType);
 		if (*(int*)GetSetMediaTrackInfo(tr, "I_SELECTED", NULL) && iType == 1)
 			GetSetMediaTrackInfo(tr, "I_FOLDERCOMPACT", &iCompact);
 	}
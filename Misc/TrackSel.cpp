@@ -76,12 +76,11 @@ void GetSelFolderTracks(WDL_PtrList<void>* pParents, WDL_PtrList<void>* pChildre
 	WDL_PtrList<void> parentStack;
 	int iParentDepth;
 	bool bSelected = false;
-	MediaTrack* gfd = NULL;
 	for (int i = 0; i <= GetNumTracks(); i++)
 	{
 		tr = CSurf_TrackFromID(i, false);
 		int iType;
-		int iFolder = GetFolderDepth(tr, &iType, &gfd);
+		int iFolder = GetFolderDepth(tr, &iType);
 
 		if (*(int*)GetSetMediaTrackInfo(tr, "I_SELECTED", NULL))
 		{
@@ -165,12 +164,11 @@ void SelTracksWItems(COMMAND_T*)
 
 void SelAllParents(COMMAND_T* = NULL)
 {
-	MediaTrack* gfd = NULL;
 	for (int i = 1; i <= GetNumTracks(); i++)
 	{
 		MediaTrack* tr = CSurf_TrackFromID(i, false);
 		int iType;
-		int iFolder = GetFolderDepth(tr, &iType, &gfd);
+		int iFolder = GetFolderDepth(tr, &iType);
 		if (iFolder == 0 && iType == 1)
 			GetSetMediaTrackInfo(tr, "I_SELECTED", &g_i1);
 		else
@@ -180,12 +178,11 @@ void SelAllParents(COMMAND_T* = NULL)
 
 void SelFolderStarts(COMMAND_T* = NULL)
 {
-	MediaTrack* gfd = NULL;
 	for (int i = 1; i <= GetNumTracks(); i++)
 	{
 		MediaTrack* tr = CSurf_TrackFromID(i, false);
 		int iType;
-		GetFolderDepth(tr, &iType, &gfd);
+		GetFolderDepth(tr, &iType);
 		if (iType == 1)
 			GetSetMediaTrackInfo(tr, "I_SELECTED", &g_i1);
 		else
@@ -195,12 +192,11 @@ void SelFolderStarts(COMMAND_T* = NULL)
 
 void SelNotFolder(COMMAND_T* = NULL)
 {
-	MediaTrack* gfd = NULL;
 	for (int i = 1; i <= GetNumTracks(); i++)
 	{
 		MediaTrack* tr = CSurf_TrackFromID(i, false);
 		int iType;
-		if (GetFolderDepth(tr, &iType, &gfd) == 0 && iType == 0)
+		if (GetFolderDepth(tr, &iType) == 0 && iType == 0)
 			GetSetMediaTrackInfo(tr, "I_SELECTED", &g_i1);
 		else
 			GetSetMediaTrackInfo(tr, "I_SELECTED", &g_i0);
@@ -270,13 +266,12 @@ void SelNextFolder(COMMAND_T* = NULL)
 	int iDepth = -1;
 	int iType;
 	int iFolder;
-	MediaTrack* gfd;
 	for (int i = 1; i <= GetNumTracks(); i++)
 	{
 		MediaTrack* tr = CSurf_TrackFromID(i, false);
 		if (iDepth != -1)
 		{
-			if ((iFolder = GetFolderDepth(tr, &iType, &gfd)) == iDepth && iType == 1)
+			if ((iFolder = GetFolderDepth(tr, &iType)) == iDepth && iType == 1)
 			{
 				ClearSelected();
 				GetSetMediaTrackInfo(tr, "I_SELECTED", &g_i1);
@@ -287,7 +282,7 @@ void SelNextFolder(COMMAND_T* = NULL)
 		}		
 		else if (iDepth == -1 && *(int*)GetSetMediaTrackInfo(tr, "I_SELECTED", NULL))
 		{
-			iFolder = GetFolderDepth(tr, &iType, &gfd);
+			iFolder = GetFolderDepth(tr, &iType);
 			if (iType == 1)
 				iDepth = iFolder;
 		}
@@ -299,13 +294,12 @@ void SelPrevFolder(COMMAND_T* = NULL)
 	int iDepth = -1;
 	int iType;
 	int iFolder;
-	MediaTrack* gfd;
 	for (int i = GetNumTracks(); i > 0; i--)
 	{
 		MediaTrack* tr = CSurf_TrackFromID(i, false);
 		if (iDepth != -1)
 		{
-			if ((iFolder = GetFolderDepth(tr, &iType, &gfd)) == iDepth && iType == 1)
+			if ((iFolder = GetFolderDepth(tr, &iType)) == iDepth && iType == 1)
 			{
 				ClearSelected();
 				GetSetMediaTrackInfo(tr, "I_SELECTED", &g_i1);
@@ -316,7 +310,7 @@ void SelPrevFolder(COMMAND_T* = NULL)
 		}		
 		else if (iDepth == -1 && *(int*)GetSetMediaTrackInfo(tr, "I_SELECTED", NULL))
 		{
-			iFolder = GetFolderDepth(tr, &iType, &gfd);
+			iFolder = GetFolderDepth(tr, &iType);
 			if (iType == 1)
 				iDepth = iFolder;
 		}
@@ -436,24 +430,17 @@ int RoutedTracks(MediaTrack* tr, WDL_PtrList<void>* pTracks)
 
 	// Then check folders
 	int iType;
-	MediaTrack* pNext = NULL;
-	int iDepth = GetFolderDepth(tr, &iType, &pNext);
+	GetFolderDepth(tr, &iType);
 	if (iType == 1)
 	{
-		int iChild = CSurf_TrackToID(tr, false)+1;
-		while(true)
+		const int iLastChild = GetFolderSubtreeEnd(tr);
+		for (int iChild = CSurf_TrackToID(tr, false)+1; iChild <= iLastChild; iChild++)
 		{
 			MediaTrack* pChild = CSurf_TrackFromID(iChild, false);
-			if (!pChild)
-				break;
-			int iChildDepth = GetFolderDepth(pChild, NULL, &pNext);
-			if (iChildDepth == iDepth + 1 &&
+			if (GetFolderParent(pChild) == tr &&
 				*(bool*)GetSetMediaTrackInfo(pChild, "B_MAINSEND", NULL) &&
 				!*(bool*)GetSetMediaTrackInfo(pChild, "B_MUTE", NULL))
 				pTracks->Add(pChild);
-			if (iChildDepth <= iDepth)
-				break;
-			iChild++;
 		}
 	}
 
@@ -52,17 +52,25 @@ void ObjectStateCache::WriteCache()
 #ifdef GOS_DEBUG
 	int iCount = 0;
 #endif
-	for (int i = 0; i < m_obj.GetSize(); i++)
+	for (int i = 0; i < m_states.GetSize(); i++)
 	{
-		if (m_str.Get(i)->GetLength() && m_orig.Get(i) && strcmp(m_str.Get(i)->Get(), m_orig.Get(i)))
+		CachedState* state = m_states.Get(i);
+		if (state->bDirty)
 		{
-			int fxstate = SNM_PreObjectState(m_str.Get(i), false);
-			GetSetObjectState(m_obj.Get(i), m_str.Get(i)->Get());
+			int fxstate = SNM_PreObjectState(&state->str, false);
+			GetSetObjectState(state->obj, state->str.Get());
 			SNM_PostObjectState(fxstate);
 #ifdef GOS_DEBUG
 			iCount++;
 #endif
 		}
+		// Release states as soon as they're written (REAPER can call back into us
+		// while applying a chunk, don't leave a dangling index entry)
+		m_index.erase(state->obj);
+		if (state->orig)
+			FreeHeapPtr(state->orig);
+		delete state;
+		m_states.Set(i, NULL);
 	}
 #ifdef GOS_DEBUG
 	dprintf("ObjectStateCache::WriteCache applied %d chunks.\n", iCount);
@@ -73,39 +81,57 @@ void ObjectStateCache::WriteCache()
 
 void ObjectStateCache::EmptyCache()
 {
-	m_obj.Empty();
-	m_str.Empty(true);
-	m_orig.Empty(true, FreeHeapPtr);
+	for (int i = 0; i < m_states.GetSize(); i++)
+		if (CachedState* state = m_states.Get(i))
+		{
+			if (state->orig)
+				FreeHeapPtr(state->orig);
+			delete state;
+		}
+	m_states.Empty();
+	m_index.clear();
 }
 
 const char* ObjectStateCache::GetSetObjState(void* obj, const char* str, bool wantsMinimalState)
 {
-	int i = m_obj.Find(obj);
-	if (i < 0)
+	CachedState* state;
+	std::unordered_map<void*, CachedState*>::iterator it = m_index.find(obj);
+	if (it == m_index.end())
 	{
-		i = m_obj.GetSize();
-		m_obj.Add(obj);
-		m_str.Add(new WDL_FastString);
-		if (str && str[0])
-			m_orig.Add(NULL);
-		else
+		state = new CachedState;
+		state->obj = obj;
+		state->orig = NULL;
+		state->bDirty = false;
+		if (!str || !str[0])
 		{
 			int fxstate = SNM_PreObjectState(NULL, wantsMinimalState);
-			char* p = GetSetObjectState(obj, NULL);
+			state->orig = GetSetObjectState(obj, NULL);
 			SNM_PostObjectState(fxstate);
-			m_orig.Add(p);
 		}
+		m_states.Add(state);
+		m_index[obj] = state;
 	}
+	else
+		state = it->second;
+
 	if (str && str[0])
 	{
-		m_str.Get(i)->Set(str);
+		// Only write back states that differ from REAPER's, the original state isn't needed anymore
+		if (state->orig)
+		{
+			state->bDirty |= strcmp(str, state->orig) != 0;
+			FreeHeapPtr(state->orig);
+			state->orig = NULL;
+		}
+		else
+			state->bDirty = true;
+		state->str.Set(str);
 		return NULL;
 	}
 
-	if (m_str.Get(i)->GetLength())
-		return m_str.Get(i)->Get();
-	else
-		return m_orig.Get(i);
+	if (state->orig)
+		return state->orig;
+	return state->str.Get();
 }
 
 ObjectStateCache* g_objStateCache = NULL;
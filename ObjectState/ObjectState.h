@@ -28,6 +28,8 @@
 
 #pragma once
 
+#include <unordered_map>
+
 class ObjectStateCache
 {
 public:
@@ -38,11 +40,19 @@ public:
 	const char* GetSetObjState(void* obj, const char* str, bool wantsMinimalState = false);
 	int m_iUseCount;
 private:
-	WDL_PtrList<void> m_obj;
-	WDL_PtrList<WDL_FastString> m_str;
-	WDL_PtrList<char> m_orig;
+	struct CachedState
+	{
+		void* obj;
+		char* orig;          // state read from REAPER, freed once a new state is set
+		WDL_FastString str;  // state set by the caller, if any
+		bool bDirty;         // str must be written back
+	};
+	WDL_PtrList<CachedState> m_states; // in order of first access, i.e. write order
+	std::unordered_map<void*, CachedState*> m_index;
 };
 
+extern ObjectStateCache* g_objStateCache; // non-NULL while states are cached, see SWS_CacheObjectState()
+
 const char* SWS_GetSetObjectState(void* obj, WDL_FastString* str, bool wantsMinimalState = false);
 void SWS_FreeHeapPtr(void* ptr);
 void SWS_FreeHeapPtr(const char* ptr);
@@ -37,6 +37,7 @@ protected:
 	void GetItemText(SWS_ListItem* item, int iCol, char* str, int iStrMax);
 	void OnItemDblClk(SWS_ListItem* item, int iCol);
 	void GetItemList(SWS_ListItemList* pList);
+	bool GetItemSortKey(SWS_ListItem* item, int iCol, SWS_SortKey* key) { return GetTextSortKey(item, iCol, key); }
 };
 
 class SWS_ProjectListWnd : public SWS_DockWnd
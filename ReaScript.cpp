@@ -295,6 +295,7 @@ APIdef g_apidefs[] =
 	{ APIFUNC(NF_GetMediaItemPeakRMS_NonWindowed), "double", "MediaItem*", "item", "Returns the greatest overall (non-windowed) dB RMS peak level of all active channels of an audio item active take, post item gain, post take volume envelope, post-fade, pre fader, pre item FX. \n Returns -150.0 if MIDI take or empty item.", },
 	{ APIFUNC(NF_GetMediaItemAverageRMS), "double", "MediaItem*", "item", "Returns the average overall (non-windowed) dB RMS level of active channels of an audio item active take, post item gain, post take volume envelope, post-fade, pre fader, pre item FX. \n Returns -150.0 if MIDI take or empty item.", },
 	{ APIFUNC(NF_AnalyzeMediaItemPeakAndRMS), "bool", "MediaItem*,double,void*,void*,void*,void*", "item,windowSize,reaper.array_peaks,reaper.array_peakpositions,reaper.array_RMSs,reaper.array_RMSpositions", "This function combines all other NF_Peak/RMS functions in a single one and additionally returns peak RMS positions. Lua example code <a href=\"https://forum.cockos.com/showpost.php?p=2050961&postcount=6\">here</a>. Note: It's recommended to use this function with ReaScript/Lua as it provides reaper.array objects. If using this function with other scripting languages, you must provide arrays in the <a href=\"https://forum.cockos.com/showpost.php?p=2039829&postcount=2\">reaper.array</a> format.", },
+	{ APIFUNC(NF_AnalyzeMediaItem), "bool", "MediaItem*,double,bool,bool,double*,double*,double*,double*,double*,double*,double*,double*,int*", "item,windowSize,analyzeTruePeak,analyzeLoudness,peakOut,peakPosOut,truePeakOut,RMSOut,peakRMSOut,peakRMSPosOut,lufsIntegratedOut,DCOffsetOut,clipCountOut", "Analyzes an audio item active take in a single pass (same signal as <a href=\"#NF_GetMediaItemMaxPeak\">NF_GetMediaItemMaxPeak</a>) and returns max. peak (dBFS) and its position, average RMS (dB), peak RMS (dB, windowSize in seconds, <= 0 uses 'Window size for peak RMS' setting in 'SWS: Set RMS analysis/normalize options') and its position, DC offset of the channel with the greatest offset and the number of clipped samples (>= 0 dBFS) of all channels. analyzeTruePeak=true: also returns true peak (dBTP), considerably slower. analyzeLoudness=true: also returns integrated loudness (LUFS) of the active take, same as <a href=\"#NF_AnalyzeTakeLoudness_IntegratedOnly\">NF_AnalyzeTakeLoudness_IntegratedOnly</a> (take vol./pan and envelopes are taken into account). Positions are relative to item position. Results are shared with the other NF_ peak/RMS functions and kept until the item or its active take changes, so calling several of them on the same item analyzes it only once. Returns false on MIDI take, empty item or when analysis failed.", },
 
 	// #880
 	{ APIFUNC(NF_AnalyzeTakeLoudness_IntegratedOnly), "bool", "MediaItem_Take*,double*", "take,lufsIntegratedOut", "Does LUFS integrated analysis only. Faster than full loudness analysis (<a href=\"#NF_AnalyzeTakeLoudness\">NF_AnalyzeTakeLoudness</a>) . Use this if only LUFS integrated is required. Take vol. env. is taken into account. See: <a href=\"http://wiki.cockos.com/wiki/index.php/Measure_and_normalize_loudness_with_SWS\">Signal flow</a>", },
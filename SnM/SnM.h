@@ -250,6 +250,7 @@ enum {
   SNM_SCHEDJOB_TRIG_PRESET,
   SNM_SCHEDJOB_RES_ATTACH = SNM_SCHEDJOB_TRIG_PRESET + SNM_PRESETS_NB_FX + 1, // +1 for the "selected fx" preset action
   SNM_SCHEDJOB_PLAYLIST_UPDATE,
+  SNM_SCHEDJOB_RES_AUTOFILL,
   SNM_SCHEDJOB_OSX_FIX	//JFB!! removeme some day, due to _SNM_SWELL_ISSUES/missing EN_CHANGE messages
 };
 
@@ -36,6 +36,8 @@
 #include "SnM_Routing.h"
 #include "SnM_Track.h"
 
+#include <thread>
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // SNM_ChunkIndenter
@@ -946,4 +948,127 @@ void SNM_TakeEnvParserPatcher::SetPatchVisibilityOnly(bool visibilityOnly)
 	m_patchVisibilityOnly = visibilityOnly;;
 }
 
+
+///////////////////////////////////////////////////////////////////////////////
+// SNM_ChunkTransaction
+///////////////////////////////////////////////////////////////////////////////
+
+SNM_ChunkTransaction::~SNM_ChunkTransaction()
+{
+	for (int i=0; i < m_items.GetSize(); i++)
+		delete m_items.Get()[i].p; // no auto-commit, see Add()
+}
+
+void SNM_ChunkTransaction::Add(SNM_ChunkParserPatcher* _p, SNM_ChunkPatchFunc _patch, void* _data)
+{
+	if (_p && _p->GetObject())
+	{
+		_p->m_autoCommit = false;
+		Item item = { _p, _patch, _data };
+		m_items.Add(item);
+	}
+	else
+		delete _p;
+}
+
+void SNM_ChunkTransaction::PatchWorker(SNM_ChunkTransaction* _t)
+{
+	for(;;)
+	{
+		Item* item = NULL;
+		{
+			SWS_SectionLock lock(&_t->m_mutex);
+			if (_t->m_nextItem < _t->m_items.GetSize())
+				item = _t->m_items.Get() + _t->m_nextItem++;
+		}
+		if (!item)
+			break;
+		if (item->p && item->patch)
+			item->patch(item->p, item->data);
+	}
+}
+
+int SNM_ChunkTransaction::Commit(const char* _undoTitle, int _undoFlags)
+{
+	int nbItems = m_items.GetSize();
+	if (!nbItems)
+		return 0;
+
+	// get all chunks (main thread), the "VST full state" pref is toggled once 
+	// for all full states and once for all minimal states.
+	// note: when object states are cached, SWS_GetSetObjectState() deals with that
+	if (!g_objStateCache)
+	{
+		for (int minState=0; minState<2; minState++)
+		{
+			int fxstate = -2; // not toggled yet
+			for (int i=0; i < nbItems; i++)
+			{
+				SNM_ChunkParserPatcher* p = m_items.Get()[i].p;
+				if (p->m_minimalState == !!minState && !p->m_chunk->GetLength())
+				{
+					if (fxstate == -2)
+						fxstate = SNM_PreObjectState(NULL, !!minState);
+					if (const char* cData = GetSetObjectState(p->m_reaObject, NULL)) {
+						p->m_chunk->Set(cData);
+						FreeHeapPtr((void*)cData);
+					}
+				}
+			}
+			if (fxstate != -2)
+				SNM_PostObjectState(fxstate);
+		}
+	}
+	// objects whose state could not be got are dropped here: workers must 
+	// never fetch chunks lazily
+	for (int i=0; i < nbItems; i++)
+	{
+		Item* item = m_items.Get() + i;
+		if (item->p->GetChunk()->GetLength()) // no-op if already cached, see inherited classes too (e.g. SNM_TakeParserPatcher)
+			item->p->m_noFetch = true;
+		else {
+			delete item->p;
+			item->p = NULL;
+		}
+	}
+
+	// patch chunks (worker threads)
+	m_nextItem = 0;
+	const int hardwareThreads = (int)std::thread::hardware_concurrency();
+	int nbWorkers = min(nbItems, hardwareThreads > 0 ? hardwareThreads : 1);
+	if (nbWorkers > 1)
+	{
+		std::vector<std::thread> workers;
+		for (int i=0; i < nbWorkers; i++)
+			workers.push_back(std::thread(PatchWorker, this));
+		for (size_t i=0; i < workers.size(); i++)
+			workers[i].join();
+	}
+	else
+		PatchWorker(this);
+
+	// set updated chunks back (main thread)
+	int updated = 0;
+	PreventUIRefresh(1);
+	for (int i=0; i < nbItems; i++)
+	{
+		SNM_ChunkParserPatcher* p = m_items.Get()[i].p;
+		if (!p)
+			continue;
+		p->m_noFetch = false;
+		if (p->GetUpdates() && p->Commit())
+			updated++;
+	}
+	PreventUIRefresh(-1);
+
+	for (int i=0; i < nbItems; i++)
+		delete m_items.Get()[i].p;
+	m_items.Resize(0, false);
+
+	if (updated && _undoTitle)
+		Undo_OnStateChangeEx2(NULL, _undoTitle, _undoFlags, -1);
+	return updated;
+}
+
+
 int g_disable_chunk_guid_filtering;
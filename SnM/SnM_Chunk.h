@@ -390,4 +390,41 @@ private:
 	bool m_patchVisibilityOnly;
 };
 
+
+///////////////////////////////////////////////////////////////////////////////
+// SNM_ChunkTransaction
+// Patches the chunks of several objects in one go: all chunks are got up 
+// front (single "VST full state" pref toggle), patch callbacks are run by 
+// worker threads, and updated chunks are set back in a single pass (one 
+// PreventUIRefresh() bracket, one undo point).
+// Important: patch callbacks run on worker threads => they must only deal
+// with the patcher's cached chunk, no REAPER API calls!
+///////////////////////////////////////////////////////////////////////////////
+
+typedef void (*SNM_ChunkPatchFunc)(SNM_ChunkParserPatcher* _p, void* _data);
+
+class SNM_ChunkTransaction
+{
+public:
+	SNM_ChunkTransaction() : m_nextItem(0) {}
+	~SNM_ChunkTransaction(); // uncommitted patches are discarded
+	// _p: attached to a reaThing*, deleted by the transaction
+	// _data: passed as is to _patch
+	void Add(SNM_ChunkParserPatcher* _p, SNM_ChunkPatchFunc _patch, void* _data = NULL);
+	int GetSize() { return m_items.GetSize(); }
+	// _undoTitle: NULL for no undo point
+	// returns the number of updated objects
+	int Commit(const char* _undoTitle = NULL, int _undoFlags = UNDO_STATE_ALL);
+private:
+	struct Item {
+		SNM_ChunkParserPatcher* p;
+		SNM_ChunkPatchFunc patch;
+		void* data;
+	};
+	static void PatchWorker(SNM_ChunkTransaction* _t);
+	WDL_TypedBuf<Item> m_items;
+	int m_nextItem;
+	SWS_Mutex m_mutex;
+};
+
 #endif
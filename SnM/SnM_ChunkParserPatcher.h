@@ -1,5 +1,5 @@
 /******************************************************************************
-/ SnM_ChunkParserPatcher.h - v1.34
+/ SnM_ChunkParserPatcher.h - v1.35
 /
 / Copyright (c) 2008 and later Jeffos
 /
@@ -50,6 +50,8 @@
 #pragma warning(disable : 4267) // size_t to int warnings in x64
 #endif
 
+#include <cassert>
+
 #define _SWS_EXTENSION
 #ifdef _SWS_EXTENSION
 #define SNM_FreeHeapPtr			SWS_FreeHeapPtr
@@ -110,6 +112,40 @@ static int RemoveAllIds(WDL_FastString* _chunk) {
 	return RemoveChunkLines(_chunk, "ID {", false, '}');
 }
 
+static const char* GetChunkLineKeyword(const char* _line, int _lineLen, int* _keywordLen);
+static unsigned int HashChunkKeyword(const char* _keyword, int _len);
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Indexed mode, see SNM_ChunkParserPatcher::SetIndexed()
+///////////////////////////////////////////////////////////////////////////////
+
+// a parsed line of the cached chunk
+struct SNM_ChunkLine
+{
+	int pos, len;         // line start position, length (without EOL)
+	int keywordPos, keywordLen;
+	int depth;            // same as the parsed depth in ParsePatchCore()
+	int parent;           // index of the parent's "<KEYWORD" line (the line itself for sub-chunks), -1 if none
+	int end;              // sub-chunks only: index of the closing ">" line, -1 otherwise
+	unsigned int hash;    // keyword hash
+};
+
+// keyword lookup table entry, sorted by hash then by line
+struct SNM_ChunkKeyword
+{
+	unsigned int hash;
+	int line;
+};
+
+// a pending patch: len characters replaced with str at pos
+struct SNM_ChunkEdit
+{
+	int pos, len;
+	WDL_FastString str;
+	SNM_ChunkEdit(int _pos, int _len, const char* _str) : pos(_pos), len(_len), str(_str ? _str : "") {}
+};
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // SNM_ChunkParserPatcher
@@ -117,6 +153,8 @@ static int RemoveAllIds(WDL_FastString* _chunk) {
 
 class SNM_ChunkParserPatcher
 {
+friend class SNM_ChunkTransaction; // gets chunks up front, see SnM_Chunk.h
+
 public:
 
 // when attached to a reaThing* (MediaTrack*, MediaItem*, ..)
@@ -137,6 +175,10 @@ SNM_ChunkParserPatcher(void* _reaObject, bool _autoCommit=true,
 	m_processInProjectMIDI = _processInProjectMIDI;
 	m_processFreeze = _processFreeze;
 	m_minimalState = false;
+	m_noFetch = false;
+	m_indexed = false;
+	m_indexValid = false;
+	m_indexLen = 0;
 }
 
 // when attached to a WDL_FastString* (simple text chunk parser/patcher)
@@ -157,6 +199,10 @@ SNM_ChunkParserPatcher(WDL_FastString* _chunk, bool _autoCommit=true,
 	m_processInProjectMIDI = _processInProjectMIDI;
 	m_processFreeze = _processFreeze;
 	m_minimalState = false;
+	m_noFetch = false;
+	m_indexed = false;
+	m_indexValid = false;
+	m_indexLen = 0;
 }
 
 virtual ~SNM_ChunkParserPatcher() 
@@ -182,6 +228,8 @@ int ParsePatch(
 	void* _valueExcept = NULL,
 	const char* _breakKeyword = NULL)
 {
+	if (m_indexed && _mode == SNM_REPLACE_SUBCHUNK_OR_LINE && _value && IsIndexedQuery(_depth, _expectedParent, _keyWord))
+		return IndexedReplace(_depth, _expectedParent, _keyWord, _occurence, (const char*)_value, _breakKeyword);
 	return ParsePatchCore(true, _mode, _depth, _expectedParent, _keyWord, _occurence, _tokenPos, _value,_valueExcept, _breakKeyword);
 }
 
@@ -197,6 +245,11 @@ int Parse(
 	void* _valueExcept = NULL,
 	const char* _breakKeyword = NULL)
 {
+	if (m_indexed && IsIndexedQuery(_depth, _expectedParent, _keyWord) && 
+		(_mode == SNM_GET_CHUNK_CHAR || _mode == SNM_GET_SUBCHUNK_OR_LINE || _mode == SNM_GET_SUBCHUNK_OR_LINE_EOL || _mode == SNM_COUNT_KEYWORD))
+	{
+		return IndexedParse(_mode, _depth, _expectedParent, _keyWord, _occurence, _tokenPos, _value, _breakKeyword);
+	}
 	return ParsePatchCore(false, _mode, _depth, _expectedParent, _keyWord, _occurence, _tokenPos, _value,_valueExcept, _breakKeyword);
 }
 
@@ -206,12 +259,18 @@ void* GetObject() {
 
 // get and cache the RPP chunk
 // note: this method *always* returns a valid value (non NULL)
+// indexed mode: pending patches are applied and the index is dropped (the 
+// returned chunk can be altered directly)
 virtual WDL_FastString* GetChunk() 
 {
+	if (m_indexed)
+		FlushIndex();
+
 	if (!m_chunk->GetLength())
 	{
-		if (m_reaObject) {			
-			if (const char* cData = (m_reaObject ? SNM_GetSetObjectState(m_reaObject, NULL) : NULL)) {
+		if (m_reaObject) {
+			assert(!m_noFetch); // e.g. SNM_ChunkTransaction worker threads
+			if (const char* cData = (!m_noFetch ? SNM_GetSetObjectState(m_reaObject, NULL) : NULL)) {
 				m_chunk->Set(cData);
 				SNM_FreeHeapPtr((void*)cData);
 			}
@@ -230,6 +289,8 @@ virtual WDL_FastString* GetChunk()
 
 // clearing the cache is allowed
 void SetChunk(const char* _newChunk, int _updates=1) {
+	m_edits.Empty(true);
+	m_indexValid = false;
 	m_updates = _updates;
 	GetChunk()->Set(_newChunk ? _newChunk : "");
 }
@@ -272,7 +333,7 @@ virtual bool Commit(bool _force = false)
 }
 
 const char* GetInfo() {
-	return "SNM_ChunkParserPatcher - v1.34";
+	return "SNM_ChunkParserPatcher - v1.35";
 }
 
 void SetProcessBase64(bool _enable) {
@@ -291,6 +352,21 @@ void SetWantsMinimalState(bool _enable) {
 	m_minimalState = _enable;
 }
 
+// indexed mode: for instances that run several queries/patches on the same chunk
+// - the chunk is parsed once into a line table (offsets, depth, parent, keyword 
+//   hash, sub-chunk ends), GetSubChunk(), GetLinePos(), SNM_GET_CHUNK_CHAR, 
+//   SNM_GET_SUBCHUNK_OR_LINE(_EOL) and SNM_COUNT_KEYWORD queries then only 
+//   look at the lines matching the keyword
+// - ReplaceSubChunk(), ReplaceLine(), InsertAfterBefore(), etc.. are recorded 
+//   and applied in one go, on Commit() or when the chunk is accessed/parsed
+// - other modes and SAX-ish parsing still go through ParsePatchCore()
+// note: pointers returned by GetChunk() must not be kept around in this mode
+void SetIndexed(bool _enable) {
+	if (!_enable)
+		FlushIndex();
+	m_indexed = _enable;
+}
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // Helpers
@@ -394,6 +470,9 @@ bool InsertAfterBefore(int _dir, const char* _str, const char* _parent, const ch
 {
 	if (_str && *_str && _keyword)
 	{
+		if (m_indexed && IsIndexedQuery(_depth, _parent, _keyword))
+			return IndexedInsert(_dir, _str, _parent, _keyword, _depth, _occurence, _breakKeyword);
+
 		int pos = GetLinePos(_dir, _parent, _keyword, _depth, _occurence, _breakKeyword);
 		if (pos >= 0) {
 			m_chunk->Insert(_str, pos);
@@ -410,20 +489,7 @@ int GetLinePos(int _dir, const char* _parent, const char* _keyword, int _depth,
 {
 	int pos = Parse(SNM_GET_CHUNK_CHAR, _depth, _parent, _keyword, _occurence, 0, NULL, NULL, _breakKeyword);
 	if (pos > 0)
-	{
-		pos--; // See ParsePatchCore()
-		if (_dir == -1 || _dir == 1)
-		{
-			const char* pChunk = m_chunk->Get();
-			if (_dir == -1 && pos >= 2)
-				pos-=2; // zap the previous '\n'
-			while (pChunk[pos] && pChunk[pos] != '\n') pos += _dir;
-			if (pChunk[pos] && pChunk[pos+1])
-				return pos+1;
-		}
-		else
-			return pos;
-	}
+		return GetAdjacentLinePos(_dir, pos-1); // pos-1: see ParsePatchCore()
 	return -1;
 }
 
@@ -461,6 +527,10 @@ protected:
 	// note: such states must not be patched back (corrupted/incomplete states)
 	bool m_minimalState;
 
+	// set by SNM_ChunkTransaction while patching off the main thread: the 
+	// chunk must not be (re)fetched from REAPER
+	bool m_noFetch;
+
 	// this one is READ-ONLY (automatically set when parsing SOURCE sub-chunks)
 	bool m_isParsingSource;
 
@@ -584,6 +654,451 @@ void IsMatchingParsedLine(bool* _tolerantMatch, bool* _strictMatch,
 	}
 }
 
+// returns the current, next or previous line (start) position from a line/keyword position 
+// _dir: -1 previous line, 0 current line, +1 next line
+int GetAdjacentLinePos(int _dir, int _pos)
+{
+	if (_dir == -1 || _dir == 1)
+	{
+		const char* pChunk = m_chunk->Get();
+		if (_dir == -1 && _pos >= 2)
+			_pos-=2; // zap the previous '\n'
+		while (pChunk[_pos] && pChunk[_pos] != '\n') _pos += _dir;
+		if (pChunk[_pos] && pChunk[_pos+1])
+			return _pos+1;
+		return -1;
+	}
+	return _pos;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Indexed mode, see SetIndexed()
+// Lines are indexed like ParsePatchCore() parses them (same skipped data, 
+// same depth/parent), pending patches (m_edits) refer to positions in m_chunk
+// which is left untouched until FlushIndex()
+///////////////////////////////////////////////////////////////////////////////
+
+WDL_TypedBuf<SNM_ChunkLine> m_lines;
+WDL_TypedBuf<SNM_ChunkKeyword> m_keywords;
+WDL_PtrList_DeleteOnDestroy<SNM_ChunkEdit> m_edits; // sorted by position, no overlap
+bool m_indexed, m_indexValid;
+int m_indexLen;
+
+static int CompareChunkKeywords(const void* _a, const void* _b)
+{
+	const SNM_ChunkKeyword* a = (const SNM_ChunkKeyword*)_a;
+	const SNM_ChunkKeyword* b = (const SNM_ChunkKeyword*)_b;
+	if (a->hash != b->hash) return a->hash < b->hash ? -1 : 1;
+	return a->line - b->line;
+}
+
+// same criteria as strict matches in ParsePatchCore()
+bool IsIndexedQuery(int _depth, const char* _parent, const char* _keyword) {
+	return (_depth > 0 && _parent && _keyword && *_keyword);
+}
+
+// applies pending patches, if any, and drops the index
+void FlushIndex()
+{
+	if (m_edits.GetSize())
+	{
+		const char* cData = m_chunk->Get();
+		WDL_FastString* newChunk = new WDL_FastString(SNM_HEAPBUF_GRANUL);
+		int pos = 0;
+		for (int i=0; i < m_edits.GetSize(); i++)
+		{
+			SNM_ChunkEdit* e = m_edits.Get(i);
+			if (e->pos > pos)
+				newChunk->Append(cData+pos, e->pos-pos);
+			if (e->str.GetLength())
+				newChunk->Append(e->str.Get(), e->str.GetLength());
+			pos = e->pos + e->len;
+		}
+		newChunk->Append(cData+pos);
+		m_edits.Empty(true);
+
+		// avoids buffer re-copy
+		WDL_FastString* oldChunk = m_chunk;
+		m_chunk = newChunk;
+		delete oldChunk;
+	}
+	m_indexValid = false;
+}
+
+// (re)builds the line table if needed
+// note: no-op when patches are pending (the index still describes m_chunk)
+bool BuildIndex()
+{
+	if (m_indexValid && m_indexLen == m_chunk->GetLength())
+		return true;
+
+	const char* cData = GetChunk()->Get(); // + applies pending patches, if any
+	m_lines.Resize(0, false);
+
+	WDL_TypedBuf<int> parents; // "<KEYWORD" line indexes
+	const char* pEOL = cData-1, *pLine, *pEOSkippedChunk, *keyword;
+	int lineLen, keywordLen;
+	bool isParsingSource = false;
+	for(;;)
+	{
+		pLine = pEOL+1;
+		pEOL = strchr(pLine, '\n');
+		if (!pEOL)
+			break;
+		lineLen = (int)(pEOL-pLine);
+
+		// skip the same data as ParsePatchCore()
+		pEOSkippedChunk = NULL;
+		if (!m_processBase64 &&
+			lineLen>2 && *(pEOL-1)=='=' && *(pEOL-2)=='=')
+		{
+			pEOSkippedChunk = strstr(pLine, ">\n");
+		}
+		else if (!m_processInProjectMIDI && isParsingSource && (
+			(lineLen>2 && !_strnicmp(pLine, "E ", 2)) ||
+			(lineLen>3 && !_strnicmp(pLine, "Em ", 3))))
+		{
+			pEOSkippedChunk = strstr(pLine, "GUID {");
+		}
+		else if (!m_processFreeze && parents.GetSize()==1 && 
+			lineLen>8 && !strncmp(pLine, "<FREEZE ", 8))
+		{
+			int skippedLen = FindEndOfSubChunk(pLine, 0);
+			while (skippedLen >= 0)
+			{
+				pEOSkippedChunk = (char*)(pLine+skippedLen);
+				if (!strncmp(pEOSkippedChunk, "<FREEZE ", 8))
+					skippedLen = FindEndOfSubChunk(pLine, skippedLen);
+				else
+					skippedLen = -1;
+			}
+		}
+
+		if (pEOSkippedChunk) 
+		{
+			pLine = pEOSkippedChunk;
+			pEOL = strchr(pLine, '\n');
+			if (!pEOL)
+				break;
+			lineLen = (int)(pEOL-pLine);
+		}
+
+		keyword = GetChunkLineKeyword(pLine, lineLen, &keywordLen);
+		if (!keyword) // zap this line
+			continue;
+
+		SNM_ChunkLine line;
+		line.pos = (int)(pLine-cData);
+		line.len = lineLen;
+		line.keywordPos = (int)(keyword-cData);
+		line.keywordLen = keywordLen;
+		line.end = -1;
+		line.hash = HashChunkKeyword(keyword, keywordLen);
+
+		if (*keyword == '<')
+		{
+			if (lineLen>9 && keywordLen==7 && !strncmp(keyword, "<SOURCE", 7)) // e.g. <SOURCE MIDI
+			{
+				int tokenLen;
+				const char* type = GetChunkLineKeyword(keyword+keywordLen, (int)(pEOL-keyword-keywordLen), &tokenLen);
+				isParsingSource |= (type && !GetChunkLineKeyword(type+tokenLen, (int)(pEOL-type-tokenLen), &tokenLen));
+			}
+			parents.Add(m_lines.GetSize());
+		}
+		else if (*keyword == '>' && parents.GetSize())
+		{
+			SNM_ChunkLine* opening = m_lines.Get() + parents.Get()[parents.GetSize()-1];
+			if (isParsingSource)
+				isParsingSource = (opening->keywordLen!=7 || strncmp(cData+opening->keywordPos, "<SOURCE", 7));
+			opening->end = m_lines.GetSize();
+			parents.Resize(parents.GetSize()-1, false);
+		}
+
+		line.depth = parents.GetSize();
+		line.parent = line.depth ? parents.Get()[line.depth-1] : -1;
+		m_lines.Add(line);
+	}
+
+	// keyword lookup table
+	int nbLines = m_lines.GetSize();
+	SNM_ChunkKeyword* keywords = m_keywords.Resize(nbLines, false);
+	if (nbLines && keywords)
+	{
+		for (int i=0; i < nbLines; i++) {
+			keywords[i].hash = m_lines.Get()[i].hash;
+			keywords[i].line = i;
+		}
+		qsort(keywords, nbLines, sizeof(SNM_ChunkKeyword), CompareChunkKeywords);
+	}
+
+	m_indexLen = m_chunk->GetLength();
+	m_indexValid = true;
+	return true;
+}
+
+bool IsIndexedKeyword(const SNM_ChunkLine* _line, const char* _keyword, int _keywordLen) {
+	return (_line->keywordLen == _keywordLen && !strncmp(m_chunk->Get()+_line->keywordPos, _keyword, _keywordLen));
+}
+
+// strict match, see ParsePatchCore()
+bool IsIndexedMatch(const SNM_ChunkLine* _line, int _depth, const char* _parent, const char* _keyword, int _keywordLen)
+{
+	if (_line->depth != _depth || _line->parent < 0 || !IsIndexedKeyword(_line, _keyword, _keywordLen))
+		return false;
+	const SNM_ChunkLine* parent = m_lines.Get() + _line->parent;
+	return (parent->keywordLen-1 == (int)strlen(_parent) && !strncmp(m_chunk->Get()+parent->keywordPos+1, _parent, parent->keywordLen-1)); // +1/-1: zap '<'
+}
+
+// true if the line has been removed/replaced by a pending patch
+bool IsIndexedLineEdited(const SNM_ChunkLine* _line)
+{
+	for (int i=0; i < m_edits.GetSize(); i++) {
+		SNM_ChunkEdit* e = m_edits.Get(i);
+		if (_line->pos >= e->pos && _line->pos < e->pos+e->len)
+			return true;
+	}
+	return false;
+}
+
+// true if a pending patch overlaps or touches the range [_pos, _pos+_len]
+bool IsIndexedRangeEdited(int _pos, int _len)
+{
+	for (int i=0; i < m_edits.GetSize(); i++) {
+		SNM_ChunkEdit* e = m_edits.Get(i);
+		if (_pos <= e->pos+e->len && e->pos <= _pos+_len)
+			return true;
+	}
+	return false;
+}
+
+// true if a pending patch inserts _str, e.g. new lines that could match a query
+bool IsIndexedStrEdited(const char* _str)
+{
+	if (_str && *_str)
+		for (int i=0; i < m_edits.GetSize(); i++)
+			if (strstr(m_edits.Get(i)->str.Get(), _str))
+				return true;
+	return false;
+}
+
+// gets the index of lines that begin with _keyword, in chunk order
+// _depth: -1 for any depth (min 1, like ParsePatchCore() matches)
+void GetIndexedLines(const char* _keyword, int _depth, const char* _parent, WDL_TypedBuf<int>* _lines)
+{
+	_lines->Resize(0, false);
+	int keywordLen = (int)strlen(_keyword);
+	unsigned int hash = HashChunkKeyword(_keyword, keywordLen);
+
+	// lower bound
+	const SNM_ChunkKeyword* keywords = m_keywords.Get();
+	int lo = 0, hi = m_keywords.GetSize();
+	while (lo < hi) {
+		int mid = (lo+hi)/2;
+		if (keywords[mid].hash < hash) lo = mid+1;
+		else hi = mid;
+	}
+
+	for (; lo < m_keywords.GetSize() && keywords[lo].hash == hash; lo++)
+	{
+		const SNM_ChunkLine* line = m_lines.Get() + keywords[lo].line;
+		if (_depth == -1 ? 
+				(line->depth > 0 && IsIndexedKeyword(line, _keyword, keywordLen)) : 
+				IsIndexedMatch(line, _depth, _parent, _keyword, keywordLen))
+		{
+			if (!IsIndexedLineEdited(line))
+				_lines->Add(keywords[lo].line);
+		}
+	}
+}
+
+// mimics the matching/occurrence/break keyword logic of ParsePatchCore()
+// _taken: output prm, the lines to be processed (read modes: the searched occurrence only)
+// returns the number of matching lines (i.e. SNM_COUNT_KEYWORD)
+int GetIndexedMatches(int _mode, int _depth, const char* _parent, const char* _keyword, int _occurence, const char* _breakKeyword, WDL_TypedBuf<int>* _taken)
+{
+	WDL_TypedBuf<int> matches, breaks;
+	GetIndexedLines(_keyword, _depth, _parent, &matches);
+	if (_breakKeyword && *_breakKeyword)
+		GetIndexedLines(_breakKeyword, -1, NULL, &breaks);
+
+	_taken->Resize(0, false);
+	int occurence = 0, b = 0, lastSubChunkEnd = -1, keywordLen = (int)strlen(_keyword);
+	for (int i=0; i < matches.GetSize(); i++)
+	{
+		int match = matches.Get()[i];
+
+		// breaking keyword before this match? (not in a processed sub-chunk)
+		for (; b < breaks.GetSize() && breaks.Get()[b] < match; b++)
+		{
+			int brk = breaks.Get()[b];
+			if (brk > lastSubChunkEnd && !IsIndexedMatch(m_lines.Get()+brk, _depth, _parent, _keyword, keywordLen))
+				return occurence;
+		}
+
+		if (_occurence == occurence || _occurence == -1)
+		{
+			_taken->Add(match);
+			if (_mode == SNM_REPLACE_SUBCHUNK_OR_LINE)
+			{
+				if (*_keyword == '<')
+					lastSubChunkEnd = m_lines.Get()[match].end >= 0 ? m_lines.Get()[match].end : m_lines.GetSize();
+				if (_occurence != -1)
+					return occurence+1;
+			}
+			else if (_mode != SNM_COUNT_KEYWORD)
+				return occurence+1;
+		}
+		occurence++;
+	}
+	return occurence;
+}
+
+// returns the end position (after EOL) of a line or sub-chunk
+int GetIndexedEndPos(int _line)
+{
+	const SNM_ChunkLine* line = m_lines.Get() + _line;
+	if (*(m_chunk->Get()+line->keywordPos) == '<') {
+		if (line->end < 0) return m_chunk->GetLength();
+		line = m_lines.Get() + line->end;
+	}
+	return line->pos + line->len + 1;
+}
+
+// read-only modes, see Parse()
+int IndexedParse(int _mode, int _depth, const char* _parent, const char* _keyword, int _occurence, int _tokenPos, void* _value, const char* _breakKeyword)
+{
+	if (m_edits.GetSize())
+		FlushIndex();
+	if (!BuildIndex())
+		return -1;
+
+	WDL_TypedBuf<int> taken;
+	int count = GetIndexedMatches(_mode, _depth, _parent, _keyword, _occurence, _breakKeyword, &taken);
+	if (_mode == SNM_COUNT_KEYWORD)
+		return count;
+	if (!taken.GetSize())
+		return 0; // not found
+
+	const char* cData = m_chunk->Get();
+	const SNM_ChunkLine* line = m_lines.Get() + taken.Get()[0];
+	bool subChunk = (*_keyword == '<');
+
+	// value, with the same truncation as ParsePatchCore() for single lines
+	char curLine[SNM_MAX_CHUNK_LINE_LENGTH] = "";
+	int curLineLen = line->len >= SNM_MAX_CHUNK_LINE_LENGTH ? SNM_MAX_CHUNK_LINE_LENGTH-1 : line->len;
+	if (_value && (_mode == SNM_GET_CHUNK_CHAR || !subChunk)) {
+		memcpy(curLine, cData+line->pos, curLineLen);
+		curLine[curLineLen] = '\0';
+	}
+
+	switch (_mode)
+	{
+		case SNM_GET_CHUNK_CHAR:
+			if (_value) {
+				LineParser lp(false);
+				*(char*)_value = '\0';
+				if (!lp.parse(curLine))
+					strcpy((char*)_value, lp.gettoken_str(_tokenPos));
+			}
+			return line->keywordPos+1;
+		case SNM_GET_SUBCHUNK_OR_LINE:
+		case SNM_GET_SUBCHUNK_OR_LINE_EOL:
+		{
+			int endPos = GetIndexedEndPos(taken.Get()[0]);
+			if (subChunk && line->end < 0 && (_value || _mode == SNM_GET_SUBCHUNK_OR_LINE_EOL))
+				return 0; // no end of sub-chunk: same as ParsePatchCore()
+			if (_value)
+			{
+				if (subChunk)
+					((WDL_FastString*)_value)->Append(cData+line->pos, endPos-line->pos);
+				else {
+					((WDL_FastString*)_value)->Append(curLine);
+					((WDL_FastString*)_value)->Append("\n");
+				}
+			}
+			return (_mode == SNM_GET_SUBCHUNK_OR_LINE ? line->keywordPos+1 : endPos);
+		}
+	}
+	return -1;
+}
+
+// SNM_REPLACE_SUBCHUNK_OR_LINE, see ParsePatch()
+int IndexedReplace(int _depth, const char* _parent, const char* _keyword, int _occurence, const char* _value, const char* _breakKeyword)
+{
+	// new lines might match the query: apply pending patches first
+	if (IsIndexedStrEdited(_keyword) || IsIndexedStrEdited(_breakKeyword))
+		FlushIndex();
+
+	for (int pass=0; pass < 2; pass++)
+	{
+		if (!BuildIndex())
+			return -1;
+
+		WDL_TypedBuf<int> taken;
+		GetIndexedMatches(SNM_REPLACE_SUBCHUNK_OR_LINE, _depth, _parent, _keyword, _occurence, _breakKeyword, &taken);
+		if (!taken.GetSize())
+			return 0;
+
+		bool conflict = false;
+		for (int i=0; !conflict && i < taken.GetSize(); i++) {
+			int pos = m_lines.Get()[taken.Get()[i]].pos;
+			conflict = IsIndexedRangeEdited(pos, GetIndexedEndPos(taken.Get()[i])-pos);
+		}
+		if (conflict) {
+			FlushIndex();
+			continue;
+		}
+
+		for (int i=0; i < taken.GetSize(); i++) {
+			int pos = m_lines.Get()[taken.Get()[i]].pos;
+			AddIndexedEdit(pos, GetIndexedEndPos(taken.Get()[i])-pos, _value);
+		}
+		m_updates += taken.GetSize();
+		return taken.GetSize();
+	}
+	return 0;
+}
+
+// see InsertAfterBefore()
+bool IndexedInsert(int _dir, const char* _str, const char* _parent, const char* _keyword, int _depth, int _occurence, const char* _breakKeyword)
+{
+	if (IsIndexedStrEdited(_keyword) || IsIndexedStrEdited(_breakKeyword))
+		FlushIndex();
+
+	for (int pass=0; pass < 2; pass++)
+	{
+		if (!BuildIndex())
+			return false;
+
+		WDL_TypedBuf<int> taken;
+		GetIndexedMatches(SNM_GET_CHUNK_CHAR, _depth, _parent, _keyword, _occurence, _breakKeyword, &taken);
+		if (!taken.GetSize())
+			return false;
+
+		int pos = GetAdjacentLinePos(_dir, m_lines.Get()[taken.Get()[0]].keywordPos);
+		if (pos < 0)
+			return false;
+		if (IsIndexedRangeEdited(pos, 0)) {
+			FlushIndex();
+			continue;
+		}
+
+		AddIndexedEdit(pos, 0, _str);
+		m_updates++;
+		return true;
+	}
+	return false;
+}
+
+void AddIndexedEdit(int _pos, int _len, const char* _str)
+{
+	int i = m_edits.GetSize();
+	while (i > 0 && m_edits.Get(i-1)->pos > _pos) i--;
+	m_edits.Insert(i, new SNM_ChunkEdit(_pos, _len, _str));
+}
+
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // ParsePatchCore()
@@ -1080,6 +1595,40 @@ static int FindEndOfSubChunk(const char* _chunk, int _startPos)
 	return -1;
 }
 
+// returns the first token of a chunk line (unquoted, like LineParser's) or NULL 
+// if the line has to be zapped, see ParsePatchCore()
+static const char* GetChunkLineKeyword(const char* _line, int _lineLen, int* _keywordLen)
+{
+	const char* p = _line, *eol = _line+_lineLen;
+	while (p < eol && (*p==' ' || *p=='\t')) p++;
+	if (p >= eol)
+		return NULL;
+
+	const char* keyword = p;
+	if (*p=='"' || *p=='\'' || *p=='`')
+	{
+		char quote = *p;
+		keyword = ++p;
+		while (p < eol && *p != quote) p++;
+		if (p >= eol) // unbalanced quotes
+			return NULL;
+	}
+	else
+		while (p < eol && *p!=' ' && *p!='\t') p++;
+
+	*_keywordLen = (int)(p-keyword);
+	return *_keywordLen ? keyword : NULL;
+}
+
+// FNV-1a
+static unsigned int HashChunkKeyword(const char* _keyword, int _len)
+{
+	unsigned int h = 2166136261u;
+	for (int i=0; i < _len; i++)
+		h = (h ^ (unsigned char)_keyword[i]) * 16777619u;
+	return h;
+}
+
 // returns to pointer to the next valid keyword in _chunk
 // returns a valid left trimmed line pointers, separators and empty lines are skipped
 static const char* FindKeyword(const char* _chunk) {
@@ -200,11 +200,43 @@ bool SetTrackChannelsForFXChain(MediaTrack* _tr, WDL_FastString* _chain)
 	return false;
 }
 
+struct TrackFXChainPatch {
+	WDL_FastString* chain;
+	bool inputFX;
+};
+
+// SNM_ChunkTransaction callbacks (worker threads: chunk processing only)
+static void PasteTrackFXChainPatch(SNM_ChunkParserPatcher* _p, void* _data)
+{
+	TrackFXChainPatch* patch = (TrackFXChainPatch*)_data;
+	SNM_FXChainTrackPatcher* p = (SNM_FXChainTrackPatcher*)_p;
+	WDL_FastString currentFXChain;
+	int pos = p->GetSubChunk(patch->inputFX ? "FXCHAIN_REC" : "FXCHAIN", 2, 0, &currentFXChain, "<ITEM");
+
+	// paste (well.. insert at the end of the current FX chain)
+	if (pos >= 0) 
+	{
+		p->GetChunk()->Insert(patch->chain->Get(), pos + currentFXChain.GetLength() - 2); // -2: before ">\n"
+		p->IncUpdates();
+	}
+	// create fx chain
+	else 
+		p->SetFXChain(patch->chain, patch->inputFX);
+}
+
+static void SetTrackFXChainPatch(SNM_ChunkParserPatcher* _p, void* _data)
+{
+	TrackFXChainPatch* patch = (TrackFXChainPatch*)_data;
+	((SNM_FXChainTrackPatcher*)_p)->SetFXChain(patch->chain, patch->inputFX);
+}
+
 void PasteTrackFXChain(const char* _title, WDL_FastString* _chain, bool _inputFX)
 {
 	bool updated = false;
 	if (_chain && _chain->GetLength())
 	{
+		TrackFXChainPatch patch = { _chain, _inputFX };
+		SNM_ChunkTransaction t;
 		for (int i=0; i <= GetNumTracks(); i++) // incl. master
 		{
 			MediaTrack* tr = CSurf_TrackFromID(i, false);
@@ -213,26 +245,11 @@ void PasteTrackFXChain(const char* _title, WDL_FastString* _chain, bool _inputFX
 				// (try to) set track channels
 				updated |= SetTrackChannelsForFXChain(tr, _chain);
 
-				// the meat
-				bool patch = false;
-				SNM_FXChainTrackPatcher p(tr);
-				WDL_FastString currentFXChain;
-				int pos = p.GetSubChunk(_inputFX ? "FXCHAIN_REC" : "FXCHAIN", 2, 0, &currentFXChain, "<ITEM");
-
-				// paste (well.. insert at the end of the current FX chain)
-				if (pos >= 0) 
-				{
-					patch = true;
-					p.GetChunk()->Insert(_chain->Get(), pos + currentFXChain.GetLength() - 2); // -2: before ">\n"
-					p.IncUpdates();
-				}
-				// create fx chain
-				else 
-					patch = p.SetFXChain(_chain, _inputFX);
-
-				updated |= patch;
+				// the meat, patched in one go below
+				t.Add(new SNM_FXChainTrackPatcher(tr), PasteTrackFXChainPatch, &patch);
 			}
 		}
+		updated |= (t.Commit() > 0);
 	}
 	if (updated)
 		Undo_OnStateChangeEx2(NULL, _title, UNDO_STATE_ALL, -1);
@@ -242,6 +259,8 @@ void PasteTrackFXChain(const char* _title, WDL_FastString* _chain, bool _inputFX
 void SetTrackFXChain(const char* _title, WDL_FastString* _chain, bool _inputFX)
 {
 	bool updated = false;
+	TrackFXChainPatch patch = { _chain, _inputFX };
+	SNM_ChunkTransaction t;
 	for (int i=0; i <= GetNumTracks(); i++) // incl. master
 	{
 		MediaTrack* tr = CSurf_TrackFromID(i, false);
@@ -250,12 +269,11 @@ void SetTrackFXChain(const char* _title, WDL_FastString* _chain, bool _inputFX)
 			// (try to) set track channels
 			updated |= SetTrackChannelsForFXChain(tr, _chain);
 
-			// the meat
-			SNM_FXChainTrackPatcher p(tr);
-			bool patch = p.SetFXChain(_chain, _inputFX);
-			updated |= patch;
+			// the meat, patched in one go below
+			t.Add(new SNM_FXChainTrackPatcher(tr), SetTrackFXChainPatch, &patch);
 		}
 	}
+	updated |= (t.Commit() > 0);
 	if (updated)
 		Undo_OnStateChangeEx2(NULL, _title, UNDO_STATE_ALL, -1);
 }
@@ -115,6 +115,7 @@ protected:
 	void GetItemText(SWS_ListItem* item, int iCol, char* str, int iStrMax);
 	void SetItemText(SWS_ListItem* item, int iCol, const char* str);
 	void GetItemList(SWS_ListItemList* pList);
+	bool GetItemSortKey(SWS_ListItem* item, int iCol, SWS_SortKey* key) { return GetTextSortKey(item, iCol, key); }
 	void OnItemSelChanged(SWS_ListItem* item, int iState);
 	void OnItemDblClk(SWS_ListItem* item, int iCol);
 };
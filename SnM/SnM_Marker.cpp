@@ -37,7 +37,7 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 DWORD g_mkrRgnNotifyTime = 0; // really approx (updated on timer)
-WDL_PtrList<MarkerRegion> g_mkrRgnCache;
+std::vector<SNM_MarkerRegionIndex::Entry> g_mkrRgnCache; // state last notified
 WDL_PtrList<SNM_MarkerRegionListener> g_mkrRgnListeners;
 
 void RegisterToMarkerRegionUpdates(SNM_MarkerRegionListener* _listener)
@@ -57,26 +57,30 @@ void UnregisterToMarkerRegionUpdates(SNM_MarkerRegionListener* _listener)
 int UpdateMarkerRegionCache()
 {
 	int updateFlags=0;
-	int i=0, x=0, num, col; double pos, rgnend; const char* name; bool isRgn;
 
-	// added/updated markers/regions?
-	while ((x = EnumProjectMarkers3(NULL, x, &isRgn, &pos, &rgnend, &name, &num, &col)))
+	// markers/regions can be edited w/o undo point: always rebuild here
+	const SNM_MarkerRegionIndex* index = SNM_MarkerRegionIndex::Get(NULL, true);
+	const int sz = index->GetSize(), cacheSz = (int)g_mkrRgnCache.size();
+
+	// added/updated/removed markers/regions?
+	for (int i=0; i<sz || i<cacheSz; i++)
 	{
-		MarkerRegion* m = g_mkrRgnCache.Get(i);
-		if (!m || !m->Compare(isRgn, pos, rgnend, name, num, col))
-		{
-			if (m) g_mkrRgnCache.Delete(i, true);
-			g_mkrRgnCache.Insert(i, new MarkerRegion(isRgn, pos, rgnend, name, num, col));
-			updateFlags |= (isRgn ? SNM_REGION_MASK : SNM_MARKER_MASK);
-		}
-		i++;
+		const SNM_MarkerRegionIndex::Entry* e = index->GetEntry(i);
+		const SNM_MarkerRegionIndex::Entry* c = i<cacheSz ? &g_mkrRgnCache[i] : NULL;
+		if (e && c && *e == *c)
+			continue;
+		if (e) updateFlags |= (e->m_isRgn ? SNM_REGION_MASK : SNM_MARKER_MASK);
+		if (c) updateFlags |= (c->m_isRgn ? SNM_REGION_MASK : SNM_MARKER_MASK);
+		if (updateFlags == (SNM_MARKER_MASK|SNM_REGION_MASK))
+			break;
 	}
-	// removed markers/regions?
-	for (int j=g_mkrRgnCache.GetSize()-1; j>=i; j--) {
-		if (MarkerRegion* m = g_mkrRgnCache.Get(j))
-			updateFlags |= (m->IsRegion() ? SNM_REGION_MASK : SNM_MARKER_MASK);
-		g_mkrRgnCache.Delete(j, true);
+	if (updateFlags)
+	{
+		g_mkrRgnCache.resize(sz);
+		for (int i=0; i<sz; i++)
+			g_mkrRgnCache[i] = *index->GetEntry(i);
 	}
+
 	// project time mode update?
 	static int sPrevTimemode = *ConfigVar<int>("projtimemode");
 	if (updateFlags != (SNM_MARKER_MASK|SNM_REGION_MASK))
@@ -108,29 +112,123 @@ void UpdateMarkerRegionRun()
 // Marker/region helpers
 ///////////////////////////////////////////////////////////////////////////////
 
-// returns the 1st marker or region index found at _pos
-// note: relies on markers & regions indexed by positions
-// _flags: &SNM_MARKER_MASK=marker, &SNM_REGION_MASK=region
-int FindMarkerRegion(ReaProject* _proj, double _pos, int _flags, int* _idOut)
+static unsigned int HashMarkerRegionName(const char* _name)
+{
+	unsigned int h = 2166136261u; // FNV-1a
+	if (_name) while (*_name) { h ^= (unsigned char)*_name++; h *= 16777619u; }
+	return h;
+}
+
+SNM_MarkerRegionIndex* SNM_MarkerRegionIndex::Get(ReaProject* _proj, bool _rebuild)
+{
+	static SNM_MarkerRegionIndex s_index; // one project at a time
+	if (!_proj) _proj = EnumProjects(-1, NULL, 0);
+	if (_rebuild || !s_index.IsUpToDate(_proj))
+		s_index.Build(_proj);
+	return &s_index;
+}
+
+bool SNM_MarkerRegionIndex::IsUpToDate(ReaProject* _proj) const
+{
+	return m_proj == _proj &&
+		m_stateCount == GetProjectStateChangeCount(_proj) &&
+		GetSize() == CountProjectMarkers(_proj, NULL, NULL);
+}
+
+void SNM_MarkerRegionIndex::Build(ReaProject* _proj)
 {
-	bool isrgn;
-	double dPos, dEnd;
-	int x=0, lastx=0, num, foundId=-1, foundx=-1;
-	while ((x = EnumProjectMarkers3(_proj, x, &isrgn, &dPos, &dEnd, NULL, &num, NULL)))
+	m_proj = _proj;
+	m_stateCount = GetProjectStateChangeCount(_proj);
+	m_entries.clear();
+	m_markers.clear();
+	m_regions.clear();
+	m_rgnMaxEnd.clear();
+	m_ids.clear();
+
+	Entry e;
+	const char* name;
+	int x=0;
+	while ((x = EnumProjectMarkers3(_proj, x, &e.m_isRgn, &e.m_pos, &e.m_end, &name, &e.m_id, &e.m_color)))
 	{
-		if ((!isrgn && _flags&SNM_MARKER_MASK) || (isrgn && _flags&SNM_REGION_MASK && _pos<=dEnd))
-		{
-			if (_pos >= dPos) {
-				foundId = MakeMarkerRegionId(num, isrgn);
-				foundx = lastx;
-			}
-			else
-				break;
+		e.m_idx = x-1;
+		e.m_id = MakeMarkerRegionId(e.m_id, e.m_isRgn);
+		e.m_nameHash = HashMarkerRegionName(name);
+		if (!e.m_isRgn) e.m_end = e.m_pos;
+		m_entries.push_back(e);
+		if (m_ids.find(e.m_id) == m_ids.end()) // 1st one wins, as with enumerations
+			m_ids[e.m_id] = e.m_idx;
+
+		if (e.m_isRgn) {
+			m_rgnMaxEnd.push_back(m_regions.empty() ? e.m_end : std::max(e.m_end, m_rgnMaxEnd.back()));
+			m_regions.push_back(e.m_idx);
 		}
-		lastx=x;
+		else
+			m_markers.push_back(e.m_idx);
+	}
+}
+
+// returns the enum index of the marker/region _id, -1 if not found
+int SNM_MarkerRegionIndex::FindById(int _id)
+{
+	for (int pass=0; pass<2; pass++)
+	{
+		std::unordered_map<int,int>::const_iterator it = m_ids.find(_id);
+		if (it == m_ids.end())
+			return -1;
+
+		// cheap check: edits w/o undo point are not seen by IsUpToDate()
+		int num; bool isrgn;
+		if (EnumProjectMarkers3(m_proj, it->second, &isrgn, NULL, NULL, NULL, &num, NULL) && MakeMarkerRegionId(num, isrgn) == _id)
+			return it->second;
+		Build(m_proj);
+	}
+	return -1;
+}
+
+// same as a walk in enum order: returns the last marker, or region ending
+// after _pos, starting at or before _pos
+int SNM_MarkerRegionIndex::Find(double _pos, int _flags, int* _idOut) const
+{
+	int found=-1;
+	if (_flags&SNM_MARKER_MASK)
+	{
+		// last marker such as pos <= _pos
+		std::vector<int>::const_iterator it = std::upper_bound(m_markers.begin(), m_markers.end(), _pos,
+			[this](double _p, int _idx) { return _p < m_entries[_idx].m_pos; });
+		if (it != m_markers.begin())
+			found = *(--it);
+	}
+	if (_flags&SNM_REGION_MASK)
+	{
+		std::vector<int>::const_iterator it = std::upper_bound(m_regions.begin(), m_regions.end(), _pos,
+			[this](double _p, int _idx) { return _p < m_entries[_idx].m_pos; });
+		for (int i=(int)(it-m_regions.begin())-1; i>=0 && m_rgnMaxEnd[i]>=_pos && m_regions[i]>found; i--)
+			if (m_entries[m_regions[i]].m_end >= _pos) {
+				found = m_regions[i];
+				break;
+			}
 	}
-	if (_idOut) *_idOut = foundId;
-	return foundx;
+	if (_idOut) *_idOut = found>=0 ? m_entries[found].m_id : -1;
+	return found;
+}
+
+// gets the enum indexes of all regions containing _pos, returns their number
+int SNM_MarkerRegionIndex::GetRegionsAt(double _pos, WDL_TypedBuf<int>* _idxOut) const
+{
+	_idxOut->Resize(0, false);
+	std::vector<int>::const_iterator it = std::upper_bound(m_regions.begin(), m_regions.end(), _pos,
+		[this](double _p, int _idx) { return _p < m_entries[_idx].m_pos; });
+	for (int i=(int)(it-m_regions.begin())-1; i>=0 && m_rgnMaxEnd[i]>=_pos; i--)
+		if (m_entries[m_regions[i]].m_end >= _pos)
+			_idxOut->Add(m_regions[i]);
+	return _idxOut->GetSize();
+}
+
+// returns the 1st marker or region index found at _pos
+// _flags: &SNM_MARKER_MASK=marker, &SNM_REGION_MASK=region
+int FindMarkerRegion(ReaProject* _proj, double _pos, int _flags, int* _idOut)
+{
+	return SNM_MarkerRegionIndex::Get(_proj)->Find(_pos, _flags, _idOut);
 }
 
 
@@ -161,17 +259,7 @@ int GetMarkerRegionIdFromIndex(ReaProject* _proj, int _idx)
 
 int GetMarkerRegionIndexFromId(ReaProject* _proj, int _id) 
 {
-	if (_id > 0)
-	{
-		int x=0, lastx=0, num=(_id&0x3FFFFFFF), num2; 
-		bool isrgn = IsRegion(_id), isrgn2;
-		while ((x = EnumProjectMarkers3(_proj, x, &isrgn2, NULL, NULL, NULL, &num2, NULL))) {
-			if (num == num2 && isrgn == isrgn2)
-				return lastx;
-			lastx=x;
-		}
-	}
-	return -1;
+	return _id > 0 ? SNM_MarkerRegionIndex::Get(_proj)->FindById(_id) : -1;
 }
 
 int GetMarkerRegionNumFromId(int _id) {
@@ -184,27 +272,9 @@ bool IsRegion(int _id) {
 
 int EnumMarkerRegionById(ReaProject* _proj, int _id, bool* _isrgn, double* _pos, double* _end, const char** _name, int* _num, int* _color)
 {
-	if (_id > 0)
-	{
-		const char* name2;
-		double pos2, end2;
-		bool isrgn = IsRegion(_id), isrgn2;
-		int  num=(_id&0x3FFFFFFF), x=0, lastx=0, num2, col2;
-		while ((x = EnumProjectMarkers3(_proj, x, &isrgn2, &pos2, &end2, &name2, &num2, &col2)))
-		{
-			if (num == num2 && isrgn == isrgn2)
-			{
-				if (_isrgn)	*_isrgn = isrgn2;
-				if (_pos)	*_pos = pos2;
-				if (_end)	*_end = end2;
-				if (_name)	*_name = name2;
-				if (_num)	*_num = num2;
-				if (_color)	*_color = col2;
-				return lastx;
-			}
-            lastx=x;
-		}
-	}
+	int idx = GetMarkerRegionIndexFromId(_proj, _id);
+	if (idx >= 0 && EnumProjectMarkers3(_proj, idx, _isrgn, _pos, _end, _name, _num, _color))
+		return idx;
 	return -1;
 }
 
@@ -305,22 +375,27 @@ void FillMarkerRegionMenu(ReaProject* _proj, HMENU _menu, int _msgStart, int _fl
 bool GotoMarkerRegion(ReaProject* _proj, int _num, int _flags, bool _select = false)
 {
 	bool isrgn; double pos, end;
-	int x=0, n; 
-	while ((x = EnumProjectMarkers3(_proj, x, &isrgn, &pos, &end, NULL, &n, NULL)))
-		if (n == _num && ((!isrgn && _flags&SNM_MARKER_MASK) || (isrgn && _flags&SNM_REGION_MASK)))
-		{
-			PreventUIRefresh(1);
+	int x = (_flags&SNM_MARKER_MASK) ? GetMarkerRegionIndexFromId(_proj, MakeMarkerRegionId(_num, false)) : -1;
+	if (_flags&SNM_REGION_MASK)
+	{
+		int xr = GetMarkerRegionIndexFromId(_proj, MakeMarkerRegionId(_num, true));
+		if (xr >= 0 && (x < 0 || xr < x))
+			x = xr;
+	}
+	if (x >= 0 && EnumProjectMarkers3(_proj, x, &isrgn, &pos, &end, NULL, NULL, NULL))
+	{
+		PreventUIRefresh(1);
 
-			if (_select && isrgn && (_flags&SNM_REGION_MASK))
-				GetSet_LoopTimeRange2(NULL, true, true, &pos, &end, false); // seek is managed below
+		if (_select && isrgn && (_flags&SNM_REGION_MASK))
+			GetSet_LoopTimeRange2(NULL, true, true, &pos, &end, false); // seek is managed below
 
-			const int opt = ConfigVar<int>("smoothseek").value_or(0); // obeys smooth seek
-			SetEditCurPos2(_proj, pos, true, opt); // includes an undo point, if enabled in prefs
+		const int opt = ConfigVar<int>("smoothseek").value_or(0); // obeys smooth seek
+		SetEditCurPos2(_proj, pos, true, opt); // includes an undo point, if enabled in prefs
 
-			PreventUIRefresh(-1);
+		PreventUIRefresh(-1);
 
-			return true;
-		}
+		return true;
+	}
 	return false;
 }
 
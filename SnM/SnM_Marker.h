@@ -32,6 +32,8 @@
 
 #include "../MarkerList/MarkerListClass.h"
 
+#include <unordered_map>
+
 
 // register/unregister to marker/region changes
 class SNM_MarkerRegionListener {
@@ -42,6 +44,42 @@ public:
 	virtual void NotifyMarkerRegionUpdate(int _updateFlags) {}
 };
 
+// sorted index of the markers/regions of a project, rebuilt lazily when the
+// project state changes: O(log n) lookups by position, by id via a hash map,
+// regions containing a position via a list sorted by start + running max end
+class SNM_MarkerRegionIndex {
+public:
+	struct Entry {
+		int m_idx, m_id, m_color;
+		bool m_isRgn;
+		double m_pos, m_end;
+		unsigned int m_nameHash;
+		bool operator==(const Entry& _e) const {
+			return m_id==_e.m_id && m_color==_e.m_color && m_isRgn==_e.m_isRgn && m_pos==_e.m_pos && m_end==_e.m_end && m_nameHash==_e.m_nameHash;
+		}
+	};
+
+	static SNM_MarkerRegionIndex* Get(ReaProject* _proj, bool _rebuild = false);
+
+	int GetSize() const { return (int)m_entries.size(); }
+	const Entry* GetEntry(int _idx) const { return _idx>=0 && _idx<GetSize() ? &m_entries[_idx] : NULL; }
+	int FindById(int _id);
+	int Find(double _pos, int _flags, int* _idOut = NULL) const;
+	int GetRegionsAt(double _pos, WDL_TypedBuf<int>* _idxOut) const;
+
+private:
+	SNM_MarkerRegionIndex() : m_proj(NULL), m_stateCount(-1) {}
+	bool IsUpToDate(ReaProject* _proj) const;
+	void Build(ReaProject* _proj);
+
+	ReaProject* m_proj;
+	int m_stateCount;
+	std::vector<Entry> m_entries; // enum order, i.e. sorted by position
+	std::vector<int> m_markers, m_regions; // enum indexes
+	std::vector<double> m_rgnMaxEnd; // max region end up to m_regions[i]
+	std::unordered_map<int,int> m_ids; // id -> enum index
+};
+
 void RegisterToMarkerRegionUpdates(SNM_MarkerRegionListener* _sub);
 void UnregisterToMarkerRegionUpdates(SNM_MarkerRegionListener* _sub) ;
 void UpdateMarkerRegionRun();
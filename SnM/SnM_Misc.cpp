@@ -80,7 +80,7 @@ MediaItem_Take* SNM_GetMediaItemTakeByGUID(ReaProject* _project, const char* _gu
 	{
 		GUID g;
 		stringToGuid(_guid, &g);
-		return GetMediaItemTakeByGUID(_project, &g);
+		return GuidToTake(_project, &g);
 	}
 	return NULL;
 }
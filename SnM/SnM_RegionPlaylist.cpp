@@ -163,19 +163,23 @@ bool RegionPlaylist::IsValidIem(int _i)
 // return the first found playlist idx for _pos
 int RegionPlaylist::IsInPlaylist(double _pos, bool _repeat, int _startWith)
 {
-	double rgnpos, rgnend;
-	for (int i=_startWith; i<GetSize(); i++)
-		if (RgnPlaylistItem* plItem = Get(i))
-			if (plItem->m_rgnId>0 && plItem->m_cnt!=0 && EnumMarkerRegionById(NULL, plItem->m_rgnId, NULL, &rgnpos, &rgnend, NULL, NULL, NULL)>=0)
-				if (_pos >= rgnpos && _pos <= rgnend)
-					return i;
-	// 2nd try
-	if (_repeat)
-		for (int i=0; i<_startWith; i++)
+	// regions containing _pos (usually very few, even with huge projects)
+	WDL_TypedBuf<int> rgnIdx;
+	const SNM_MarkerRegionIndex* index = SNM_MarkerRegionIndex::Get(NULL);
+	if (!index->GetRegionsAt(_pos, &rgnIdx))
+		return -1;
+
+	for (int pass=0; pass<(_repeat?2:1); pass++)
+	{
+		// 2nd try: from the start
+		const int start = pass ? 0 : _startWith, end = pass ? _startWith : GetSize();
+		for (int i=start; i<end; i++)
 			if (RgnPlaylistItem* plItem = Get(i))
-				if (plItem->m_rgnId>0 && plItem->m_cnt!=0 && EnumMarkerRegionById(NULL, plItem->m_rgnId, NULL, &rgnpos, &rgnend, NULL, NULL, NULL)>=0)
-					if (_pos >= rgnpos && _pos <= rgnend)
-						return i;
+				if (plItem->m_rgnId>0 && plItem->m_cnt!=0)
+					for (int j=0; j<rgnIdx.GetSize(); j++)
+						if (index->GetEntry(rgnIdx.Get()[j])->m_id == plItem->m_rgnId)
+							return i;
+	}
 	return -1;
 }
 
@@ -398,6 +402,26 @@ void RegionPlaylistView::GetItemList(SWS_ListItemList* pList)
 				pList->Add(item);
 }
 
+// row texts depend on the item, the playing state and the project's regions/time format
+bool RegionPlaylistView::IsItemDirty(SWS_ListItem* item)
+{
+	RgnPlaylistItem* pItem = (RgnPlaylistItem*)item;
+	RegionPlaylist* curpl = GetPlaylist();
+	int playMark = 0;
+	if (curpl && g_playPlaylist>=0 && curpl==GetPlaylist(g_playPlaylist))
+		playMark = !g_unsync && curpl->Get(g_playCur)==pItem ? 1 : (curpl->Get(g_playNext)==pItem ? 2 : 0);
+
+	const ConfigVar<int> timeMode("projtimemode");
+	WDL_INT64 state[] = {
+		pItem->m_rgnId,
+		pItem->m_cnt,
+		playMark,
+		GetProjectStateChangeCount(NULL),
+		(WDL_INT64)(INT_PTR)EnumProjects(-1, NULL, 0),
+		timeMode.value_or(0) };
+	return IsRowStateChanged(item, state, sizeof(state)/sizeof(WDL_INT64));
+}
+
 void RegionPlaylistView::SetItemText(SWS_ListItem* item, int iCol, const char* str)
 {
 	if (RgnPlaylistItem* pItem = (RgnPlaylistItem*)item)
@@ -82,6 +82,7 @@ public:
 protected:
 	void GetItemText(SWS_ListItem* item, int iCol, char* str, int iStrMax);
 	void GetItemList(SWS_ListItemList* pList);
+	bool IsItemDirty(SWS_ListItem* item);
 	void SetItemText(SWS_ListItem* item, int iCol, const char* str);
 	void OnItemClk(SWS_ListItem* item, int iCol, int iKeyState);
 	void OnItemDblClk(SWS_ListItem* item, int iCol);
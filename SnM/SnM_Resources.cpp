@@ -49,6 +49,10 @@
 #include <WDL/localize/localize.h>
 #include <WDL/projectcontext.h>
 
+#include <atomic>
+#include <mutex>
+#include <thread>
+
 #define RES_WND_ID					"SnMResources"
 #define IMG_WND_ID					"SnMImage"
 #define RES_INI_SEC					"Resources"
@@ -387,7 +391,8 @@ void UntieAllResFileFromProject(ReaProject* _prj, const char* _prjPath, int _typ
 ///////////////////////////////////////////////////////////////////////////////
 
 ResourceList::ResourceList(const char* _resDir, const char* _name, const char* _ext, int _flags)
-	: m_name(_name), m_ext(_ext), m_flags(_flags), WDL_PtrList<ResourceItem>()
+	: m_name(_name), m_ext(_ext), m_flags(_flags), WDL_PtrList<ResourceItem>(),
+	  m_idxSize(0), m_nonEmpty(0), m_idxValid(false)
 {
 	char tmp[512]="";
 
@@ -432,33 +437,129 @@ ResourceList::ResourceList(const char* _resDir, const char* _name, const char* _
 		m_exts.Add(new WDL_FastString("WAV*"));
 }
 
+int ResourceList::GetNonEmptySize()
+{
+	if (!IsIndexValid())
+		RebuildIndex();
+	return m_nonEmpty;
+}
+
 // _path: short resource path or full path
 ResourceItem* ResourceList::AddSlot(const char* _path, const char* _desc)
 {
-	return Add(new ResourceItem(GetShortResourcePath(m_resDir.Get(), _path), _desc));
+	bool idxValid = IsIndexValid();
+	ResourceItem* item = Add(new ResourceItem(GetShortResourcePath(m_resDir.Get(), _path), _desc));
+	if (idxValid) {
+		m_idxSize++;
+		IndexSlot(GetSize()-1);
+	}
+	else
+		m_idxValid = false;
+	return item;
 }
 
 // _path: short resource path or full path
 ResourceItem* ResourceList::InsertSlot(int _slot, const char* _path, const char* _desc)
 {
-	ResourceItem* item = NULL;
-	const char* shortPath = GetShortResourcePath(m_resDir.Get(), _path);
-	if (_slot >=0 && _slot < GetSize())
-		item = Insert(_slot, new ResourceItem(shortPath, _desc));
-	else
-		item = Add(new ResourceItem(shortPath, _desc));
-	return item;
+	if (_slot >=0 && _slot < GetSize()) {
+		m_idxValid = false; // next slots are shifted
+		return Insert(_slot, new ResourceItem(GetShortResourcePath(m_resDir.Get(), _path), _desc));
+	}
+	return AddSlot(_path, _desc);
+}
+
+bool ResourceList::RemoveSlot(int _slot, bool _wantDelete)
+{
+	if (_slot>=0 && _slot<GetSize())
+	{
+		// removing the last slot is the only case that does not shift slots
+		// (e.g. ClearDeleteSlotsFiles() removes slots from the end)
+		if (_slot == GetSize()-1 && IsIndexValid()) {
+			UnindexSlot(_slot);
+			m_idxSize--;
+		}
+		else
+			m_idxValid = false;
+		Delete(_slot, _wantDelete);
+		return true;
+	}
+	return false;
+}
+
+void ResourceList::EmptySlots()
+{
+	EmptySafe(true);
+	m_pathIdx.clear();
+	m_idxSize = m_nonEmpty = 0;
+	m_idxValid = true;
 }
 
 int ResourceList::FindByPath(const char* _fullPath)
+{
+	if (!_fullPath)
+		return -1;
+	if (!IsIndexValid())
+		RebuildIndex();
+
+	std::string key;
+	GetPathKey(_fullPath, &key);
+	auto it = m_pathIdx.find(key);
+	return it != m_pathIdx.end() ? it->second.m_slot : -1;
+}
+
+// paths are compared case-insensitively, like _stricmp() does
+void ResourceList::GetPathKey(const char* _fullPath, std::string* _key)
+{
+	_key->assign(_fullPath);
+	for (size_t i=0; i<_key->size(); i++)
+		(*_key)[i] = (char)tolower((unsigned char)(*_key)[i]);
+}
+
+void ResourceList::IndexSlot(int _slot)
 {
 	char fullpath[SNM_MAX_PATH];
-	if (_fullPath)
-		for (int i=0; i<GetSize(); i++)
-			if (GetFullPath(i, fullpath, sizeof(fullpath)))
-				if (!_stricmp(_fullPath, fullpath))
-					return i;
-	return -1;
+	if (!IsIndexValid() || !GetFullPath(_slot, fullpath, sizeof(fullpath)))
+		return;
+
+	std::string key;
+	GetPathKey(fullpath, &key);
+	auto res = m_pathIdx.emplace(key, PathIndexEntry{_slot, 1});
+	if (!res.second) {
+		res.first->second.m_count++;
+		res.first->second.m_slot = std::min(res.first->second.m_slot, _slot);
+	}
+	if (!Get(_slot)->IsDefault())
+		m_nonEmpty++;
+}
+
+void ResourceList::UnindexSlot(int _slot)
+{
+	char fullpath[SNM_MAX_PATH];
+	if (!IsIndexValid() || !GetFullPath(_slot, fullpath, sizeof(fullpath)))
+		return;
+
+	std::string key;
+	GetPathKey(fullpath, &key);
+	auto it = m_pathIdx.find(key);
+	if (it == m_pathIdx.end() || (it->second.m_count>1 && it->second.m_slot==_slot)) {
+		m_idxValid = false; // next duplicate slot unknown, rebuild on next lookup
+		return;
+	}
+	if (--it->second.m_count <= 0)
+		m_pathIdx.erase(it);
+	if (!Get(_slot)->IsDefault())
+		m_nonEmpty--;
+}
+
+void ResourceList::RebuildIndex()
+{
+	m_pathIdx.clear();
+	m_pathIdx.reserve(GetSize());
+	m_idxSize = GetSize();
+	m_nonEmpty = 0;
+	m_idxValid = true;
+	for (int i=0; i<GetSize(); i++)
+		IndexSlot(i);
 }
 
 bool ResourceList::GetFullPath(int _slot, char* _fullFn, int _fullFnSz)
@@ -474,7 +575,10 @@ bool ResourceList::SetFromFullPath(int _slot, const char* _fullPath)
 {
 	if (ResourceItem* item = Get(_slot))
 	{
+		UnindexSlot(_slot);
 		item->m_shortPath.Set(GetShortResourcePath(m_resDir.Get(), _fullPath));
+		item->Changed();
+		IndexSlot(_slot);
 		return true;
 	}
 	return false;
@@ -580,7 +684,9 @@ void ResourceList::GetFileFilter(char* _filter, size_t _filterSz, bool _dblNull)
 bool ResourceList::ClearSlot(int _slot)
 {
 	if (_slot>=0 && _slot<GetSize()) {
+		UnindexSlot(_slot);
 		Get(_slot)->Clear();
+		IndexSlot(_slot);
 		return true;
 	}
 	return false;
@@ -716,6 +822,7 @@ void ResourcesView::SetItemText(SWS_ListItem* item, int iCol, const char* str)
 			case COL_COMMENT:
 				pItem->m_comment.Set(str);
 				pItem->m_comment.Ellipsize(128,128);
+				pItem->Changed();
 				Update();
 				break;
 		}
@@ -728,10 +835,14 @@ void ResourcesView::OnItemDblClk(SWS_ListItem* item, int iCol) {
 
 void ResourcesView::GetItemList(SWS_ListItemList* pList)
 {
+	m_slots.clear();
 	ResourceList* fl = g_SNM_ResSlots.Get(g_resType);
 	if (!fl)
 		return;
 
+	for (int i=0; i < fl->GetSize(); i++)
+		m_slots[(SWS_ListItem*)fl->Get(i)] = i;
+
 	if (IsFiltered())
 	{
 		char buf[SNM_MAX_PATH] = "";
@@ -774,6 +885,18 @@ void ResourcesView::GetItemList(SWS_ListItemList* pList)
 	}
 }
 
+// row texts only depend on the item, its slot and the "current project slot" bullet
+bool ResourcesView::IsItemDirty(SWS_ListItem* item)
+{
+	std::unordered_map<SWS_ListItem*, int>::const_iterator it = m_slots.find(item);
+	const int slot = it != m_slots.end() ? it->second : -1;
+	WDL_INT64 state[] = {
+		((ResourceItem*)item)->m_rev,
+		slot,
+		g_resType==g_tiedSlotActions[SNM_SLOT_PRJ] && g_prjCurSlot>=0 && g_prjCurSlot==slot };
+	return IsRowStateChanged(item, state, sizeof(state)/sizeof(WDL_INT64));
+}
+
 void ResourcesView::OnBeginDrag(SWS_ListItem* _item)
 {
 #ifdef _WIN32
@@ -2041,7 +2164,7 @@ void ResourcesWnd::OnDroppedFiles(HDROP _h)
 	{
 		dropSlot = fl->GetSize();
 		for (int i=0; i < iValidFiles; i++)
-			fl->Add(new ResourceItem());
+			fl->AddSlot();
 	}
 	// drop on a slot => insert slots at drop point
 	else 
@@ -2064,10 +2187,10 @@ void ResourcesWnd::OnDroppedFiles(HDROP _h)
 		// internal drag-drop?
 		if (g_dragResourceItems.GetSize())
 		{
-			if (ResourceItem* item = fl->Get(slot))
+			if (fl->SetFromFullPath(slot, g_dragResourceItems.Get(i)->m_shortPath.Get())) // no-op for short paths
 			{
-				item->m_shortPath.Set(g_dragResourceItems.Get(i)->m_shortPath.Get());
-				item->m_comment.Set(g_dragResourceItems.Get(i)->m_comment.Get());
+				fl->Get(slot)->m_comment.Set(g_dragResourceItems.Get(i)->m_comment.Get());
+				fl->Get(slot)->Changed();
 				dropped++;
 				pItem = fl->Get(slot+1); 
 			}
@@ -2093,7 +2216,7 @@ void ResourcesWnd::OnDroppedFiles(HDROP _h)
 				{
 					if (j < dropSlot)
 						dropSlot--;
-					fl->Delete(j, false);
+					fl->RemoveSlot(j, false);
 				}
 
 		Update();
@@ -2319,7 +2442,7 @@ void ResourcesWnd::AddSlot()
 	if (ResourceList* fl = g_SNM_ResSlots.Get(g_resType))
 	{
 		int idx = fl->GetSize();
-		if (fl->Add(new ResourceItem())) {
+		if (fl->AddSlot()) {
 			Update();
 			SelectBySlot(idx);
 		}
@@ -2402,8 +2525,8 @@ bool AutoSaveSlot(int _type, const char* _dirPath,
 				if (char* p = strrchr(fn, '.'))
 				{
 					strcpy(p+1, _ext);
-					const char* shortPath = GetShortResourcePath(g_SNM_ResSlots.Get(_type)->GetResourceDir(), fn);
-					_owSlots->Get(*_owIdx)->m_shortPath.Set(shortPath);
+					ResourceList* fl = g_SNM_ResSlots.Get(_type);
+					fl->SetFromFullPath(fl->Find(_owSlots->Get(*_owIdx)), fn);
 				}
 			}
 			saved = (SaveSlot ? SaveSlot(_obj, fn) : SNM_CopyFile(fn, _name));
@@ -2425,8 +2548,8 @@ bool AutoSaveSlot(int _type, const char* _dirPath,
 			}
 			else 
 			{
-				const char* shortPath = GetShortResourcePath(g_SNM_ResSlots.Get(_type)->GetResourceDir(), fn);
-				_owSlots->Get(*_owIdx-1)->m_shortPath.Set(shortPath);
+				ResourceList* fl = g_SNM_ResSlots.Get(_type);
+				fl->SetFromFullPath(fl->Find(_owSlots->Get(*_owIdx-1)), fn);
 			}
 		}
 	}
@@ -2538,7 +2661,79 @@ void AutoSave(int _type, bool _ow, int _flags)
 	}
 }
 
+// auto-fill directory walk, performed in a worker thread: 
+// found files are streamed to the main thread (see AutoFillJob)
+class AutoFillScan
+{
+public:
+	AutoFillScan(ResourceList* _fl, const char* _dir, const char* _fileFilter)
+		: m_fl(_fl), m_dir(_dir), m_fileFilter(_fileFilter), 
+		  m_startSlot(_fl->GetSize()), m_added(0), m_done(false), m_stop(false)
+	{
+		m_thread = std::thread(&AutoFillScan::Scan, this);
+	}
+
+	~AutoFillScan()
+	{
+		m_stop = true;
+		m_thread.join();
+		m_files.Empty(true);
+	}
+
+	// moves the files found so far to _files, returns true once the scan is over
+	bool GetFiles(WDL_PtrList<WDL_FastString>* _files)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (int i=0; i<m_files.GetSize(); i++)
+			_files->Add(m_files.Get(i));
+		m_files.Empty(false);
+		return m_done;
+	}
+
+	ResourceList* m_fl;
+	WDL_FastString m_dir;
+	int m_startSlot, m_added;
+
+private:
+	static bool OnFile(const char* _fn, void* _scan)
+	{
+		AutoFillScan* scan = (AutoFillScan*)_scan;
+		std::lock_guard<std::mutex> lock(scan->m_mutex);
+		scan->m_files.Add(new WDL_FastString(_fn));
+		return true;
+	}
+
+	static bool IsStopped(void* _scan) {
+		return ((AutoFillScan*)_scan)->m_stop;
+	}
+
+	void Scan()
+	{
+		ScanFiles(OnFile, this, m_dir.Get(), m_fileFilter.Get(), true, IsStopped);
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_done = true;
+	}
+
+	WDL_FastString m_fileFilter;
+	WDL_PtrList<WDL_FastString> m_files; // found files, not streamed yet
+	bool m_done;
+	std::atomic<bool> m_stop; // checked for each directory entry, not only on matches
+	std::mutex m_mutex;
+	std::thread m_thread;
+};
+
+WDL_PtrList<AutoFillScan> g_autoFillScans;
+
+// stops and discards the scan of a resource list about to be deleted
+static void CancelAutoFill(ResourceList* _fl)
+{
+	for (int i=g_autoFillScans.GetSize()-1; i>=0; i--)
+		if (g_autoFillScans.Get(i)->m_fl == _fl)
+			g_autoFillScans.Delete(i, true);
+}
+
 // recursive from auto-fill path
+// note: the scan is asynchronous, slots are added by AutoFillJob as files are found
 void AutoFill(int _type)
 {
 	ResourceList* fl = g_SNM_ResSlots.Get(_type);
@@ -2548,36 +2743,69 @@ void AutoFill(int _type)
 	if (!CheckSetAutoDirectory(__LOCALIZE("Auto-fill","sws_DLG_150"), _type, false))
 		return;
 
-	int startSlot = g_SNM_ResSlots.Get(_type)->GetSize();
+	// already in progress?
+	for (int i=0; i<g_autoFillScans.GetSize(); i++)
+		if (g_autoFillScans.Get(i)->m_fl == fl)
+			return;
 
 	char fileFilter[2048] = ""; // filters need some room!
 	fl->GetFileFilter(fileFilter, sizeof(fileFilter), false);
 
-	WDL_PtrList_DeleteOnDestroy<WDL_String> files; 
-	ScanFiles(&files, GetAutoFillDir(_type), fileFilter, true);
-	if (int sz = files.GetSize())
-		for (int i=0; i<sz; i++)
-			if (fl->FindByPath(files.Get(i)->Get()) < 0) { // skip if already present
-				TieResFileToProject(files.Get(i)->Get(), _type);
-				fl->AddSlot(files.Get(i)->Get());
-			}
+	g_autoFillScans.Add(new AutoFillScan(fl, GetAutoFillDir(_type), fileFilter));
+	ScheduledJob::Schedule(new AutoFillJob());
+}
 
-	if (startSlot != fl->GetSize())
+// adds slots for the files found so far, polled until all scans are over
+void AutoFillJob::Perform()
+{
+	WDL_PtrList_DeleteOnDestroy<WDL_FastString> files, msgs;
+	for (int i=g_autoFillScans.GetSize()-1; i>=0; i--)
 	{
-		if (g_resType==_type)
+		AutoFillScan* scan = g_autoFillScans.Get(i);
+		bool done = scan->GetFiles(&files);
+
+		// scans of deleted bookmarks are cancelled, see DeleteBookmark()
+		// note: types are not stable (bookmark deletion), hence the lookup
+		ResourceList* fl = scan->m_fl;
+		int type = g_SNM_ResSlots.Find(fl);
+		int added = 0;
+		for (int j=0; j<files.GetSize(); j++)
+			if (fl->FindByPath(files.Get(j)->Get()) < 0) { // skip if already present
+				TieResFileToProject(files.Get(j)->Get(), type);
+				fl->AddSlot(files.Get(j)->Get());
+				added++;
+			}
+		files.Empty(true);
+		scan->m_added += added;
+
+		if (g_resType==type)
 			if (ResourcesWnd* w = g_resWndMgr.Get()) {
-				w->Update();
-				w->SelectBySlot(startSlot, g_SNM_ResSlots.Get(_type)->GetSize());
+				if (added)
+					w->Update();
+				if (done && scan->m_added)
+					w->SelectBySlot(scan->m_startSlot, fl->GetSize());
 			}
+
+		if (done)
+		{
+			if (!scan->m_added)
+			{
+				char msg[SNM_MAX_PATH]="";
+				const char* path = scan->m_dir.Get();
+				if (path && *path) snprintf(msg, sizeof(msg), __LOCALIZE_VERFMT("No slot added from: %s\n%s","sws_DLG_150"), path, AUTOFILL_ERR_STR);
+				else snprintf(msg, sizeof(msg), __LOCALIZE_VERFMT("No slot added!\n%s","sws_DLG_150"), AUTOFILL_ERR_STR);
+				msgs.Add(new WDL_FastString(msg));
+			}
+			g_autoFillScans.Delete(i, true);
+		}
 	}
-	else
-	{
-		const char* path = GetAutoFillDir(_type);
-		char msg[SNM_MAX_PATH]="";
-		if (path && *path) snprintf(msg, sizeof(msg), __LOCALIZE_VERFMT("No slot added from: %s\n%s","sws_DLG_150"), path, AUTOFILL_ERR_STR);
-		else snprintf(msg, sizeof(msg), __LOCALIZE_VERFMT("No slot added!\n%s","sws_DLG_150"), AUTOFILL_ERR_STR);
-		MessageBox(g_resWndMgr.GetMsgHWND(), msg, __LOCALIZE("S&M - Warning","sws_DLG_150"), MB_OK);
-	}
+
+	if (g_autoFillScans.GetSize())
+		ScheduledJob::Schedule(new AutoFillJob());
+
+	// warn once g_autoFillScans is not used anymore here (modal loop)
+	for (int i=0; i<msgs.GetSize(); i++)
+		MessageBox(g_resWndMgr.GetMsgHWND(), msgs.Get(i)->Get(), __LOCALIZE("S&M - Warning","sws_DLG_150"), MB_OK);
 }
 
 
@@ -2665,7 +2893,7 @@ WDL_FastString* GetOrPromptOrBrowseSlot(int _type, int* _slot)
 	// adds the needed number of slots (macro friendly)
 	bool uiUpdate = (*_slot >= fl->GetSize());
 	while (*_slot >= fl->GetSize())
-		fl->Add(new ResourceItem());
+		fl->AddSlot();
 
 	// get filename or browse if the slot is empty (macro friendly)
 	char fn[SNM_MAX_PATH]="";
@@ -2749,7 +2977,7 @@ void ClearDeleteSlotsFiles(int _type, int _mode, int _slot)
 				if (_mode&1 || _mode&8) 
 				{
 					slots.Delete(slot, false); // keep the sel list "in sync"
-					fl->Delete(slot, false); // remove slot, pointer not deleted yet
+					fl->RemoveSlot(slot, false); // remove slot, pointer not deleted yet
 					delItems.Add(item); // for later pointer deletion..
 				}
 				else if (_mode&2)
@@ -3042,6 +3270,8 @@ void DeleteBookmark(int _bookmarkType)
 		}
 		if (reply != IDCANCEL)
 		{
+			CancelAutoFill(g_SNM_ResSlots.Get(_bookmarkType));
+
 			// cleanup ini file (types may not be contiguous anymore..)
 			FlushCustomTypesIniFile();
 			ClearDeleteSlotsFiles(_bookmarkType, 8|(reply==IDYES?4:0));
@@ -3271,11 +3501,11 @@ int ResourcesInit()
 			
 			//JFB TODO? would be faster to read section in one go..
 			GetPrivateProfileString(iniSec, "Max_slot", "0", maxSlotCount, sizeof(maxSlotCount), g_SNM_IniFn.Get()); 
-			list->EmptySafe(true);
+			list->EmptySlots();
 			int cnt = atoi(maxSlotCount);
 			for (int j=0; j<cnt; j++) {
 				ReadSlotIniFile(iniSec, j, path, sizeof(path), desc, sizeof(desc));
-				list->Add(new ResourceItem(path, desc));
+				list->AddSlot(path, desc);
 			}
 		}
 	}
@@ -3293,6 +3523,8 @@ void ResourcesExit()
 {
 	plugin_register("-projectconfig", &s_projectconfig);
 
+	g_autoFillScans.Empty(true); // stop pending auto-fill scans
+
 	WDL_PtrList_DeleteOnDestroy<WDL_FastString> iniSections;
 	GetIniSectionNames(&iniSections);
 
@@ -56,10 +56,12 @@ enum {
 class ResourceItem {
 public:
 	ResourceItem(const char* _shortPath="", const char* _comment="") 
-		: m_shortPath(_shortPath), m_comment(_comment) {}
+		: m_shortPath(_shortPath), m_comment(_comment), m_rev(SWS_ListView::NewItemRevision()) {}
 	bool IsDefault() { return (!m_shortPath.GetLength()); }
-	void Clear() { m_shortPath.Set(""); m_comment.Set(""); }
+	void Clear() { m_shortPath.Set(""); m_comment.Set(""); Changed(); }
+	void Changed() { m_rev = SWS_ListView::NewItemRevision(); } // call when altering the members below
 	WDL_FastString m_shortPath, m_comment;
+	int m_rev; // see ResourcesView::IsItemDirty()
 };
 
 
@@ -76,9 +78,13 @@ class ResourceList : public WDL_PtrList<ResourceItem>
   public:
 	ResourceList(const char* _resDir, const char* _desc, const char* _ext, int _flags);
 	~ResourceList() { m_exts.Empty(true); }
-	int GetNonEmptySize() { int cnt=0; for(int i=0; i<GetSize(); i++) if (!Get(i)->IsDefault()) cnt++; return cnt; }  
+	// note: slots must be added, removed or modified with the methods below so that 
+	// the path index (FindByPath(), GetNonEmptySize()) remains in sync
+	int GetNonEmptySize();
 	ResourceItem* AddSlot(const char* _path="", const char* _desc="");
 	ResourceItem* InsertSlot(int _slot, const char* _path="", const char* _desc="");
+	bool RemoveSlot(int _slot, bool _wantDelete = false);
+	void EmptySlots();
 	int FindByPath(const char* _fullPath);
 	bool GetFullPath(int _slot, char* _fullFn, int _fullFnSz);
 	bool SetFromFullPath(int _slot, const char* _fullPath);
@@ -101,7 +107,17 @@ protected:
 	WDL_FastString m_ext;				// file extensions w/o '.' (ex: "rfxchain"), "" means all supported media file extensions
 	int m_flags;						// see bitmask definition above
 private:
+	struct PathIndexEntry { int m_slot, m_count; }; // first slot for a path + number of slots sharing it
+	bool IsIndexValid() { return m_idxValid && m_idxSize==GetSize(); }
+	void GetPathKey(const char* _fullPath, std::string* _key);
+	void IndexSlot(int _slot);
+	void UnindexSlot(int _slot);
+	void RebuildIndex();
+
 	WDL_PtrList<WDL_FastString> m_exts;	// split file extensions
+	std::unordered_map<std::string, PathIndexEntry> m_pathIdx; // lowercase full path -> slot, built lazily
+	int m_idxSize, m_nonEmpty;
+	bool m_idxValid;
 };
 
 
@@ -116,7 +132,11 @@ protected:
 	void SetItemText(SWS_ListItem* item, int iCol, const char* str);
 	void OnItemDblClk(SWS_ListItem* item, int iCol);
 	void GetItemList(SWS_ListItemList* pList);
+	bool GetItemSortKey(SWS_ListItem* item, int iCol, SWS_SortKey* key) { return GetTextSortKey(item, iCol, key); }
+	bool IsItemDirty(SWS_ListItem* item);
 	void OnBeginDrag(SWS_ListItem* item);
+private:
+	std::unordered_map<SWS_ListItem*, int> m_slots; // slot of each listed item, see GetItemList()
 };
 
 
@@ -166,6 +186,13 @@ protected:
 
 void AttachResourceFiles();
 
+class AutoFillJob : public ScheduledJob {
+public:
+	AutoFillJob() : ScheduledJob(SNM_SCHEDJOB_RES_AUTOFILL, SNM_SCHEDJOB_DEFAULT_DELAY) {}
+protected:
+	void Perform();
+};
+
 class AttachResourceFilesJob : public ScheduledJob {
 public:
 	AttachResourceFilesJob(int _approxMs) : ScheduledJob(SNM_SCHEDJOB_RES_ATTACH, _approxMs) {}
@@ -407,6 +407,7 @@ void RestoreTracksFolderStates(COMMAND_T* _ct)
 					(_ct->user && *(int*)GetSetMediaTrackInfo(tr, "I_FOLDERDEPTH", NULL) == 1 && savedTF->m_int != current)))
 				{
 					GetSetMediaTrackInfo(tr, strState, &(savedTF->m_int));
+					InvalidateFolderIndex();
 					updated = true;
 					break;
 				}
@@ -449,6 +450,7 @@ void SetTracksFolderState(COMMAND_T* _ct)
 
 			if (curState!=newState) {
 				GetSetMediaTrackInfo(tr, "I_FOLDERDEPTH", &newState);
+				InvalidateFolderIndex();
 				updated = true;
 			}
 		}
@@ -1003,23 +1005,24 @@ void SaveSingleTrackTemplateChunk(MediaTrack* _tr, WDL_FastString* _chunkOut, bo
 				if (MediaItem* item = GetTrackMediaItem(_tr, i))
 				{
 					SNM_ChunkParserPatcher pitem(item, false); // no auto-commit!
-					int posChunk = pitem.GetLinePos(1, "ITEM", "POSITION", 1, 0); // look for the *next* line
-					if (--posChunk>=0) { // --posChunk to zap "\n"
-						TimeMap2_timeToBeats(NULL, *(double*)GetSetMediaItemInfo(item, "D_POSITION", NULL), NULL, NULL, &d, NULL);
-						beatInfo.SetFormatted(32, " %.14f", d);
-						pitem.GetChunk()->Insert(beatInfo.Get(), posChunk);
-					}
-					posChunk = pitem.GetLinePos(1, "ITEM", "SNAPOFFS", 1, 0);
-					if (--posChunk>=0) {
-						TimeMap2_timeToBeats(NULL, *(double*)GetSetMediaItemInfo(item, "D_SNAPOFFSET", NULL), NULL, NULL, &d, NULL);
-						beatInfo.SetFormatted(32, " %.14f", d);
-						pitem.GetChunk()->Insert(beatInfo.Get(), posChunk);
-					}
-					posChunk = pitem.GetLinePos(1, "ITEM", "LENGTH", 1, 0);
-					if (--posChunk>=0) {
-						TimeMap2_timeToBeats(NULL, *(double*)GetSetMediaItemInfo(item, "D_LENGTH", NULL), NULL, NULL, &d, NULL);
-						beatInfo.SetFormatted(32, " %.14f", d);
-						pitem.GetChunk()->Insert(beatInfo.Get(), posChunk);
+					pitem.SetIndexed(true); // several lookups, parse the item once
+
+					// look for the *next* lines, all positions are got before altering the chunk
+					static const char* keywords[] = { "POSITION", "SNAPOFFS", "LENGTH" };
+					static const char* infos[] = { "D_POSITION", "D_SNAPOFFSET", "D_LENGTH" };
+					int posChunks[3];
+					for (int j=0; j<3; j++)
+						posChunks[j] = pitem.GetLinePos(1, "ITEM", keywords[j], 1, 0) - 1; // -1 to zap "\n"
+					for (int j=0; j<3; j++)
+					{
+						if (posChunks[j]>=0) {
+							TimeMap2_timeToBeats(NULL, *(double*)GetSetMediaItemInfo(item, infos[j], NULL), NULL, NULL, &d, NULL);
+							beatInfo.SetFormatted(32, " %.14f", d);
+							pitem.GetChunk()->Insert(beatInfo.Get(), posChunks[j]);
+							for (int k=j+1; k<3; k++)
+								if (posChunks[k] > posChunks[j])
+									posChunks[k] += beatInfo.GetLength();
+						}
 					}
 					_chunkOut->Insert(pitem.GetChunk(), _chunkOut->GetLength()-2); // -2: before ">\n"
 				}
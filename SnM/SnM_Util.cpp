@@ -451,19 +451,24 @@ bool GenerateFilename(const char* _dir, const char* _name, const char* _ext, cha
 	return false;
 }
 
-// fills a list of filenames matching extensions defined in _filterList
+// calls _onFile for each filename matching extensions defined in _filterList
 // _filterList: file extensions without null separators, ex: "*.ext1 *.ext2" ("*" == all files)
-// note: it is up to the caller to free _files (use WDL_PtrList_DeleteOnDestroy)
-void ScanFiles(WDL_PtrList<WDL_String>* _files, const char* _initDir, const char* _filterList, bool _subdirs)
+// _onFile: return false to stop scanning
+// _abort: optional, polled for each directory entry, return true to stop scanning
+// returns false if the scan was stopped by _onFile or _abort
+bool ScanFiles(bool (*_onFile)(const char* _fn, void* _ctx), void* _ctx, const char* _initDir, const char* _filterList, bool _subdirs, bool (*_abort)(void* _ctx))
 {
 	WDL_DirScan ds;
-	if (_files && _initDir && !ds.First(_initDir))
+	if (_onFile && _initDir && !ds.First(_initDir))
 	{
 		const char* curFn;
 		const char* curfnExt;
 		WDL_FastString fn, ext;
 		do 
 		{
+			if (_abort && _abort(_ctx))
+				return false;
+
 			curFn = ds.GetCurrentFN();
 			if (!strcmp(curFn, ".") || !strcmp(curFn, "..")) 
 				continue;
@@ -472,7 +477,8 @@ void ScanFiles(WDL_PtrList<WDL_String>* _files, const char* _initDir, const char
 			{
 				if (_subdirs) {
 					ds.GetCurrentFullFN(&fn);
-					ScanFiles(_files, fn.Get(), _filterList, true);
+					if (!ScanFiles(_onFile, _ctx, fn.Get(), _filterList, true, _abort))
+						return false;
 				}
 			}
 			else
@@ -480,7 +486,8 @@ void ScanFiles(WDL_PtrList<WDL_String>* _files, const char* _initDir, const char
 				if (!strcmp("*", _filterList)) // || !strcmp("*.*", _filterList))
 				{
 					ds.GetCurrentFullFN(&fn);
-					_files->Add(new WDL_String(fn.Get()));
+					if (!_onFile(fn.Get(), _ctx))
+						return false;
 				}
 				else
 				{
@@ -490,7 +497,8 @@ void ScanFiles(WDL_PtrList<WDL_String>* _files, const char* _initDir, const char
 						ext.SetFormatted(64, "*.%s", curfnExt);
 						if (stristr(_filterList, ext.Get())) {
 							ds.GetCurrentFullFN(&fn);
-							_files->Add(new WDL_String(fn.Get()));
+							if (!_onFile(fn.Get(), _ctx))
+								return false;
 						}
 					}
 				}
@@ -498,6 +506,21 @@ void ScanFiles(WDL_PtrList<WDL_String>* _files, const char* _initDir, const char
 		}
 		while(!ds.Next());
 	}
+	return true;
+}
+
+static bool AddScannedFile(const char* _fn, void* _files)
+{
+	((WDL_PtrList<WDL_String>*)_files)->Add(new WDL_String(_fn));
+	return true;
+}
+
+// fills a list of filenames matching extensions defined in _filterList
+// note: it is up to the caller to free _files (use WDL_PtrList_DeleteOnDestroy)
+void ScanFiles(WDL_PtrList<WDL_String>* _files, const char* _initDir, const char* _filterList, bool _subdirs)
+{
+	if (_files)
+		ScanFiles(AddScannedFile, _files, _initDir, _filterList, _subdirs);
 }
 
 void StringToExtensionConfig(WDL_FastString* _str, ProjectStateContext* _ctx)
@@ -199,7 +199,11 @@ TrackSnapshot::TrackSnapshot(MediaTrack* tr, int mask)
 
 	// and the full FX chain
 	if (mask & FXCHAIN_MASK)
-		GetFXChain(tr, &m_sFXChain);
+	{
+		WDL_TypedBuf<char> fxChain;
+		GetFXChain(tr, &fxChain);
+		m_sFXChain.Set(fxChain.Get(), fxChain.GetSize());
+	}
 	
 	// Get the "std" envelopes
 	// JFB note: localized env names are retrieved in GetSetEnvelope()
@@ -220,7 +224,7 @@ TrackSnapshot::TrackSnapshot(MediaTrack* tr, int mask)
 }
 
 // "Copy" constructor with mask large items don't get copied too
-TrackSnapshot::TrackSnapshot(TrackSnapshot& ts):m_sends(ts.m_sends)
+TrackSnapshot::TrackSnapshot(TrackSnapshot& ts):m_sFXChain(ts.m_sFXChain),m_sends(ts.m_sends) // FX chain is shared
 {
 	m_guid            = ts.m_guid;
 	m_dVol            = ts.m_dVol;
@@ -232,11 +236,6 @@ TrackSnapshot::TrackSnapshot(TrackSnapshot& ts):m_sends(ts.m_sends)
 	m_iSel            = ts.m_iSel;
 	for (int i = 0; i < ts.m_fx.GetSize(); i++)
 		m_fx.Add(new FXSnapshot(*ts.m_fx.Get(i)));
-	if (ts.m_sFXChain.GetSize())
-	{
-		m_sFXChain.Resize(ts.m_sFXChain.GetSize());
-		memcpy(m_sFXChain.Get(), ts.m_sFXChain.Get(), m_sFXChain.GetSize());
-	}
 	m_sName.Set(ts.m_sName.Get());
 	m_iTrackNum       = ts.m_iTrackNum;
 	m_iPanMode        = ts.m_iPanMode;
@@ -298,6 +297,11 @@ bool TrackSnapshot::UpdateReaper(int mask, bool bSelOnly, int* fxErr, bool wantC
 	if (bSelOnly && !iSel)
 		return false; // Ignore if the track isn't selected
 
+	// Only apply what differs from the current state
+	mask &= GetDiff(tr, mask, wantChunk);
+	if (!mask)
+		return false;
+
 	PreventUIRefresh(1);
 
 	if (mask & VOL_MASK)
@@ -376,6 +380,78 @@ bool TrackSnapshot::UpdateReaper(int mask, bool bSelOnly, int* fxErr, bool wantC
 	return false;
 }
 
+// Returns the items of mask that differ from the current track state, either
+// the "chunk" ones (FX chain and sends) or all the others
+int TrackSnapshot::GetDiff(MediaTrack* tr, int mask, bool bChunks)
+{
+	int diff = 0;
+	if (bChunks)
+	{
+		if (mask & FXCHAIN_MASK)
+		{
+			WDL_TypedBuf<char> fxChain;
+			GetFXChain(tr, &fxChain);
+			if (fxChain.GetSize() != m_sFXChain.GetSize() || (fxChain.GetSize() && memcmp(fxChain.Get(), m_sFXChain.Get(), fxChain.GetSize())))
+				diff |= FXCHAIN_MASK;
+		}
+		if (mask & SENDS_MASK)
+		{
+			TrackSends sends;
+			sends.Build(tr);
+			WDL_FastString curSends, snapSends;
+			sends.GetChunk(&curSends);
+			m_sends.GetChunk(&snapSends);
+			if (strcmp(curSends.Get(), snapSends.Get()))
+				diff |= SENDS_MASK;
+		}
+		return diff;
+	}
+
+	// Cheap fields first, envelopes only if those match
+	if (mask & VOL_MASK)
+	{
+		if (*(double*)GetSetMediaTrackInfo(tr, "D_VOL", NULL) != m_dVol ||
+			EnvelopeDiffers(tr, &m_sVolEnv, "Volume (Pre-FX)") ||
+			EnvelopeDiffers(tr, &m_sVolEnv2, "Volume"))
+			diff |= VOL_MASK;
+	}
+	if (mask & PAN_MASK)
+	{
+		if (*(double*)GetSetMediaTrackInfo(tr, "D_PAN", NULL) != m_dPan ||
+			*(int*)GetSetMediaTrackInfo(tr, "I_PANMODE", NULL) != m_iPanMode ||
+			*(double*)GetSetMediaTrackInfo(tr, "D_WIDTH", NULL) != m_dPanWidth ||
+			*(double*)GetSetMediaTrackInfo(tr, "D_DUALPANL", NULL) != m_dPanL ||
+			*(double*)GetSetMediaTrackInfo(tr, "D_DUALPANR", NULL) != m_dPanR ||
+			(m_dPanLaw != -100.0 && *(double*)GetSetMediaTrackInfo(tr, "D_PANLAW", NULL) != m_dPanLaw) ||
+			EnvelopeDiffers(tr, &m_sPanEnv, "Pan (Pre-FX)") ||
+			EnvelopeDiffers(tr, &m_sPanEnv2, "Pan") ||
+			EnvelopeDiffers(tr, &m_sWidthEnv, "Width (Pre-FX)") ||
+			EnvelopeDiffers(tr, &m_sWidthEnv2, "Width"))
+			diff |= PAN_MASK;
+	}
+	if (mask & MUTE_MASK)
+	{
+		if (*(bool*)GetSetMediaTrackInfo(tr, "B_MUTE", NULL) != m_bMute || EnvelopeDiffers(tr, &m_sMuteEnv, "Mute"))
+			diff |= MUTE_MASK;
+	}
+	if ((mask & SOLO_MASK) && *(int*)GetSetMediaTrackInfo(tr, "I_SOLO", NULL) != m_iSolo)
+		diff |= SOLO_MASK;
+	if ((mask & VIS_MASK) && GetTrackVis(tr) != m_iVis)
+		diff |= VIS_MASK;
+	if ((mask & SEL_MASK) && *(int*)GetSetMediaTrackInfo(tr, "I_SELECTED", NULL) != m_iSel)
+		diff |= SEL_MASK;
+	if (mask & FXATM_MASK) // DEPRECATED, always recalled
+		diff |= FXATM_MASK;
+	if ((mask & FXCHAIN_MASK) && *(int*)GetSetMediaTrackInfo(tr, "I_FXEN", NULL) != m_iFXEn)
+		diff |= FXCHAIN_MASK;
+	if ((mask & PHASE_MASK) && *(bool*)GetSetMediaTrackInfo(tr, "B_PHASE", NULL) != m_bPhase)
+		diff |= PHASE_MASK;
+	if ((mask & PLAY_OFFSET_MASK) &&
+		(static_cast<int>(GetMediaTrackInfo_Value(tr, "I_PLAY_OFFSET_FLAG")) != m_iPlayOffsetFlag || GetMediaTrackInfo_Value(tr, "D_PLAY_OFFSET") != m_dPlayOffset))
+		diff |= PLAY_OFFSET_MASK;
+	return diff;
+}
+
 bool TrackSnapshot::Cleanup()
 {
 	MediaTrack* tr = GuidToTrack(&m_guid);
@@ -393,7 +469,7 @@ bool TrackSnapshot::Cleanup()
 }
 
 // Only append, don't overwrite the chunk string
-void TrackSnapshot::GetChunk(WDL_FastString* chunk)
+void TrackSnapshot::GetChunk(WDL_FastString* chunk, SnapshotPayloads* payloads)
 {
 	char guidStr[64];
 	guidToString(&m_guid, guidStr);
@@ -404,25 +480,46 @@ void TrackSnapshot::GetChunk(WDL_FastString* chunk)
 	m_sends.GetChunk(chunk);
 	for (int i = 0; i < m_fx.GetSize(); i++)
 		m_fx.Get(i)->GetChunk(chunk);
-	if (m_sFXChain.GetSize())
-		chunk->Append(m_sFXChain.Get());
-	if (m_sVolEnv.GetLength())
-		chunk->Append(m_sVolEnv.Get());
-	if (m_sVolEnv2.GetLength())
-		chunk->Append(m_sVolEnv2.Get());
-	if (m_sPanEnv.GetLength())
-		chunk->Append(m_sPanEnv.Get());
-	if (m_sPanEnv2.GetLength())
-		chunk->Append(m_sPanEnv2.Get());
-	if (m_sWidthEnv.GetLength())
-		chunk->Append(m_sWidthEnv.Get());
-	if (m_sWidthEnv2.GetLength())
-		chunk->Append(m_sWidthEnv2.Get());
-	if (m_sMuteEnv.GetLength())
-		chunk->Append(m_sMuteEnv.Get());
+	SnapshotEnvelope* envs[] = { &m_sVolEnv, &m_sVolEnv2, &m_sPanEnv, &m_sPanEnv2, &m_sWidthEnv, &m_sWidthEnv2, &m_sMuteEnv };
+	if (payloads)
+	{
+		payloads->AppendFXChain(chunk, &m_sFXChain);
+		for (int i = 0; i < (int)(sizeof(envs) / sizeof(SnapshotEnvelope*)); i++)
+			payloads->AppendEnvelope(chunk, envs[i]);
+	}
+	else
+	{
+		if (m_sFXChain.GetSize())
+			chunk->Append(m_sFXChain.Get());
+		for (int i = 0; i < (int)(sizeof(envs) / sizeof(SnapshotEnvelope*)); i++)
+			envs[i]->GetChunk(chunk);
+	}
 	chunk->Append(">\n");
 }
 
+// Sets the FX chain or envelope from a shared payload (see SnapshotPayloads)
+bool TrackSnapshot::SetPayload(const char* payload)
+{
+	if (!strncmp(payload, "<FXCHAIN", 8))
+	{
+		m_sFXChain.Set(payload, (int)strlen(payload) + 1);
+		return true;
+	}
+
+	const char* envNames[] = { "<VOLENV", "<VOLENV2", "<PANENV", "<PANENV2", "<WIDTHENV", "<WIDTHENV2", "<MUTEENV" };
+	SnapshotEnvelope* envs[] = { &m_sVolEnv, &m_sVolEnv2, &m_sPanEnv, &m_sPanEnv2, &m_sWidthEnv, &m_sWidthEnv2, &m_sMuteEnv };
+	for (int i = 0; i < (int)(sizeof(envs) / sizeof(SnapshotEnvelope*)); i++)
+	{
+		int iLen = (int)strlen(envNames[i]);
+		if (!strncmp(payload, envNames[i], iLen) && (payload[iLen] == '\n' || payload[iLen] == '\r'))
+		{
+			envs[i]->Set(payload);
+			return true;
+		}
+	}
+	return false;
+}
+
 void TrackSnapshot::GetDetails(WDL_FastString* details, int iMask)
 {
 	MediaTrack* tr = GuidToTrack(&m_guid);
@@ -448,11 +545,11 @@ void TrackSnapshot::GetDetails(WDL_FastString* details, int iMask)
 	{
 		details->AppendFormatted(50, __LOCALIZE_VERFMT("Volume: %.2fdb","sws_DLG_101"), VAL2DB(m_dVol));
 		details->Append("\r\n");
-		if (m_sVolEnv.GetLength()) {
+		if (!m_sVolEnv.IsEmpty()) {
 			details->Append(__LOCALIZE("Volume (Pre-FX) envelope","sws_DLG_101"));
 			details->Append("\r\n");
 		}
-		if (m_sVolEnv2.GetLength()) {
+		if (!m_sVolEnv2.IsEmpty()) {
 			details->Append(__LOCALIZE("Volume envelope","sws_DLG_101"));
 			details->Append("\r\n");
 		}
@@ -493,19 +590,19 @@ void TrackSnapshot::GetDetails(WDL_FastString* details, int iMask)
 		else
 			details->Append("\r\n");
 
-		if (m_sPanEnv.GetLength()) {
+		if (!m_sPanEnv.IsEmpty()) {
 			details->Append(__LOCALIZE("Pan (Pre-FX) envelope","sws_DLG_101"));
 			details->Append("\r\n");
 		}
-		if (m_sPanEnv2.GetLength()) {
+		if (!m_sPanEnv2.IsEmpty()) {
 			details->Append(__LOCALIZE("Pan envelope","sws_DLG_101"));
 			details->Append("\r\n");
 		}
-		if (m_sWidthEnv.GetLength()) {
+		if (!m_sWidthEnv.IsEmpty()) {
 			details->Append(__LOCALIZE("Width (Pre-FX) envelope","sws_DLG_101"));
 			details->Append("\r\n");
 		}
-		if (m_sWidthEnv2.GetLength()) {
+		if (!m_sWidthEnv2.IsEmpty()) {
 			details->Append(__LOCALIZE("Width envelope","sws_DLG_101"));
 			details->Append("\r\n");
 		}
@@ -517,7 +614,7 @@ void TrackSnapshot::GetDetails(WDL_FastString* details, int iMask)
 		details->Append(m_bMute ? __LOCALIZE("on","sws_DLG_101") : __LOCALIZE("off","sws_DLG_101"));
 		details->Append("\r\n");
 
-		if (m_sMuteEnv.GetLength()) {
+		if (!m_sMuteEnv.IsEmpty()) {
 			details->Append(__LOCALIZE("Mute envelope","sws_DLG_101"));
 			details->Append("\r\n");
 		}
@@ -661,24 +758,34 @@ void TrackSnapshot::GetDetails(WDL_FastString* details, int iMask)
 	}
 }
 
-void TrackSnapshot::GetSetEnvelope(MediaTrack* tr, WDL_FastString* str, const char* env, bool bSet)
+void TrackSnapshot::GetSetEnvelope(MediaTrack* tr, SnapshotEnvelope* snapEnv, const char* env, bool bSet)
 {
 	TrackEnvelope* te = SWS_GetTrackEnvelopeByName(tr, env);
 	if (!bSet)
-	{	// Get envelope from REAPER
+	{	// Get envelope from REAPER, no size limit
+		snapEnv->Set(NULL);
 		if (te)
 		{
-			char envStr[262144] = "";
-			GetSetEnvelopeState(te, envStr, 262144);
-			str->Set(envStr);
+			try
+			{
+				snapEnv->Set(envelope::GetEnvelopeStateChunkBig(te).c_str());
+			}
+			catch (const envelope::bad_get_env_chunk_big& ex)
+			{
+				std::ostringstream ss;
+				ss << __LOCALIZE("Error storing envelope!", "sws_mbox") << " (" << env << ")\n" << ex.what(); // localized in envelope.cpp
+				MessageBox(g_hwndParent, ss.str().c_str(), __LOCALIZE("SWS Snapshots - Error", "sws_mbox"), MB_OK);
+			}
 		}
-		else
-			str->Set("");
 	}
-	else if (str->GetLength())
+	else if (!snapEnv->IsEmpty())
 	{	// Set envelope
 		if (te)
-			GetSetEnvelopeState(te, (char*)str->Get(), 0);
+		{
+			WDL_FastString envStr;
+			snapEnv->GetChunk(&envStr);
+			SetEnvelopeStateChunk(te, envStr.Get(), false);
+		}
 		else
 		{
 			WDL_FastString state;
@@ -691,26 +798,489 @@ void TrackSnapshot::GetSetEnvelope(MediaTrack* tr, WDL_FastString* str, const ch
 	}
 }
 
-bool TrackSnapshot::ProcessEnv(const char* chunk, char* line, int iLineMax, int* pos, const char* env, WDL_FastString* str)
+// Returns true if recalling snapEnv would change the track envelope
+bool TrackSnapshot::EnvelopeDiffers(MediaTrack* tr, SnapshotEnvelope* snapEnv, const char* env)
+{
+	if (snapEnv->IsEmpty())
+		return false; // Not recalled
+	TrackEnvelope* te = SWS_GetTrackEnvelopeByName(tr, env);
+	if (!te)
+		return true;
+
+	SnapshotEnvelope curEnv;
+	try
+	{
+		curEnv.Set(envelope::GetEnvelopeStateChunkBig(te).c_str());
+	}
+	catch (const envelope::bad_get_env_chunk_big&)
+	{
+		return true;
+	}
+	return !curEnv.IsEqual(snapEnv);
+}
+
+bool TrackSnapshot::ProcessEnv(const char* chunk, char* line, int iLineMax, int* pos, const char* env, SnapshotEnvelope* snapEnv)
 {
 	if (strcmp(env, line) == 0)
 	{
-		str->Set(line);
-		str->Append("\n");
+		WDL_FastString str;
+		str.Set(line);
+		str.Append("\n");
 		int iDepth = 1;
 		while (iDepth && GetChunkLine(chunk, line, iLineMax, pos, true))
 		{
-			str->Append(line);
+			str.Append(line);
 			if (line[0] == '<')
 				iDepth++;
 			else if (line[0] == '>')
 				iDepth--;
 		}
+		snapEnv->Set(str.Get());
 		return true;
 	}
 	return false;
 }
 
+// Packed envelope points: a flags byte, the position (double), the value (double or float)
+// then the optional fields depending on the flags. Doubles are followed by the %.*g
+// precision (byte) that prints them back exactly as they were in the chunk.
+#define SNAPENV_SHAPE	0x01 // Shape (int)
+#define SNAPENV_FLOAT	0x02 // Value is stored as a float (exact)
+#define SNAPENV_EXTRA	0x04 // Number of "PT" tokens (byte), then sig, selected, partial (int) and bezier tension (double) as per that number
+#define SNAPENV_MAXPOINTSIZE (1 + 9 + 9 + 4 + 1 + 3*4 + 9)
+#define SNAPENV_MAXTOKENS 7
+
+void SnapshotEnvelope::Set(const char* chunk)
+{
+	if (!chunk || !chunk[0])
+	{
+		m_data.Set(NULL, 0);
+		return;
+	}
+
+	// Worst case size
+	int iLines = 1;
+	for (const char* p = strchr(chunk, '\n'); p; p = strchr(p + 1, '\n'))
+		iLines++;
+	WDL_TypedBuf<unsigned char> points;
+	points.Resize(iLines * SNAPENV_MAXPOINTSIZE, false);
+	int iSize = 0, iNumPoints = 0;
+	WDL_FastString head, tail;
+
+	const char* line = chunk;
+	while (*line)
+	{
+		const char* eol = strchr(line, '\n');
+		int iLen = eol ? (int)(eol - line) + 1 : (int)strlen(line);
+		if (!strncmp(line, "PT ", 3))
+		{
+			// Points must be contiguous and packable, keep the text otherwise
+			int iPointSize = tail.GetLength() ? 0 : PackPoint(line, points.Get() + iSize);
+			if (!iPointSize)
+			{
+				head.Set(chunk);
+				tail.Set("");
+				iSize = iNumPoints = 0;
+				break;
+			}
+			iSize += iPointSize;
+			iNumPoints++;
+		}
+		else if (iNumPoints)
+			tail.Append(line, iLen);
+		else
+			head.Append(line, iLen);
+		line += iLen;
+	}
+
+	const int iHeadSize = head.GetLength() + 1, iTailSize = tail.GetLength() + 1;
+	WDL_TypedBuf<char> data;
+	char* d = data.Resize(iHeadSize + iTailSize + (int)sizeof(int) + iSize, false);
+	memcpy(d, head.Get(), iHeadSize); d += iHeadSize;
+	memcpy(d, tail.Get(), iTailSize); d += iTailSize;
+	memcpy(d, &iNumPoints, sizeof(int)); d += sizeof(int);
+	memcpy(d, points.Get(), iSize);
+	m_data.Set(data.Get(), data.GetSize());
+}
+
+void SnapshotEnvelope::GetChunk(WDL_FastString* chunk)
+{
+	if (IsEmpty())
+		return;
+
+	const char* head = m_data.Get();
+	const char* tail = head + strlen(head) + 1;
+	const char* points = tail + strlen(tail) + 1;
+	int iNumPoints;
+	memcpy(&iNumPoints, points, sizeof(int));
+
+	chunk->Append(head);
+	const unsigned char* p = (const unsigned char*)points + sizeof(int);
+	for (int i = 0; i < iNumPoints; i++)
+		p = UnpackPoint(p, chunk);
+	chunk->Append(tail);
+}
+
+int SnapshotEnvelope::GetNumPoints()
+{
+	if (IsEmpty())
+		return 0;
+
+	const char* tail = m_data.Get() + strlen(m_data.Get()) + 1;
+	int iNumPoints;
+	memcpy(&iNumPoints, tail + strlen(tail) + 1, sizeof(int));
+	return iNumPoints;
+}
+
+// Returns the %.*g precision that prints d back as the token, 0 if there's none
+// (e.g. "1.000", exponents): such points are kept as text so chunks are unchanged
+static int GetTokenPrecision(const char* token, int iLen, double d)
+{
+	int iDigits = 0;
+	bool bLeading = true;
+	for (int i = token[0] == '-' ? 1 : 0; i < iLen; i++)
+	{
+		if (token[i] >= '0' && token[i] <= '9')
+		{
+			if (token[i] != '0')
+				bLeading = false;
+			if (!bLeading)
+				iDigits++;
+		}
+		else if (token[i] != '.')
+			return 0;
+	}
+	if (!iDigits)
+		iDigits = 1;
+	if (iDigits > 17)
+		return 0;
+
+	char buf[64];
+	return snprintf(buf, sizeof(buf), "%.*g", iDigits, d) == iLen && !memcmp(buf, token, iLen) ? iDigits : 0;
+}
+
+static unsigned char* PackDouble(unsigned char* o, double d, int iPrecision)
+{
+	memcpy(o, &d, sizeof(double)); o += sizeof(double);
+	*o++ = (unsigned char)iPrecision;
+	return o;
+}
+
+static const unsigned char* UnpackDouble(const unsigned char* p, WDL_FastString* chunk)
+{
+	double d;
+	memcpy(&d, p, sizeof(double)); p += sizeof(double);
+	chunk->AppendFormatted(32, " %.*g", (int)*p++, d);
+	return p;
+}
+
+// Returns the packed size, 0 if the line can't be packed exactly (e.g. tempo map points)
+int SnapshotEnvelope::PackPoint(const char* line, unsigned char* out)
+{
+	double dTokens[SNAPENV_MAXTOKENS];
+	int iPrecisions[SNAPENV_MAXTOKENS];
+	int iTokens = 0;
+	const char* p = line + 3; // Skip "PT "
+	for (;;)
+	{
+		if (iTokens == SNAPENV_MAXTOKENS)
+			return 0;
+		char* end;
+		dTokens[iTokens] = strtod(p, &end);
+		const int iLen = (int)(end - p);
+		if (!iLen || (*end != ' ' && *end != '\n'))
+			return 0;
+		// Shape, sig, selected, partial are ints
+		if (iTokens >= 2 && iTokens <= 5)
+		{
+			char buf[16];
+			if (dTokens[iTokens] != (double)(int)dTokens[iTokens] ||
+				snprintf(buf, sizeof(buf), "%d", (int)dTokens[iTokens]) != iLen || memcmp(buf, p, iLen))
+				return 0;
+		}
+		else if (!(iPrecisions[iTokens] = GetTokenPrecision(p, iLen, dTokens[iTokens])))
+			return 0;
+		iTokens++;
+		if (*end == '\n')
+			break;
+		p = end + 1;
+	}
+	if (iTokens < 2)
+		return 0;
+
+	float fVal = (float)dTokens[1];
+	unsigned char* o = out;
+	*o = (iTokens >= 3 ? SNAPENV_SHAPE : 0) | ((double)fVal == dTokens[1] ? SNAPENV_FLOAT : 0) | (iTokens > 3 ? SNAPENV_EXTRA : 0);
+	const unsigned char flags = *o++;
+	o = PackDouble(o, dTokens[0], iPrecisions[0]);
+	if (flags & SNAPENV_FLOAT) { memcpy(o, &fVal, sizeof(float)); o += sizeof(float); *o++ = (unsigned char)iPrecisions[1]; }
+	else o = PackDouble(o, dTokens[1], iPrecisions[1]);
+	if (flags & SNAPENV_SHAPE)
+	{
+		int i = (int)dTokens[2];
+		memcpy(o, &i, sizeof(int)); o += sizeof(int);
+	}
+	if (flags & SNAPENV_EXTRA)
+	{
+		*o++ = (unsigned char)iTokens;
+		for (int t = 3; t < iTokens && t < 6; t++)
+		{
+			int i = (int)dTokens[t];
+			memcpy(o, &i, sizeof(int)); o += sizeof(int);
+		}
+		if (iTokens > 6) o = PackDouble(o, dTokens[6], iPrecisions[6]);
+	}
+	return (int)(o - out);
+}
+
+// Prints the point back exactly as it was in the chunk, see PackPoint()
+const unsigned char* SnapshotEnvelope::UnpackPoint(const unsigned char* p, WDL_FastString* chunk)
+{
+	const unsigned char flags = *p++;
+	chunk->Append("PT");
+	p = UnpackDouble(p, chunk);
+	if (flags & SNAPENV_FLOAT)
+	{
+		float f;
+		memcpy(&f, p, sizeof(float)); p += sizeof(float);
+		chunk->AppendFormatted(32, " %.*g", (int)*p++, (double)f);
+	}
+	else
+		p = UnpackDouble(p, chunk);
+
+	if (flags & SNAPENV_SHAPE)
+	{
+		int i;
+		memcpy(&i, p, sizeof(int)); p += sizeof(int);
+		chunk->AppendFormatted(16, " %d", i);
+	}
+	if (flags & SNAPENV_EXTRA)
+	{
+		const int iTokens = *p++;
+		for (int t = 3; t < iTokens && t < 6; t++)
+		{
+			int i;
+			memcpy(&i, p, sizeof(int)); p += sizeof(int);
+			chunk->AppendFormatted(16, " %d", i);
+		}
+		if (iTokens > 6)
+			p = UnpackDouble(p, chunk);
+	}
+	chunk->Append("\n");
+	return p;
+}
+
+// Payloads are hashed with FNV-1a
+static unsigned long long HashBlob(const char* data, int iSize)
+{
+	unsigned long long hash = 14695981039346656037ULL;
+	for (int i = 0; i < iSize; i++)
+	{
+		hash ^= (unsigned char)data[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+// Never freed: snapshots can be released after static destructors at exit
+static std::unordered_multimap<unsigned long long, SnapshotBlob*>& GetBlobStore()
+{
+	static std::unordered_multimap<unsigned long long, SnapshotBlob*>* blobs = new std::unordered_multimap<unsigned long long, SnapshotBlob*>;
+	return *blobs;
+}
+
+SnapshotBlob::SnapshotBlob(const char* data, int iSize, unsigned long long hash):m_hash(hash),m_iRefCount(0)
+{
+	memcpy(m_data.Resize(iSize, false), data, iSize);
+}
+
+SnapshotBlobRef::SnapshotBlobRef(const SnapshotBlobRef& ref):m_blob(ref.m_blob)
+{
+	if (m_blob)
+		m_blob->m_iRefCount++;
+}
+
+void SnapshotBlobRef::Set(const char* data, int iSize)
+{
+	std::unordered_multimap<unsigned long long, SnapshotBlob*>& blobs = GetBlobStore();
+	typedef std::unordered_multimap<unsigned long long, SnapshotBlob*>::iterator BlobIt;
+
+	// Reference the new blob first, it can be the current one
+	SnapshotBlob* blob = NULL;
+	if (data && iSize > 0)
+	{
+		const unsigned long long hash = HashBlob(data, iSize);
+		std::pair<BlobIt, BlobIt> range = blobs.equal_range(hash);
+		for (BlobIt it = range.first; it != range.second; ++it)
+			if (it->second->GetSize() == iSize && !memcmp(it->second->Get(), data, iSize))
+			{
+				blob = it->second;
+				break;
+			}
+		if (!blob)
+		{
+			blob = new SnapshotBlob(data, iSize, hash);
+			blobs.insert(std::make_pair(hash, blob));
+		}
+		blob->m_iRefCount++;
+	}
+
+	if (m_blob && !--m_blob->m_iRefCount)
+	{
+		std::pair<BlobIt, BlobIt> range = blobs.equal_range(m_blob->m_hash);
+		for (BlobIt it = range.first; it != range.second; ++it)
+			if (it->second == m_blob)
+			{
+				blobs.erase(it);
+				break;
+			}
+		delete m_blob;
+	}
+	m_blob = blob;
+}
+
+static WDL_PtrList_DeleteOnDestroy<WDL_FastString> g_loadedPayloads;
+static int g_iLoadedPayloadRefs = 0; // "PAYLOAD <id>" lines not loaded yet, payloads are freed once they all are
+
+void SnapshotPayloads::Add(Snapshot* ss)
+{
+	for (int i = 0; i < ss->m_tracks.GetSize(); i++)
+	{
+		TrackSnapshot* ts = ss->m_tracks.Get(i);
+		Add(ts->m_sFXChain.GetBlob(), NULL);
+		SnapshotEnvelope* envs[] = { &ts->m_sVolEnv, &ts->m_sVolEnv2, &ts->m_sPanEnv, &ts->m_sPanEnv2, &ts->m_sWidthEnv, &ts->m_sWidthEnv2, &ts->m_sMuteEnv };
+		for (int j = 0; j < (int)(sizeof(envs) / sizeof(SnapshotEnvelope*)); j++)
+			Add(envs[j]->GetBlob(), envs[j]);
+	}
+}
+
+void SnapshotPayloads::Add(SnapshotBlob* blob, SnapshotEnvelope* env)
+{
+	if (!blob)
+		return;
+
+	std::unordered_map<SnapshotBlob*, Payload>::iterator it = m_payloads.find(blob);
+	if (it != m_payloads.end())
+		it->second.iCount++;
+	else
+	{
+		Payload payload = { env, 1, -1 };
+		m_payloads[blob] = payload;
+		m_blobs.Add(blob);
+	}
+}
+
+// Only appends payloads used more than once
+void SnapshotPayloads::GetChunk(WDL_FastString* chunk)
+{
+	int iId = 0;
+	for (int i = 0; i < m_blobs.GetSize(); i++)
+	{
+		Payload* payload = &m_payloads[m_blobs.Get(i)];
+		if (payload->iCount < 2)
+			continue;
+
+		if (!iId)
+			chunk->AppendFormatted(32, "<SWSSNAPPAYLOADS %d\n", SNAPPAYLOADS_VERSION);
+		payload->iId = iId++;
+		chunk->AppendFormatted(32, "PAYLOAD %d %d\n", payload->iId, payload->iCount);
+		if (payload->env)
+			payload->env->GetChunk(chunk);
+		else
+			chunk->Append(m_blobs.Get(i)->Get());
+	}
+	if (iId)
+		chunk->Append(">\n");
+}
+
+int SnapshotPayloads::GetId(SnapshotBlob* blob)
+{
+	std::unordered_map<SnapshotBlob*, Payload>::iterator it = m_payloads.find(blob);
+	return it != m_payloads.end() ? it->second.iId : -1;
+}
+
+void SnapshotPayloads::AppendFXChain(WDL_FastString* chunk, SnapshotBlobRef* fxChain)
+{
+	if (!fxChain->GetSize())
+		return;
+
+	int iId = GetId(fxChain->GetBlob());
+	if (iId >= 0)
+		chunk->AppendFormatted(32, "PAYLOAD %d\n", iId);
+	else
+		chunk->Append(fxChain->Get());
+}
+
+void SnapshotPayloads::AppendEnvelope(WDL_FastString* chunk, SnapshotEnvelope* env)
+{
+	if (env->IsEmpty())
+		return;
+
+	int iId = GetId(env->GetBlob());
+	if (iId >= 0)
+		chunk->AppendFormatted(32, "PAYLOAD %d\n", iId);
+	else
+		env->GetChunk(chunk);
+}
+
+void SnapshotPayloads::Load(const char* chunk)
+{
+	ClearLoaded();
+
+	char line[4096];
+	int pos = 0;
+	LineParser lp(false);
+	GetChunkLine(chunk, line, 4096, &pos, false); // <SWSSNAPPAYLOADS <version>
+	if (lp.parse(line) || lp.gettoken_int(1) != SNAPPAYLOADS_VERSION)
+		return;
+	while (GetChunkLine(chunk, line, 4096, &pos, false))
+	{
+		if (lp.parse(line) || strcmp("PAYLOAD", lp.gettoken_str(0)))
+			continue;
+
+		WDL_FastString* payload = new WDL_FastString;
+		int iDepth = 0;
+		while (GetChunkLine(chunk, line, 4096, &pos, true))
+		{
+			payload->Append(line);
+			if (line[0] == '<')
+				iDepth++;
+			else if (line[0] == '>')
+				iDepth--;
+			if (!iDepth)
+				break;
+		}
+
+		// Ids are written in order
+		if (lp.gettoken_int(1) == g_loadedPayloads.GetSize())
+		{
+			g_loadedPayloads.Add(payload);
+			g_iLoadedPayloadRefs += lp.gettoken_int(2);
+		}
+		else
+			delete payload;
+	}
+}
+
+const char* SnapshotPayloads::GetLoaded(int id)
+{
+	WDL_FastString* payload = g_loadedPayloads.Get(id);
+	return payload ? payload->Get() : NULL;
+}
+
+// Call once a payload returned by GetLoaded() has been used
+void SnapshotPayloads::ReleaseLoaded()
+{
+	if (--g_iLoadedPayloadRefs <= 0)
+		ClearLoaded();
+}
+
+void SnapshotPayloads::ClearLoaded()
+{
+	g_loadedPayloads.Empty(true);
+	g_iLoadedPayloadRefs = 0;
+}
+
 Snapshot::Snapshot(int slot, int mask, bool bSelOnly, const char* name, const char* notes)
 {
 	m_iSlot = slot;
@@ -839,18 +1409,19 @@ Snapshot::Snapshot(const char* chunk)
 			}
 			else if (strcmp("<FXCHAIN", lp.gettoken_str(0)) == 0) // Multiple lines
 			{
+				WDL_TypedBuf<char> fxChain;
 				int iLen = (int)strlen(line);
-				ts->m_sFXChain.Resize(iLen + 2);
-				strcpy(ts->m_sFXChain.Get(), line);
-				strcpy(ts->m_sFXChain.Get()+iLen, "\n");
+				fxChain.Resize(iLen + 2);
+				strcpy(fxChain.Get(), line);
+				strcpy(fxChain.Get()+iLen, "\n");
 				iLen++;
 
 				int iDepth = 1;
 				while(iDepth && GetChunkLine(chunk, line, 4096, &pos, true))
 				{
 					int iNewLen = iLen + (int)strlen(line);
-					ts->m_sFXChain.Resize(iNewLen + 1);
-					strcpy(ts->m_sFXChain.Get()+iLen, line);
+					fxChain.Resize(iNewLen + 1);
+					strcpy(fxChain.Get()+iLen, line);
 					iLen = iNewLen;
 
 					if (line[0] == '>')
@@ -858,6 +1429,16 @@ Snapshot::Snapshot(const char* chunk)
 					else if (line[0] == '<')
 						iDepth++;
 				}
+				ts->m_sFXChain.Set(fxChain.Get(), fxChain.GetSize());
+			}
+			else if (strcmp("PAYLOAD", lp.gettoken_str(0)) == 0) // Shared FX chain or envelope
+			{
+				const char* payload = SnapshotPayloads::GetLoaded(lp.gettoken_int(1));
+				if (payload)
+				{
+					ts->SetPayload(payload);
+					SnapshotPayloads::ReleaseLoaded();
+				}
 			}
 			// Yuck, not too happy with the below code, but it works.
 			else if (ts->ProcessEnv(chunk, line, 4096, &pos, "<VOLENV", &ts->m_sVolEnv)) {}
@@ -964,6 +1545,53 @@ bool Snapshot::UpdateReaper(int mask, bool bSelOnly, bool bHideNewVis)
 	return false;
 }
 
+// Returns the number of tracks that recalling the snapshot would change, without changing
+// anything. If details != NULL, the changes are listed per track.
+int Snapshot::GetDiff(int mask, bool bSelOnly, WDL_FastString* details)
+{
+	static const int masks[] = { VOL_MASK, PAN_MASK, MUTE_MASK, SOLO_MASK, FXATM_MASK, FXCHAIN_MASK, SENDS_MASK, VIS_MASK, SEL_MASK, PHASE_MASK, PLAY_OFFSET_MASK };
+	const char* names[] = {
+		__LOCALIZE("vol","sws_DLG_101"), __LOCALIZE("pan","sws_DLG_101"), __LOCALIZE("mute","sws_DLG_101"), __LOCALIZE("solo","sws_DLG_101"),
+		__LOCALIZE("fx (old style)","sws_DLG_101"), __LOCALIZE("fx","sws_DLG_101"), __LOCALIZE("sends","sws_DLG_101"), __LOCALIZE("visibility","sws_DLG_101"),
+		__LOCALIZE("selection","sws_DLG_101"), __LOCALIZE("phase","sws_DLG_101"), __LOCALIZE("playback offset","sws_DLG_101") };
+
+	int iChanged = 0;
+	mask &= m_iMask;
+	SWS_CacheObjectState(true); // Read only, nothing gets written back
+	for (int i = 0; i < m_tracks.GetSize(); i++)
+	{
+		TrackSnapshot* ts = m_tracks.Get(i);
+		MediaTrack* tr = GuidToTrack(&ts->m_guid);
+		if (!tr || (bSelOnly && !*(int*)GetSetMediaTrackInfo(tr, "I_SELECTED", NULL)))
+			continue;
+
+		int diff = ts->GetDiff(tr, mask, false) | ts->GetDiff(tr, mask, true);
+		if (!diff)
+			continue;
+
+		iChanged++;
+		if (details)
+		{
+			if (ts->m_iTrackNum == 0)
+				details->Append(__LOCALIZE("Master Track","sws_DLG_101"));
+			else
+				details->AppendFormatted(100, __LOCALIZE_VERFMT("Track #%d \"%s\"","sws_DLG_101"), CSurf_TrackToID(tr, false), (char*)GetSetMediaTrackInfo(tr, "P_NAME", NULL));
+			details->Append(": ");
+			int n = 0;
+			for (int j = 0; j < (int)(sizeof(masks) / sizeof(int)); j++)
+				if (diff & masks[j])
+				{
+					if (n++)
+						details->Append(", ");
+					details->Append(names[j]);
+				}
+			details->Append("\r\n");
+		}
+	}
+	SWS_CacheObjectState(false);
+	return iChanged;
+}
+
 char* Snapshot::Tooltip(char* str, int maxLen)
 {
 	int n = 0;
@@ -1145,13 +1773,13 @@ char* Snapshot::GetTimeString(char* str, int iStrMax, bool bDate)
 }
 
 // Get chunk for writing out
-void Snapshot::GetChunk(WDL_FastString* chunk)
+void Snapshot::GetChunk(WDL_FastString* chunk, SnapshotPayloads* payloads)
 {
 	WDL_FastString notes;
 	makeEscapedConfigString(m_cNotes, &notes);
 	chunk->SetFormatted(SNM_MAX_CHUNK_LINE_LENGTH, "<SWSSNAPSHOT \"%s\" %d %d %d %s\n", m_cName, m_iSlot, m_iMask, m_time, notes.Get());
 	for (int i = 0; i < m_tracks.GetSize(); i++)
-		m_tracks.Get(i)->GetChunk(chunk);
+		m_tracks.Get(i)->GetChunk(chunk, payloads);
 	chunk->Append(">\n");
 }
 
@@ -27,8 +27,13 @@
 
 #pragma once
 
+#include <unordered_map>
+
 #define DOUBLES_PER_LINE 8
 
+class Snapshot;
+class SnapshotPayloads;
+
 class FXSnapshot
 {
 public:
@@ -49,6 +54,61 @@ public:
     char m_cNotes[256];
 };
 
+// Snapshot payload (FX chain, envelope...), identical payloads are shared
+// and refcounted, see SnapshotBlobRef
+class SnapshotBlob
+{
+public:
+	const char* Get() { return m_data.Get(); }
+	int GetSize() { return m_data.GetSize(); }
+
+private:
+	friend class SnapshotBlobRef;
+	SnapshotBlob(const char* data, int iSize, unsigned long long hash);
+
+	WDL_TypedBuf<char> m_data;
+	unsigned long long m_hash;
+	int m_iRefCount;
+};
+
+class SnapshotBlobRef
+{
+public:
+	SnapshotBlobRef():m_blob(NULL) {}
+	SnapshotBlobRef(const SnapshotBlobRef& ref);
+	~SnapshotBlobRef() { Set(NULL, 0); }
+
+	void Set(const char* data, int iSize); // Shares an existing identical blob if any, NULL/0 to clear
+	const char* Get() { return m_blob ? m_blob->Get() : NULL; }
+	int GetSize() { return m_blob ? m_blob->GetSize() : 0; }
+	SnapshotBlob* GetBlob() { return m_blob; }
+
+private:
+	SnapshotBlobRef& operator=(const SnapshotBlobRef&);
+	SnapshotBlob* m_blob;
+};
+
+// Track envelope state: points are held in a compact binary form, other
+// lines of the envelope chunk as text
+class SnapshotEnvelope
+{
+public:
+	void Set(const char* chunk); // NULL or "" to clear
+	void GetChunk(WDL_FastString* chunk); // Appends the envelope chunk
+	bool IsEmpty() { return !m_data.GetSize(); }
+	bool IsEqual(SnapshotEnvelope* env) { return m_data.GetBlob() == env->m_data.GetBlob(); } // Identical data is always shared
+	int GetNumPoints();
+	SnapshotBlob* GetBlob() { return m_data.GetBlob(); }
+
+private:
+	static int PackPoint(const char* line, unsigned char* out);
+	static const unsigned char* UnpackPoint(const unsigned char* p, WDL_FastString* chunk);
+
+	// Lines before the first point (or the whole chunk if it can't be packed), lines
+	// after the last point (both NULL terminated), the number of points and the points
+	SnapshotBlobRef m_data;
+};
+
 class TrackSnapshot
 {
 public:
@@ -58,12 +118,15 @@ public:
     ~TrackSnapshot();
 
 	bool UpdateReaper(int mask, bool bSelOnly, int* fxErr, bool wantChunk, WDL_PtrList<TrackSendFix>* pFix);
+	int GetDiff(MediaTrack* tr, int mask, bool bChunks);
 	bool Cleanup();
-	void GetChunk(WDL_FastString* chunk);
+	void GetChunk(WDL_FastString* chunk, SnapshotPayloads* payloads = NULL);
 	void GetDetails(WDL_FastString* details, int iMask);
+	bool SetPayload(const char* payload);
 
-	static void GetSetEnvelope(MediaTrack* tr, WDL_FastString* str, const char* env, bool bSet);
-	static bool ProcessEnv(const char* chunk, char* line, int iLineMax, int* pos, const char* env, WDL_FastString* str);
+	static void GetSetEnvelope(MediaTrack* tr, SnapshotEnvelope* snapEnv, const char* env, bool bSet);
+	static bool EnvelopeDiffers(MediaTrack* tr, SnapshotEnvelope* snapEnv, const char* env);
+	static bool ProcessEnv(const char* chunk, char* line, int iLineMax, int* pos, const char* env, SnapshotEnvelope* snapEnv);
 
 // TODO these should be private
 	GUID m_guid;
@@ -79,7 +142,7 @@ public:
 	int m_iPlayOffsetFlag;
 	double m_dPlayOffset;
     WDL_PtrList<FXSnapshot> m_fx;
-	WDL_TypedBuf<char> m_sFXChain;
+	SnapshotBlobRef m_sFXChain;
 	TrackSends m_sends;
 	WDL_FastString m_sName;
 	int m_iTrackNum;
@@ -91,13 +154,13 @@ public:
 	double m_dPanR;
 	double m_dPanLaw;
 	
-	WDL_FastString m_sVolEnv;
-	WDL_FastString m_sVolEnv2;
-	WDL_FastString m_sPanEnv;
-	WDL_FastString m_sPanEnv2;
-	WDL_FastString m_sWidthEnv;
-	WDL_FastString m_sWidthEnv2;
-	WDL_FastString m_sMuteEnv;
+	SnapshotEnvelope m_sVolEnv;
+	SnapshotEnvelope m_sVolEnv2;
+	SnapshotEnvelope m_sPanEnv;
+	SnapshotEnvelope m_sPanEnv2;
+	SnapshotEnvelope m_sWidthEnv;
+	SnapshotEnvelope m_sWidthEnv2;
+	SnapshotEnvelope m_sMuteEnv;
 };
 
 // Mask:
@@ -128,6 +191,7 @@ public:
 	Snapshot(const char* chunk); // For project load
     ~Snapshot();
     bool UpdateReaper(int mask, bool bSelOnly, bool bHideNewVis);
+	int GetDiff(int mask, bool bSelOnly, WDL_FastString* details = NULL); // Dry run of UpdateReaper()
     char* Tooltip(char* str, int maxLen);
     void SetName(const char* name);
     void SetNotes(const char* notes);
@@ -136,7 +200,7 @@ public:
 	void SelectTracks();
 	int Find(MediaTrack* tr);
 	char* GetTimeString(char* str, int iStrMax, bool bDate);
-	void GetChunk(WDL_FastString* chunk);
+	void GetChunk(WDL_FastString* chunk, SnapshotPayloads* payloads = NULL);
 	void GetDetails(WDL_FastString* details);
 	bool IncludesSelTracks();
 
@@ -149,3 +213,37 @@ public:
     
     WDL_PtrList<TrackSnapshot> m_tracks;
 };
+
+// Payloads used by several snapshots of a project, written once (saved projects and
+// undo states) in a versioned <SWSSNAPPAYLOADS chunk and referenced by "PAYLOAD <id>"
+// lines in the snapshots. Note: versions that predate the chunk load such snapshots
+// without their shared FX chains/envelopes, unknown chunk versions are ignored here.
+#define SNAPPAYLOADS_VERSION 1
+
+class SnapshotPayloads
+{
+public:
+	void Add(Snapshot* ss); // Call for all the snapshots before GetChunk()
+	void GetChunk(WDL_FastString* chunk);
+	void AppendFXChain(WDL_FastString* chunk, SnapshotBlobRef* fxChain);
+	void AppendEnvelope(WDL_FastString* chunk, SnapshotEnvelope* env);
+
+	// Project/undo state load, payloads are available to Snapshot(const char* chunk) until all their references are loaded
+	static void Load(const char* chunk);
+	static const char* GetLoaded(int id);
+	static void ReleaseLoaded();
+	static void ClearLoaded();
+
+private:
+	struct Payload
+	{
+		SnapshotEnvelope* env; // NULL for FX chains
+		int iCount;
+		int iId;
+	};
+	void Add(SnapshotBlob* blob, SnapshotEnvelope* env);
+	int GetId(SnapshotBlob* blob);
+
+	WDL_PtrList<SnapshotBlob> m_blobs; // In order of appearance
+	std::unordered_map<SnapshotBlob*, Payload> m_payloads;
+};
@@ -49,6 +49,7 @@
 #define MERGE_MSG	0x1000A
 #define EXPORT_MSG	0x1000B
 #define IMPORT_MSG	0x1000C
+#define PREVIEW_MSG	0x1000D
 #define LOAD_MSG	0x100F0 // leave space!!
 
 enum
@@ -74,6 +75,7 @@ void PasteSnapshot(COMMAND_T*);
 void MergeSnapshot(Snapshot* ss);
 void DeleteSnapshot(Snapshot* ss);
 void DeleteAllSnapshots(COMMAND_T* = NULL);
+void PreviewSnapshot(HWND hwnd, Snapshot* ss);
 
 static int g_iMask = ALL_MASK;
 static int g_compatMask = ALL_MASK; // // for disabling features unavailable in the running version of REAPER
@@ -659,6 +661,9 @@ void SWS_SnapshotsWnd::OnCommand(WPARAM wParam, LPARAM lParam)
 			DisplayInfoBox(m_hwnd, __LOCALIZE("Snapshot Details","sws_DLG_101"), details.Get());
 			break;
 		}
+		case PREVIEW_MSG:
+			PreviewSnapshot(m_hwnd, (Snapshot*)m_pLists.Get(0)->EnumSelected(NULL));
+			break;
 		case EXPORT_MSG:
 		{
 			Snapshot* ss = (Snapshot*)m_pLists.Get(0)->EnumSelected(NULL);
@@ -711,6 +716,7 @@ HMENU SWS_SnapshotsWnd::OnContextMenu(int x, int y, bool* wantDefaultItems)
 		AddToMenu(contextMenu, __LOCALIZE("Rename","sws_DLG_101"), RENAME_MSG);
 		AddToMenu(contextMenu, SWS_SEPARATOR, 0);
 		AddToMenu(contextMenu, __LOCALIZE("Show snapshot details","sws_DLG_101"), DETAILS_MSG);
+		AddToMenu(contextMenu, __LOCALIZE("Preview recall (show changes)","sws_DLG_101"), PREVIEW_MSG);
 		AddToMenu(contextMenu, __LOCALIZE("Select tracks in snapshot","sws_DLG_101"), SEL_MSG);
 		AddToMenu(contextMenu, __LOCALIZE("Add selected track(s) to snapshot","sws_DLG_101"), ADDSEL_MSG);
 		AddToMenu(contextMenu, __LOCALIZE("Delete selected track(s) from snapshot","sws_DLG_101"), DELSEL_MSG);
@@ -1075,6 +1081,19 @@ int SnapshotsWindowEnabled(COMMAND_T*)
 	return g_pSSWnd->IsWndVisible();
 }
 
+// Lists what recalling the snapshot with the current recall options would change
+void PreviewSnapshot(HWND hwnd, Snapshot* ss)
+{
+	if (!ss)
+		return;
+	WDL_FastString details;
+	if (!ss->GetDiff(g_bApplyFilterOnRecall ? g_iMask : ALL_MASK, g_bSelOnly_OnRecall, &details))
+		details.Set(__LOCALIZE("Recalling this snapshot would not change anything.","sws_DLG_101"));
+	DisplayInfoBox(hwnd, __LOCALIZE("Snapshot Recall Preview","sws_DLG_101"), details.Get());
+}
+
+void PreviewCurSnapshot(COMMAND_T*) { PreviewSnapshot(g_hwndParent, g_ss.Get()->m_pCurSnapshot); }
+
 void CopyCurSnapshot(COMMAND_T*)
 {
 	if (g_ss.Get()->m_pCurSnapshot)
@@ -1182,6 +1201,7 @@ static COMMAND_T g_commandTable[] =
 	{ { DEFACCEL, "SWS: Recall current snapshot" },							"SWSSNAPSHOT_GET",	     GetCurSnapshot,       "Recall current snapshot", },
 	{ { DEFACCEL, "SWS: Recall previous snapshot" },						"SWSSNAPSHOT_GET_PREVIOUS",	 GetPreviousSnapshot,  "Recall previous snapshot", },
 	{ { DEFACCEL, "SWS: Recall next snapshot" },							"SWSSNAPSHOT_GET_NEXT",	     GetNextSnapshot,      "Recall next snapshot", },
+	{ { DEFACCEL, "SWS: Preview recall of current snapshot (show changes)" },	"SWSSNAPSHOT_PREVIEW",	 PreviewCurSnapshot,   "Preview recall of current snapshot", },
 	{ { DEFACCEL, "SWS: Copy current snapshot" },							"SWSSNAPSHOT_COPY",	     CopyCurSnapshot,      "Copy current snapshot", },
 	{ { DEFACCEL, "SWS: Copy new snapshot (selected track(s))" },			"SWSSNAPSHOT_COPYSEL",   CopySelSnapshot,      "Copy new snapshot (selected track(s))", },
 	{ { DEFACCEL, "SWS: Copy new snapshot (all track(s))" },				"SWSSNAPSHOT_COPYALL",   CopyAllSnapshot,      "Copy new snapshot (all track(s))", },
@@ -1218,6 +1238,11 @@ static COMMAND_T g_commandTable[] =
 static bool ProcessExtensionLine(const char *line, ProjectStateContext *ctx, bool isUndo, struct project_config_extension_t *reg)
 {
 	WDL_TypedBuf<char> buf;
+	if (GetChunkFromProjectState("<SWSSNAPPAYLOADS", &buf, line, ctx))
+	{
+		SnapshotPayloads::Load(buf.Get());
+		return true;
+	}
 	if (GetChunkFromProjectState("<SWSSNAPSHOT", &buf, line, ctx))
 	{
 		g_ss.Get()->m_snapshots.Add(new Snapshot(buf.Get()));
@@ -1231,11 +1256,21 @@ static void SaveExtensionConfig(ProjectStateContext *ctx, bool isUndo, struct pr
 {
 	WDL_FastString chunk;
 	char line[4096];
+
+	// Payloads (FX chains, envelopes) shared by several snapshots are written once, first
+	SnapshotPayloads payloads;
+	for (int i = 0; i < g_ss.Get()->m_snapshots.GetSize(); i++)
+		payloads.Add(g_ss.Get()->m_snapshots.Get(i));
+	payloads.GetChunk(&chunk);
+	int iPos = 0;
+	while(GetChunkLine(chunk.Get(), line, 4096, &iPos, false))
+		ctx->AddLine("%s",line);
+
 	for (int i = 0; i < g_ss.Get()->m_snapshots.GetSize(); i++)
 	{
 		Snapshot* ss = g_ss.Get()->m_snapshots.Get(i);
-		ss->GetChunk(&chunk);
-		int iPos = 0;
+		ss->GetChunk(&chunk, &payloads);
+		iPos = 0;
 		while(GetChunkLine(chunk.Get(), line, 4096, &iPos, false))
 			ctx->AddLine("%s",line);
 	}
@@ -1243,6 +1278,7 @@ static void SaveExtensionConfig(ProjectStateContext *ctx, bool isUndo, struct pr
 
 static void BeginLoadProjectState(bool isUndo, struct project_config_extension_t *reg)
 {
+	SnapshotPayloads::ClearLoaded();
 	DeleteAllSnapshots();
 	g_ss.Cleanup();
 	UpdateSnapshotsDialog();
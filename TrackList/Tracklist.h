@@ -39,6 +39,7 @@ protected:
 	void SetItemText(SWS_ListItem* item, int iCol, const char* str);
 	void GetItemText(SWS_ListItem* item, int iCol, char* str, int iStrMax);
 	void GetItemList(SWS_ListItemList* pList);
+	bool GetItemSortKey(SWS_ListItem* item, int iCol, SWS_SortKey* key) { return GetTextSortKey(item, iCol, key); }
 	int  GetItemState(SWS_ListItem* item);
 	void OnItemBtnClk(SWS_ListItem* item, int iCol, int iKeyState);
 	void OnItemDblClk(SWS_ListItem* item, int iCol);
@@ -28,14 +28,43 @@
 #include "stdafx.h"
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 #include "Base64.h"
 
 // This following Base64 code adapted from http://base64.sourceforge.net/b64.c
 // Copyright (c) 2001 Bob Trower, Trantor Standard Systems Inc.
 // Visit above link for full license info or to get original source.
 // Modified so that the '=' char returns zero for compat with other base64 systems.
+// Reworked with lookup tables: 12 bits -> 2 chars for encoding, char -> 6 bits for decoding.
 static const char cb64[]="ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-static const char cd64[]="|$$$}rstuvwxyz{$$$>$$$>?@ABCDEFGHIJKLMNOPQRSTUVW$$$$$$XYZ[\\]^_`abcdefghijklmnopq";
+
+#define B64_INVALID	-1
+#define B64_PAD		-2
+
+struct Base64Tables
+{
+	char enc[4096][2];
+	signed char dec[256];
+
+	Base64Tables()
+	{
+		for (int i = 0; i < 4096; i++)
+		{
+			enc[i][0] = cb64[i >> 6];
+			enc[i][1] = cb64[i & 0x3F];
+		}
+		memset(dec, B64_INVALID, sizeof(dec));
+		for (int i = 0; i < 64; i++)
+			dec[(unsigned char)cb64[i]] = (signed char)i;
+		dec['='] = B64_PAD;
+	}
+};
+
+static const Base64Tables& GetTables()
+{
+	static const Base64Tables s_tables;
+	return s_tables;
+}
 
 //////////////////////////////////////////////////////////////////////
 // Construction/Destruction
@@ -43,14 +72,10 @@ static const char cd64[]="|$$$}rstuvwxyz{$$$>$$$>?@ABCDEFGHIJKLMNOPQRSTUVW$$$$$$
 
 Base64::Base64()
 {
-	m_pEncodedBuf = NULL;
-	m_pDecodedBuf = NULL;
 }
 
 Base64::~Base64()
 {
-	delete [] m_pEncodedBuf;
-	delete [] m_pDecodedBuf;
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -58,124 +83,163 @@ Base64::~Base64()
 //////////////////////////////////////////////////////////////////////
 char* Base64::Encode(const char* pInput, int iInputLen, const bool pad)
 {
-	int iLen = iInputLen;
-	int iEncodedLen;
-	
-	//calculate encoded buffer size
-	if (pad)
-		iEncodedLen = static_cast<int>(4 * ceil(iLen / 3.f));
-	else
-		iEncodedLen = static_cast<int>(ceil(4 * iLen / 3.f));
-
-	// allocate:
-	if (m_pEncodedBuf != NULL)
-		free (m_pEncodedBuf);
-	m_pEncodedBuf = new char[iEncodedLen + 1];
-	char* pOutput = m_pEncodedBuf;
+	const int iEncodedLen = EncodedSize(iInputLen, pad);
+	char* pOutput = iEncodedLen >= 0 ? m_encodedBuf.ResizeOK(iEncodedLen + 1, false) : NULL;
+	if (!pOutput)
+		return NULL;
+
+	EncodeTo(pInput, iInputLen, pad, pOutput, iEncodedLen);
+
+	// Null terminate
+	pOutput[iEncodedLen] = 0;
+	return pOutput;
+}
+
+// Decode a base64 string to a binary buffer
+// Encoded string must be null terminated
+char* Base64::Decode(const char* pEncodedBuf, int *iOutLen)
+{
+	if (iOutLen)
+		*iOutLen = 0;
+
+	const int iEncodedLen = (int)strlen(pEncodedBuf);
+	const int iDecodedLen = DecodedSize(pEncodedBuf, iEncodedLen);
+	if (iDecodedLen < 0)
+		return NULL;
+
+	// +1: never NULL, empty strings decode fine
+	char* pOutput = m_decodedBuf.ResizeOK(iDecodedLen + 1, false);
+	if (!pOutput || DecodeTo(pEncodedBuf, iEncodedLen, pOutput, iDecodedLen) < 0)
+		return NULL;
+
+	// done:
+	if (iOutLen)
+		*iOutLen = iDecodedLen;
+	return pOutput;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Static Functions
+//////////////////////////////////////////////////////////////////////
+// Returns -1 if the encoded size doesn't fit in an int (inputs above ~1.5GB)
+int Base64::EncodedSize(int iLen, const bool pad)
+{
+	if (iLen <= 0)
+		return 0;
+	const long long iEncodedLen = pad ? 4 * ((iLen + 2LL) / 3) : (4LL * iLen + 2) / 3;
+	return iEncodedLen <= INT_MAX ? (int)iEncodedLen : -1;
+}
+
+// Trailing padding is excluded, as are trailing chars not making a byte
+// Returns -1 if there's too much padding
+int Base64::DecodedSize(const char* pInput, int iInputLen)
+{
+	int iPad = 0;
+	for (int i = iInputLen - 1; i >= 0 && pInput[i] == '='; --i, ++iPad);
+	const int iLen = (int)((3 * (long long)iInputLen) / 4) - iPad;
+	return iLen >= 0 ? iLen : -1;
+}
+
+int Base64::EncodeTo(const char* pInput, int iLen, const bool pad, char* pOutput, int iOutputSize)
+{
+	const int iEncodedLen = EncodedSize(iLen, pad);
+	if (iEncodedLen < 0 || iEncodedLen > iOutputSize)
+		return -1;
+
+	const Base64Tables& t = GetTables();
+	const unsigned char* in = (const unsigned char*)pInput;
+	char* out = pOutput;
 
 	//let's step through the buffer (in groups of three bytes) and encode it...
 	while (iLen >= 3)
 	{
-		*(pOutput++) = cb64[(unsigned char)pInput[0] >> 2];
-		*(pOutput++) = cb64[(((unsigned char)pInput[0] & 0x03) << 4) | (((unsigned char)pInput[1] & 0xF0) >> 4)];
-		*(pOutput++) = cb64[(((unsigned char)pInput[1] & 0x0F) << 2) | (((unsigned char)pInput[2] & 0xC0) >> 6)];
-		*(pOutput++) = cb64[(unsigned char)pInput[2] & 0x3F];
+		const unsigned int v = (in[0] << 16) | (in[1] << 8) | in[2];
+		memcpy(out, t.enc[v >> 12], 2);
+		memcpy(out + 2, t.enc[v & 0xFFF], 2);
+		out += 4;
+		in += 3;
 		iLen -= 3;
-		pInput += 3;
 	}
 
 	//do we have some chars left?
 	if (iLen != 0)
 	{
-		*(pOutput++) = cb64[(unsigned char)pInput[0] >> 2];
-
+		*(out++) = cb64[in[0] >> 2];
 		if (iLen == 1)
 		{
-			*(pOutput++) = cb64[((unsigned char)pInput[0] & 0x03) << 4];
+			*(out++) = cb64[(in[0] & 0x03) << 4];
 		}
 		else // iLen == 2
 		{
-			*(pOutput++) = cb64[(((unsigned char)pInput[0] & 0x03) << 4) | (((unsigned char)pInput[1] & 0xF0) >> 4)];
-			*(pOutput++) = cb64[(((unsigned char)pInput[1] & 0x0F) << 2)];
+			*(out++) = cb64[((in[0] & 0x03) << 4) | (in[1] >> 4)];
+			*(out++) = cb64[(in[1] & 0x0F) << 2];
 		}
 	}
 
-	while (pad && pOutput < m_pEncodedBuf + iEncodedLen)
-		*(pOutput++) = '=';
+	while (pad && out < pOutput + iEncodedLen)
+		*(out++) = '=';
 
-	// Null terminate
-	*pOutput = 0;
-	
-	return m_pEncodedBuf;
+	return (int)(out - pOutput);
 }
 
-// Decode a base64 string to a binary buffer
-// Encoded string must be null terminated
-char* Base64::Decode(const char* pEncodedBuf, int *iOutLen)
+// Decoding stops at the first '=', the whole input must be consumed
+// (i.e. padding is only allowed at the end), same as the original code
+int Base64::DecodeTo(const char* pInput, int iInputLen, char* pOutput, int iOutputSize)
 {
-	int iDecodedLen;
-	int iLen, iBlock, i;
-	if (iOutLen)
-		*iOutLen = 0;
-
-	// allocate buffer to hold the decoded string:
-	const int iEncodedLen = strlen(pEncodedBuf);
-	iDecodedLen = static_cast<int>(3 * (iEncodedLen / 4.f));
-
-	// remove padding from decoded length
-	for(int i = iEncodedLen - 1; i >= 0 && pEncodedBuf[i] == '='; --i, --iDecodedLen);
-
-	if (m_pDecodedBuf != NULL)
-		free (m_pDecodedBuf);
-	m_pDecodedBuf = new char[iDecodedLen];
-
-	// allocate a local scratch buffer for decoding - work with BYTE's to avoid fatal sign extensions by compiler:
-	char* pInput = new char[iEncodedLen+1];
-	strcpy(pInput, pEncodedBuf);
+	const int iDecodedLen = DecodedSize(pInput, iInputLen);
+	if (iDecodedLen < 0 || iDecodedLen > iOutputSize)
+		return -1;
+
+	const signed char* dec = GetTables().dec;
+	const unsigned char* in = (const unsigned char*)pInput;
+	const unsigned char* end = in + iInputLen;
+	unsigned char* out = (unsigned char*)pOutput;
+	const unsigned char* outEnd = out + iDecodedLen;
+
+	// fast path: whole quads, any invalid or padding char makes the OR negative
+	while (end - in >= 4 && outEnd - out >= 3)
+	{
+		const int a = dec[in[0]], b = dec[in[1]], c = dec[in[2]], d = dec[in[3]];
+		if ((a | b | c | d) < 0)
+			break;
+		const unsigned int v = (a << 18) | (b << 12) | (c << 6) | d;
+		out[0] = (unsigned char)(v >> 16);
+		out[1] = (unsigned char)(v >> 8);
+		out[2] = (unsigned char)v;
+		out += 3;
+		in += 4;
+	}
 
-	// Loop for each byte of input:
-	iLen = iBlock = i = 0;
-	while (pInput[iBlock+i])
+	// tail (or first invalid quad), char by char
+	int quad[4], i = 0;
+	for (; in < end; in++)
 	{
-		if ((unsigned char)pInput[iBlock+i] < 0x2B || (unsigned char)pInput[iBlock+i] > 0x7A)
-		{
-			delete [] pInput;
-			return NULL;
-		}
-		if (pInput[iBlock+i] == '=')
+		const int c = dec[*in];
+		if (c == B64_PAD)
 			break;
-		pInput[iBlock+i] = cd64[(unsigned char)pInput[iBlock+i] - 0x2B];
-		if (pInput[iBlock+i] == '$')
-		{
-			delete [] pInput;
-			return NULL;
-		}
-		pInput[iBlock+i] -= 0x3E;
+		if (c == B64_INVALID)
+			return -1;
 
+		quad[i] = c;
+		if (i && out == outEnd) // more data than predicted, e.g. padding in the middle
+			return -1;
 		switch(i++)
 		{
 			// case 0: no data to copy yet!
 		case 1:
-			m_pDecodedBuf[iLen++] = ((unsigned char)pInput[iBlock+0] << 2 | (unsigned char)pInput[iBlock+1] >> 4);
+			*(out++) = (unsigned char)(quad[0] << 2 | quad[1] >> 4);
 			break;
 		case 2:
-			m_pDecodedBuf[iLen++] = ((unsigned char)pInput[iBlock+1] << 4 | (unsigned char)pInput[iBlock+2] >> 2);
+			*(out++) = (unsigned char)(quad[1] << 4 | quad[2] >> 2);
 			break;
 		case 3:
-			m_pDecodedBuf[iLen++] = ((((unsigned char)pInput[iBlock+2] << 6) & 0xC0) | (unsigned char)pInput[iBlock+3]);
+			*(out++) = (unsigned char)(((quad[2] << 6) & 0xC0) | quad[3]);
 			i = 0;
-			iBlock += 4;
 			break;
 		}
 	}
 
-	// clean and check:
-	delete [] pInput;
-	if (iLen != iDecodedLen)
-		return NULL;
-
-	// done:
-	if (iOutLen)
-		*iOutLen = iLen;
-	return m_pDecodedBuf;
+	// check:
+	const int iLen = (int)(out - (unsigned char*)pOutput);
+	return iLen == iDecodedLen ? iLen : -1;
 }
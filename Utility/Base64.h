@@ -33,8 +33,22 @@ class Base64
 		Base64();
 		virtual ~Base64();
 
+		// returned buffers are owned by (and reused with) this instance
 		char* Decode(const char* pInput, int *bufsize);	//bufsize holds the decoded length
 		char* Encode(const char* pEncodedBuf, int iLen, bool pad = false);
-		char* m_pEncodedBuf;
-		char* m_pDecodedBuf;
+
+		// exact sizes, null terminator excluded (DecodedSize() is exact if the input is valid, -1 if it's obviously not)
+		// EncodedSize() returns -1 if the result doesn't fit in an int
+		static int EncodedSize(int iLen, bool pad = false);
+		static int DecodedSize(const char* pInput, int iInputLen);
+
+		// encode/decode into caller-owned buffers, no null terminator written
+		// return the number of chars/bytes written, -1 on error (invalid input, output too small)
+		// inputs can be streamed in pieces of multiples of 3 bytes (encode) or 4 chars (decode)
+		static int EncodeTo(const char* pInput, int iLen, bool pad, char* pOutput, int iOutputSize);
+		static int DecodeTo(const char* pInput, int iInputLen, char* pOutput, int iOutputSize);
+
+	private:
+		WDL_TypedBuf<char> m_encodedBuf;
+		WDL_TypedBuf<char> m_decodedBuf;
 };
@@ -1160,6 +1160,7 @@ void DoSpeadSelItemsOverNewTx(COMMAND_T* ct)
 				GetSetMediaTrackInfo(CSurf_TrackFromID(id, false),"I_FOLDERDEPTH",&depth);
 				depth = 1;
 				GetSetMediaTrackInfo(track,"I_FOLDERDEPTH",&depth);
+				InvalidateFolderIndex();
 			}
 		}
 		TrackList_AdjustWindows(false);
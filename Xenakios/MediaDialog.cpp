@@ -32,6 +32,11 @@
 
 #include <WDL/localize/localize.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 using namespace std;
 
 HWND g_hMediaDlg=0;
@@ -52,6 +57,48 @@ struct t_project_take
 };
 
 vector<t_mediafile_status> g_RProjectFiles;
+unordered_map<string, int> g_ProjectFileUsage; // normalized file name -> number of takes using it, see GetProjectFileList()
+
+// key of g_ProjectFileUsage: same path separators as g_RProjectFiles, case-insensitive on Windows
+string NormalizedFileName(const string& FileName)
+{
+	string Result(FileName);
+	for (int i=0;i<(int)Result.size();i++)
+	{
+		if (Result[i]=='/')
+			Result[i]='\\';
+#ifdef _WIN32
+		else
+			Result[i]=(char)tolower((unsigned char)Result[i]);
+#endif
+	}
+	return Result;
+}
+
+// FileExists() for all files, stat calls are spread over several threads (slow/network drives)
+void CheckFilesExist(const vector<string>& Files, vector<char>& Exists)
+{
+	Exists.assign(Files.size(), 0);
+	atomic<int> Next(0);
+	auto Worker = [&Files, &Exists, &Next]()
+	{
+		for (int i; (i = Next++) < (int)Files.size(); )
+			Exists[i] = FileExists(Files[i].c_str()) ? 1 : 0;
+	};
+
+	const int hardwareThreads = (int)thread::hardware_concurrency();
+	const int nbWorkers = min((int)Files.size(), hardwareThreads > 0 ? hardwareThreads : 1);
+	if (nbWorkers > 1)
+	{
+		vector<thread> Workers;
+		for (int i=0; i<nbWorkers; i++)
+			Workers.push_back(thread(Worker));
+		for (int i=0; i<nbWorkers; i++)
+			Workers[i].join();
+	}
+	else
+		Worker();
+}
 
 string RemoveDoubleBackSlashes(string TheFileName)
 {
@@ -117,25 +164,36 @@ void GetAllProjectTakes(vector<t_project_take>& ATakeList)
 				TakeBlah.TheTake=CurTake;
 				TakeBlah.FileMissing=false;
 				if (!pureMIDItake)
-				{
-					if (!FileExists(TakeBlah.FileName.c_str()))
-						TakeBlah.FileMissing=true;
-
 					ATakeList.push_back(TakeBlah);
-				}
 			}
 		}
 	}
+
+	// check each file once
+	vector<string> Files;
+	unordered_map<string, int> FileIndexes;
+	vector<int> TakeFiles(ATakeList.size());
+	for (i=0;i<(int)ATakeList.size();i++)
+	{
+		auto Found=FileIndexes.emplace(ATakeList[i].FileName, (int)Files.size());
+		if (Found.second)
+			Files.push_back(ATakeList[i].FileName);
+		TakeFiles[i]=Found.first->second;
+	}
+	vector<char> Exists;
+	CheckFilesExist(Files, Exists);
+	for (i=0;i<(int)ATakeList.size();i++)
+		ATakeList[i].FileMissing=!Exists[TakeFiles[i]];
 }
 
+// also updates g_ProjectFileUsage
 void GetProjectFileList(vector<t_mediafile_status>& AMediaList)
 {
-	vector<string> ProjectFiles;
 	vector<string> TempList;
-	vector<int> vecusedcount;
 	int i;
 	int j;
 	int k;
+	g_ProjectFileUsage.clear();
 	for (i=0;i<GetNumTracks();i++)
 	{
 		MediaTrack *CurTrack = CSurf_TrackFromID(i+1,false);
@@ -174,13 +232,7 @@ void GetProjectFileList(vector<t_mediafile_status>& AMediaList)
 							}
 							if (!ispurelyMIDI)
 							{
-								int Matches=0;
-								for (int L=0;L<(int)TempList.size();L++)
-								{
-									if (FName.compare(TempList[L])==0)
-										Matches++;
-								}
-								if (Matches==0)
+								if (g_ProjectFileUsage[NormalizedFileName(FName)]++==0)
 									TempList.push_back(FName);
 							}
 						}
@@ -190,6 +242,9 @@ void GetProjectFileList(vector<t_mediafile_status>& AMediaList)
 		}
 	}
 
+	vector<char> Exists;
+	CheckFilesExist(TempList, Exists);
+
 	AMediaList.clear();
 	for (i=0;i<(int)TempList.size();i++)
 	{
@@ -198,21 +253,21 @@ void GetProjectFileList(vector<t_mediafile_status>& AMediaList)
 		string::size_type pos;
 		while ((pos = newstatus.FileName.find('/')) != string::npos)
 			newstatus.FileName[pos] = '\\';
-		newstatus.IsOnline = FileExists(TempList[i].c_str());
+		newstatus.IsOnline = Exists[i]!=0;
 		AMediaList.push_back(newstatus);
 	}
 }
 
+// returns the number of takes using AFile, see GetProjectFileList()
+int NumTimesFileUsedInProject(const string& AFile)
+{
+	auto Found=g_ProjectFileUsage.find(NormalizedFileName(AFile));
+	return Found!=g_ProjectFileUsage.end() ? Found->second : 0;
+}
+
 int IsFileUsedInProject(string AFile)
 {
-	int Matches=0;
-	int i;
-	for (i=0;i<(int)g_RProjectFiles.size();i++)
-	{
-		if (AFile.compare(g_RProjectFiles[i].FileName)==0) Matches++;
-	}
-	return Matches;
-	//if (Matches>0) return true; else return false;
+	return NumTimesFileUsedInProject(AFile);
 }
 
 vector<string> g_ProjFolFiles;
@@ -356,6 +411,8 @@ WDL_DLGRET MulMatchesFoundDlgProc(HWND hwnd, UINT Message, WPARAM wParam, LPARAM
 				ListView_SetItemText(GetDlgItem(hwnd,IDC_MULMATCHLIST),i,1,buf);
 #endif
 			}
+			// candidates are grouped by identical copies, see GroupDuplicateMatches()
+			ListView_SetItemState(GetDlgItem(hwnd,IDC_MULMATCHLIST),0,LVIS_SELECTED|LVIS_FOCUSED,LVIS_SELECTED|LVIS_FOCUSED);
 			return 0;
 		}
 		case WM_COMMAND:
@@ -391,12 +448,99 @@ WDL_DLGRET MulMatchesFoundDlgProc(HWND hwnd, UINT Message, WPARAM wParam, LPARAM
 bool g_ScanFinished=false;
 
 vector<string> FoundMediaFiles;
+unordered_map<string, vector<int> > g_FoundMediaIndex; // file name (w/o path) -> FoundMediaFiles indexes
 char g_FolderName[1024] = "";
 
+// same as ExtractFileNameEx(), w/o copy
+const char* FileNamePart(const char* FullFileName)
+{
+	const char* pFile = strrchr(FullFileName, PATH_SLASH_CHAR);
+	return pFile ? pFile+1 : FullFileName;
+}
+
+// directories waiting to be scanned, shared by the DirScanWorker() threads
+struct t_dirscan_queue
+{
+	vector<string> Dirs;
+	int Busy; // number of workers scanning a directory, i.e. that may push new sub-directories
+	mutex Lock;
+	condition_variable Wake;
+};
+
+void DirScanWorker(t_dirscan_queue* Queue, vector<string>* FoundFiles)
+{
+	vector<string> SubDirs;
+	WDL_String FoundFile;
+	unique_lock<mutex> lock(Queue->Lock);
+	for (;;)
+	{
+		Queue->Wake.wait(lock, [Queue] { return !Queue->Dirs.empty() || !Queue->Busy || g_bAbortScan; });
+		if (Queue->Dirs.empty() || g_bAbortScan) // nothing left, and no other worker can add more
+			break;
+		string Dir = Queue->Dirs.back();
+		Queue->Dirs.pop_back();
+		Queue->Busy++;
+		lstrcpyn(g_CurrentScanFile, Dir.c_str(), 1024);
+		lock.unlock();
+
+		// scan this directory only, sub-directories go back to the queue
+		WDL_DirScan ds;
+		if (!ds.First(Dir.c_str()))
+		{
+			do
+			{
+				const char* fn = ds.GetCurrentFN();
+				if (strcmp(fn, ".") == 0 || strcmp(fn, "..") == 0)
+					continue;
+				ds.GetCurrentFullFN(&FoundFile);
+				if (ds.GetCurrentIsDirectory())
+					SubDirs.push_back(FoundFile.Get());
+				else if (const char* cFoundExt = strrchr(fn, '.'))
+				{
+					if (IsMediaExtension(cFoundExt+1, false))
+						FoundFiles->push_back(FoundFile.Get());
+				}
+			}
+			while(!ds.Next() && !g_bAbortScan);
+		}
+
+		lock.lock();
+		Queue->Busy--;
+		Queue->Dirs.insert(Queue->Dirs.end(), SubDirs.begin(), SubDirs.end());
+		SubDirs.clear();
+		Queue->Wake.notify_all();
+	}
+	Queue->Wake.notify_all();
+}
+
+// walks g_FolderName with several threads (sub-directories are dispatched to idle
+// workers) and indexes found media files by file name, see FindMissingFiles()
 unsigned int WINAPI DirScanThreadFunc(void*)
 {
 	FoundMediaFiles.clear();
-	SearchDirectory(FoundMediaFiles, g_FolderName, NULL, true);
+	g_FoundMediaIndex.clear();
+
+	t_dirscan_queue Queue;
+	Queue.Dirs.push_back(g_FolderName);
+	Queue.Busy = 0;
+
+	const int hardwareThreads = (int)thread::hardware_concurrency();
+	const int nbWorkers = hardwareThreads > 0 ? hardwareThreads : 1;
+	vector<vector<string> > WorkerFiles(nbWorkers);
+	vector<thread> Workers;
+	for (int i=0; i<nbWorkers; i++)
+		Workers.push_back(thread(DirScanWorker, &Queue, &WorkerFiles[i]));
+	for (int i=0; i<nbWorkers; i++)
+		Workers[i].join();
+
+	for (int i=0; i<nbWorkers; i++)
+		FoundMediaFiles.insert(FoundMediaFiles.end(), WorkerFiles[i].begin(), WorkerFiles[i].end());
+	sort(FoundMediaFiles.begin(), FoundMediaFiles.end()); // the walk order depends on thread scheduling
+
+	g_FoundMediaIndex.reserve(FoundMediaFiles.size());
+	for (int i=0; i<(int)FoundMediaFiles.size(); i++)
+		g_FoundMediaIndex[FileNamePart(FoundMediaFiles[i].c_str())].push_back(i);
+
 	g_ScanStatus = 0;
 	return 0;
 }
@@ -463,90 +607,96 @@ WDL_DLGRET ScanProgDlgProc(HWND hwnd, UINT Message, WPARAM wParam, LPARAM lParam
 
 
 
+// moves candidates sharing the same size and modification date (i.e. copies) next to each
+// other, in order of first appearance, so that they show up grouped in the multiple matches dialog
+void GroupDuplicateMatches(vector<string>& Candidates)
+{
+	vector<pair<long long,long long> > Stamps;
+	for (int i=0; i<(int)Candidates.size(); i++)
+	{
+		struct stat s;
+#ifdef _WIN32
+		if (statUTF8(Candidates[i].c_str(), &s) != 0)
+#else
+		if (stat(Candidates[i].c_str(), &s) != 0)
+#endif
+			Stamps.push_back(make_pair(-1LL, (long long)i)); // can't verify, own group
+		else
+			Stamps.push_back(make_pair((long long)s.st_size, (long long)s.st_mtime));
+	}
+
+	vector<string> Grouped;
+	vector<bool> Done(Candidates.size(), false);
+	for (int i=0; i<(int)Candidates.size(); i++)
+	{
+		if (Done[i])
+			continue;
+		for (int j=i; j<(int)Candidates.size(); j++)
+		{
+			if (!Done[j] && Stamps[j]==Stamps[i])
+			{
+				Grouped.push_back(Candidates[j]);
+				Done[j]=true;
+			}
+		}
+	}
+	Candidates.swap(Grouped);
+}
+
 void FindMissingFiles()
 {
 	if (BrowseForDirectory("Select search folder", NULL, g_FolderName, 1024))
 	{
-		char FullFilename[2048];
-		char FullFilenameB[2048];
-		char Shortfilename[2048];
-		char ShortfilenameB[2048];
-
 		DialogBox(g_hInst,MAKEINTRESOURCE(IDD_SCANPROGR),g_hMediaDlg,(DLGPROC)ScanProgDlgProc);
 		g_ScanStatus=0;
 		g_ScanFinished=true;
 		SetForegroundWindow(g_hMediaDlg);
 		vector<t_project_take> ProjectTakes;
-		vector<t_project_take> TakesMissingFiles;
 		GetAllProjectTakes(ProjectTakes);
-		int i;
-		for (i=0;i<(int)ProjectTakes.size();i++)
-			if (ProjectTakes[i].FileMissing==true)
-				TakesMissingFiles.push_back(ProjectTakes[i]);
-		Main_OnCommand(40100,0); // set all media offline
-		int SanityCheck=(int)TakesMissingFiles.size();
-		i=0;
 
-		bool TakesLeft=true;
-		if (TakesMissingFiles.size()==0) TakesLeft=false;
-		while (TakesLeft==true)
+		// group missing takes by file name, each file is matched (and possibly prompted for) once
+		vector<string> MissingFiles;
+		unordered_map<string, vector<MediaItem_Take*> > TakesByFile;
+		for (int i=0;i<(int)ProjectTakes.size();i++)
 		{
-			t_project_take TempTake;
-			TempTake=TakesMissingFiles[i];
-			int FileMatches=0;
-			strcpy(FullFilename,TakesMissingFiles[i].FileName.c_str());
-			ExtractFileNameEx(FullFilename,Shortfilename,false);
-			g_MatchingFiles.clear();
-			int j;
-			for (j=0;j<(int)FoundMediaFiles.size();j++)
+			if (ProjectTakes[i].FileMissing==true)
 			{
-				strcpy(FullFilenameB,FoundMediaFiles[j].c_str());
-				ExtractFileNameEx(FullFilenameB,ShortfilenameB,false);
-				if (strcmp(Shortfilename,ShortfilenameB)==0)
-				{
-					FileMatches++;
-					g_MatchingFiles.push_back(FoundMediaFiles[j]);
-				}
+				vector<MediaItem_Take*>& Takes=TakesByFile[ProjectTakes[i].FileName];
+				if (Takes.empty())
+					MissingFiles.push_back(ProjectTakes[i].FileName);
+				Takes.push_back(ProjectTakes[i].TheTake);
 			}
+		}
+
+		Main_OnCommand(40100,0); // set all media offline
+		for (int i=0;i<(int)MissingFiles.size();i++)
+		{
+			auto Found=g_FoundMediaIndex.find(FileNamePart(MissingFiles[i].c_str()));
+			if (Found==g_FoundMediaIndex.end())
+				continue;
+
+			g_MatchingFiles.clear();
+			for (int j=0;j<(int)Found->second.size();j++)
+				g_MatchingFiles.push_back(FoundMediaFiles[Found->second[j]]);
+			if (g_MatchingFiles.size()>1)
+				GroupDuplicateMatches(g_MatchingFiles);
+
 			string TheMatchingFile;
-			TheMatchingFile.assign(TakesMissingFiles[i].FileName);
-			if (g_MatchingFiles.size()==0)
-				TakesMissingFiles.erase(TakesMissingFiles.begin()+i);
-			else if (g_MatchingFiles.size()==1)
-			{
+			if (g_MatchingFiles.size()==1)
 				TheMatchingFile.assign(g_MatchingFiles[0]);
-				ReplaceTakeSourceFile(TakesMissingFiles[i].TheTake,TheMatchingFile);
-				TakesMissingFiles.erase(TakesMissingFiles.begin()+i);
-			}
-			else if (g_MatchingFiles.size()>1)
+			else
 			{
 				g_SelectedMatchFile=-1;
 				DialogBox(g_hInst,MAKEINTRESOURCE(IDD_MULMATCH),g_hMediaDlg , (DLGPROC)MulMatchesFoundDlgProc);
-				if (g_SelectedMatchFile>=0)
-				{
-					TheMatchingFile.assign(g_MatchingFiles[g_SelectedMatchFile]);
-					ReplaceTakeSourceFile(TakesMissingFiles[i].TheTake,TheMatchingFile);
-				}
-				TakesMissingFiles.erase(TakesMissingFiles.begin()+i);
-			}
-			// Searching remaining takes using the same file...
-			int k;
-			for (k=0;k<(int)TakesMissingFiles.size();k++)
-			{
-				if (TakesMissingFiles[k].FileName.compare(FullFilename)==0)
-				{
-					// replace file
-					ReplaceTakeSourceFile(TakesMissingFiles[k].TheTake,TheMatchingFile);
-					TakesMissingFiles.erase(TakesMissingFiles.begin()+k);
-				}
-			}
-			if (TakesMissingFiles.size()==0) TakesLeft=false;
-			SanityCheck--;
-			if (SanityCheck<0)
-			{
-				// Sanity check, exiting while (TakesMissingFiles.size()>0)
-				break;
+				if (g_SelectedMatchFile<0)
+					continue;
+				TheMatchingFile.assign(g_MatchingFiles[g_SelectedMatchFile]);
 			}
+
+			// relink all takes using this file
+			vector<MediaItem_Take*>& Takes=TakesByFile[MissingFiles[i]];
+			for (int k=0;k<(int)Takes.size();k++)
+				ReplaceTakeSourceFile(Takes[k],TheMatchingFile);
 		}
 		Main_OnCommand(40101,0); // set all media online
 		Main_OnCommand(40047,0); // build any missing peaks
@@ -554,39 +704,11 @@ void FindMissingFiles()
 	}
 }
 
-int NumTimesFileUsedInProject(string &fn, vector<MediaItem_Take*>& thetakes)
-{
-	int i;
-	int matches=0;
-	string cmpfn;
-	for (i=0;i<(int)thetakes.size();i++)
-	{
-		PCM_source *src=(PCM_source*)GetSetMediaItemTakeInfo(thetakes[i],"P_SOURCE",0);
-		if (src)
-		{
-			cmpfn.assign("not a valid filename 45FF78E");
-			if (src->GetFileName() && strlen(src->GetFileName())>0)
-				cmpfn.assign(src->GetFileName());
-			if (strcmp(src->GetType(),"SECTION")==0)
-			{
-				PCM_source *src2=src->GetSource();
-				if (src2)
-					cmpfn.assign(src2->GetFileName() ? src2->GetFileName() : "");
-			}
-			if (fn.compare(cmpfn)==0)
-				matches++;
-		}
-	}
-	return matches;
-}
-
 void PopulateProjectUsedList(bool HidePaths)
 {
 	ListView_DeleteAllItems(GetDlgItem(g_hMediaDlg, IDC_PROJFILES_USED));
 	LVITEM item;
 	char buf[2048];
-	vector<MediaItem_Take*> thetakes;
-	XenGetProjectTakes(thetakes, false, false);
 
 	for (int i = 0; i < (int)g_RProjectFiles.size(); i++)
 	{
@@ -605,7 +727,7 @@ void PopulateProjectUsedList(bool HidePaths)
 		ListView_InsertItem(GetDlgItem(g_hMediaDlg, IDC_PROJFILES_USED), &item);
 		ListView_SetItemText(GetDlgItem(g_hMediaDlg,IDC_PROJFILES_USED), i, 2, g_RProjectFiles[i].IsOnline ? "Online" : "Missing");
 		char ynh[20];
-		sprintf(ynh, "%d", NumTimesFileUsedInProject(g_RProjectFiles[i].FileName, thetakes));
+		sprintf(ynh, "%d", NumTimesFileUsedInProject(g_RProjectFiles[i].FileName));
 		ListView_SetItemText(GetDlgItem(g_hMediaDlg, IDC_PROJFILES_USED), i, 1, ynh);
 	}
 }
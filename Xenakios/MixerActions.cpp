@@ -401,6 +401,7 @@ void DoSetSelectedTrackNormal(COMMAND_T* ct)
 				int foldepth=0;
 				GetSetMediaTrackInfo(TracksToReset[i],"I_FOLDERDEPTH",&foldepth);
 			}
+			InvalidateFolderIndex();
 			Undo_OnStateChangeEx(SWS_CMD_SHORTNAME(ct),UNDO_STATE_TRACKCFG,-1);
 		}
 		
@@ -431,6 +432,7 @@ void DoSetSelectedTracksAsFolder(COMMAND_T* ct)
 		GetSetMediaTrackInfo(VecSelTracks[0],"I_FOLDERDEPTH",&foldepth);
 		foldepth=-1;
 		GetSetMediaTrackInfo(VecSelTracks[VecSelTracks.size()-1],"I_FOLDERDEPTH",&foldepth);
+		InvalidateFolderIndex();
 		Undo_OnStateChangeEx(SWS_CMD_SHORTNAME(ct),UNDO_STATE_TRACKCFG,-1);
 	}
 	else
@@ -29,7 +29,6 @@
 #include "ebur128.h"
 #define _USE_MATH_DEFINES
 #include <math.h>
-#include "queue/sys/queue.h"
 #include <WDL/localize/localize.h>
 
 #define CHECK_ERROR(condition, errorcode, goto_point)                          \
@@ -38,12 +37,39 @@
     goto goto_point;                                                           \
   }
 
-SLIST_HEAD(ebur128_double_queue, ebur128_dq_entry);
-struct ebur128_dq_entry {
-  double z;
-  SLIST_ENTRY(ebur128_dq_entry) entries;
+/** Growable array of block energies. Appending is amortized O(1) and
+ *  allocates only when the capacity doubles. */
+struct ebur128_block_store {
+  double* z;
+  size_t size;
+  size_t capacity;
 };
 
+static void ebur128_block_store_init(struct ebur128_block_store* store) {
+  store->z = NULL;
+  store->size = 0;
+  store->capacity = 0;
+}
+
+static void ebur128_block_store_free(struct ebur128_block_store* store) {
+  free(store->z);
+  ebur128_block_store_init(store);
+}
+
+static int ebur128_block_store_append(struct ebur128_block_store* store,
+                                      double z) {
+  if (store->size == store->capacity) {
+    /* 1024 blocks are ~100s of audio for gating blocks */
+    size_t capacity = store->capacity ? store->capacity * 2 : 1024;
+    double* grown = (double*) realloc(store->z, capacity * sizeof(double));
+    if (!grown) return EBUR128_ERROR_NOMEM;
+    store->z = grown;
+    store->capacity = capacity;
+  }
+  store->z[store->size++] = z;
+  return EBUR128_SUCCESS;
+}
+
 struct ebur128_state_internal {
   /** Filtered audio data (used as ring buffer). */
   double* audio_data;
@@ -63,12 +89,25 @@ struct ebur128_state_internal {
   double b[5];
   /** BS.1770 filter coefficients (denominator). */
   double a[5];
-  /** BS.1770 filter state. */
-  double v[5][5];
-  /** Linked list of block energies. */
-  struct ebur128_double_queue block_list;
-  /** Linked list of 3s-block energies, used to calculate LRA. */
-  struct ebur128_double_queue short_term_block_list;
+  /** BS.1770 filter state, 5 values per channel. */
+  double* v;
+  /** Filter input converted to double, used by the non-double frontends. */
+  double* filter_input;
+  /** Energy (sum of squared filtered samples) of every complete 100ms
+   *  sub-block in audio_data, one slot per sub-block and channel. */
+  double* subblock_energy;
+  /** Number of 100ms sub-blocks in audio_data. */
+  size_t subblock_count;
+  /** Energy of the sub-block currently being filled, one per channel. */
+  double* subblock_energy_acc;
+  /** Block energies. */
+  struct ebur128_block_store block_list;
+  /** 3s-block energies, used to calculate LRA. */
+  struct ebur128_block_store short_term_block_list;
+  /** Energies of all blocks in time order, see ebur128_block_log. */
+  int use_block_log;
+  struct ebur128_block_store block_log;
+  struct ebur128_block_store short_term_block_log;
   int use_histogram;
   unsigned long *block_energy_histogram;
   unsigned long *short_term_block_energy_histogram;
@@ -99,7 +138,7 @@ static double histogram_energies[1000];
 static double histogram_energy_boundaries[1001];
 
 static void ebur128_init_filter(ebur128_state* st) {
-  int i, j;
+  size_t i;
 
   double f0 = 1681.974450955533;
   double G  =    3.999843853973347;
@@ -145,13 +184,47 @@ static void ebur128_init_filter(ebur128_state* st) {
   st->d->a[3] = pa[1] * ra[2] + pa[2] * ra[1];
   st->d->a[4] = pa[2] * ra[2];
 
-  for (i = 0; i < 5; ++i) {
-    for (j = 0; j < 5; ++j) {
-      st->d->v[i][j] = 0.0;
-    }
+  for (i = 0; i < st->channels * 5; ++i) {
+    st->d->v[i] = 0.0;
   }
 }
 
+static void ebur128_free_channel_buffers(ebur128_state* st) {
+  free(st->d->v);                   st->d->v = NULL;
+  free(st->d->filter_input);        st->d->filter_input = NULL;
+  free(st->d->subblock_energy);     st->d->subblock_energy = NULL;
+  free(st->d->subblock_energy_acc); st->d->subblock_energy_acc = NULL;
+}
+
+/* Allocates the per channel filter state and the 100ms sub-block energy
+ * cache. Needs channels and audio_data_frames to be set. */
+static int ebur128_init_channel_buffers(ebur128_state* st) {
+  size_t i;
+  st->d->subblock_count = st->d->audio_data_frames / st->d->samples_in_100ms;
+
+  st->d->v = (double*) malloc(st->channels * 5 * sizeof(double));
+  st->d->filter_input = (double*) malloc(st->d->samples_in_100ms *
+                                         st->channels * sizeof(double));
+  st->d->subblock_energy = (double*) malloc(st->d->subblock_count *
+                                            st->channels * sizeof(double));
+  st->d->subblock_energy_acc = (double*) malloc(st->channels * sizeof(double));
+  if (!st->d->v || !st->d->filter_input || !st->d->subblock_energy ||
+      !st->d->subblock_energy_acc) {
+    ebur128_free_channel_buffers(st);
+    return EBUR128_ERROR_NOMEM;
+  }
+  for (i = 0; i < st->channels * 5; ++i) {
+    st->d->v[i] = 0.0;
+  }
+  for (i = 0; i < st->d->subblock_count * st->channels; ++i) {
+    st->d->subblock_energy[i] = 0.0;
+  }
+  for (i = 0; i < st->channels; ++i) {
+    st->d->subblock_energy_acc[i] = 0.0;
+  }
+  return EBUR128_SUCCESS;
+}
+
 static int ebur128_init_channel_map(ebur128_state* st) {
   size_t i;
   st->d->channel_map = (int*) malloc(st->channels * sizeof(int));
@@ -295,6 +368,7 @@ ebur128_state* ebur128_init(unsigned int channels,
   }
 
   st->d->use_histogram = mode & EBUR128_MODE_HISTOGRAM ? 1 : 0;
+  st->d->use_block_log = mode & EBUR128_MODE_BLOCK_LOG ? 1 : 0;
 
   st->samplerate = samplerate;
   st->d->samples_in_100ms = (st->samplerate + 5) / 10;
@@ -314,11 +388,13 @@ ebur128_state* ebur128_init(unsigned int channels,
     st->d->audio_data[i] = 0.0;
   }
 
+  errcode = ebur128_init_channel_buffers(st);
+  CHECK_ERROR(errcode, 0, free_audio_data)
   ebur128_init_filter(st);
 
   if (st->d->use_histogram) {
     st->d->block_energy_histogram = (unsigned long*)malloc(1000 * sizeof(unsigned long));
-    CHECK_ERROR(!st->d->block_energy_histogram, 0, free_audio_data)
+    CHECK_ERROR(!st->d->block_energy_histogram, 0, free_channel_buffers)
     for (i = 0; i < 1000; ++i) {
       st->d->block_energy_histogram[i] = 0;
     }
@@ -334,8 +410,10 @@ ebur128_state* ebur128_init(unsigned int channels,
   } else {
     st->d->short_term_block_energy_histogram = NULL;
   }
-  SLIST_INIT(&st->d->block_list);
-  SLIST_INIT(&st->d->short_term_block_list);
+  ebur128_block_store_init(&st->d->block_list);
+  ebur128_block_store_init(&st->d->short_term_block_list);
+  ebur128_block_store_init(&st->d->block_log);
+  ebur128_block_store_init(&st->d->short_term_block_log);
   st->d->short_term_frame_counter = 0;
 
   result = ebur128_init_resampler(st);
@@ -365,6 +443,8 @@ free_short_term_block_energy_histogram:
   free(st->d->short_term_block_energy_histogram);
 free_block_energy_histogram:
   free(st->d->block_energy_histogram);
+free_channel_buffers:
+  ebur128_free_channel_buffers(st);
 free_audio_data:
   free(st->d->audio_data);
 free_true_peak_frame:
@@ -386,25 +466,19 @@ exit:
 }
 
 void ebur128_destroy(ebur128_state** st) {
-  struct ebur128_dq_entry* entry;
   free((*st)->d->block_energy_histogram);
   free((*st)->d->short_term_block_energy_histogram);
   free((*st)->d->audio_data);
+  ebur128_free_channel_buffers(*st);
   free((*st)->d->channel_map);
   free((*st)->d->sample_peak);
   free((*st)->d->sample_peak_frame);
   free((*st)->d->true_peak);
   free((*st)->d->true_peak_frame);
-  while (!SLIST_EMPTY(&(*st)->d->block_list)) {
-    entry = SLIST_FIRST(&(*st)->d->block_list);
-    SLIST_REMOVE_HEAD(&(*st)->d->block_list, entries);
-    free(entry);
-  }
-  while (!SLIST_EMPTY(&(*st)->d->short_term_block_list)) {
-    entry = SLIST_FIRST(&(*st)->d->short_term_block_list);
-    SLIST_REMOVE_HEAD(&(*st)->d->short_term_block_list, entries);
-    free(entry);
-  }
+  ebur128_block_store_free(&(*st)->d->block_list);
+  ebur128_block_store_free(&(*st)->d->short_term_block_list);
+  ebur128_block_store_free(&(*st)->d->block_log);
+  ebur128_block_store_free(&(*st)->d->short_term_block_log);
 
   ebur128_destroy_resampler(*st);
 
@@ -454,18 +528,271 @@ static void ebur128_check_true_peak(ebur128_state* st, size_t frames) {
 #define TURN_ON_FTZ
 #define TURN_OFF_FTZ
 #define FLUSH_MANUALLY \
-    st->d->v[ci][4] = fabs(st->d->v[ci][4]) < DBL_MIN ? 0.0 : st->d->v[ci][4]; \
-    st->d->v[ci][3] = fabs(st->d->v[ci][3]) < DBL_MIN ? 0.0 : st->d->v[ci][3]; \
-    st->d->v[ci][2] = fabs(st->d->v[ci][2]) < DBL_MIN ? 0.0 : st->d->v[ci][2]; \
-    st->d->v[ci][1] = fabs(st->d->v[ci][1]) < DBL_MIN ? 0.0 : st->d->v[ci][1];
+    for (i = 0; i < st->channels * 5; ++i) { \
+      st->d->v[i] = fabs(st->d->v[i]) < DBL_MIN ? 0.0 : st->d->v[i]; \
+    }
+#endif
+
+/* The K-weighting filter runs several channels in lockstep: the recursion
+ * of a single channel can't be vectorized, but independent channels can.
+ * Every kernel evaluates the exact same expression as the scalar one, so the
+ * output doesn't depend on which kernel processed a channel. While filtering,
+ * the squared output is summed into subblock_energy_acc. */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define EBUR128_FILTER_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(__AVX__)
+#define EBUR128_FILTER_AVX
+#include <immintrin.h>
+#endif
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define EBUR128_FILTER_NEON
+#include <arm_neon.h>
+#endif
+
+static void ebur128_filter_channel(ebur128_state* st, const double* src,
+                                   double* dest, size_t frames, size_t c) {
+  const size_t channels = st->channels;
+  const double* a = st->d->a;
+  const double* b = st->d->b;
+  double* v = st->d->v + c * 5;
+  double v1 = v[1], v2 = v[2], v3 = v[3], v4 = v[4];
+  double energy = 0.0;
+  size_t i;
+  for (i = 0; i < frames; ++i) {
+    double v0 = src[i * channels] - a[1] * v1 - a[2] * v2
+                                  - a[3] * v3 - a[4] * v4;
+    double y = b[0] * v0 + b[1] * v1 + b[2] * v2 + b[3] * v3 + b[4] * v4;
+    dest[i * channels] = y;
+    energy += y * y;
+    v4 = v3; v3 = v2; v2 = v1; v1 = v0;
+  }
+  v[0] = v1; v[1] = v1; v[2] = v2; v[3] = v3; v[4] = v4;
+  st->d->subblock_energy_acc[c] += energy;
+}
+
+#ifdef EBUR128_FILTER_SSE2
+static void ebur128_filter_channels_sse2(ebur128_state* st, const double* src,
+                                         double* dest, size_t frames,
+                                         const size_t* c) {
+  const size_t channels = st->channels;
+  double* va = st->d->v + c[0] * 5;
+  double* vb = st->d->v + c[1] * 5;
+  const __m128d a1 = _mm_set1_pd(st->d->a[1]), a2 = _mm_set1_pd(st->d->a[2]);
+  const __m128d a3 = _mm_set1_pd(st->d->a[3]), a4 = _mm_set1_pd(st->d->a[4]);
+  const __m128d b0 = _mm_set1_pd(st->d->b[0]), b1 = _mm_set1_pd(st->d->b[1]);
+  const __m128d b2 = _mm_set1_pd(st->d->b[2]), b3 = _mm_set1_pd(st->d->b[3]);
+  const __m128d b4 = _mm_set1_pd(st->d->b[4]);
+  __m128d v1 = _mm_set_pd(vb[1], va[1]), v2 = _mm_set_pd(vb[2], va[2]);
+  __m128d v3 = _mm_set_pd(vb[3], va[3]), v4 = _mm_set_pd(vb[4], va[4]);
+  __m128d energy = _mm_setzero_pd();
+  double out[2];
+  size_t i;
+  for (i = 0; i < frames; ++i) {
+    const double* in = src + i * channels;
+    __m128d v0 = _mm_set_pd(in[c[1]], in[c[0]]);
+    v0 = _mm_sub_pd(v0, _mm_mul_pd(a1, v1));
+    v0 = _mm_sub_pd(v0, _mm_mul_pd(a2, v2));
+    v0 = _mm_sub_pd(v0, _mm_mul_pd(a3, v3));
+    v0 = _mm_sub_pd(v0, _mm_mul_pd(a4, v4));
+    __m128d y = _mm_mul_pd(b0, v0);
+    y = _mm_add_pd(y, _mm_mul_pd(b1, v1));
+    y = _mm_add_pd(y, _mm_mul_pd(b2, v2));
+    y = _mm_add_pd(y, _mm_mul_pd(b3, v3));
+    y = _mm_add_pd(y, _mm_mul_pd(b4, v4));
+    _mm_storel_pd(dest + i * channels + c[0], y);
+    _mm_storeh_pd(dest + i * channels + c[1], y);
+    energy = _mm_add_pd(energy, _mm_mul_pd(y, y));
+    v4 = v3; v3 = v2; v2 = v1; v1 = v0;
+  }
+  _mm_storeu_pd(out, v1); va[0] = va[1] = out[0]; vb[0] = vb[1] = out[1];
+  _mm_storeu_pd(out, v2); va[2] = out[0]; vb[2] = out[1];
+  _mm_storeu_pd(out, v3); va[3] = out[0]; vb[3] = out[1];
+  _mm_storeu_pd(out, v4); va[4] = out[0]; vb[4] = out[1];
+  _mm_storeu_pd(out, energy);
+  st->d->subblock_energy_acc[c[0]] += out[0];
+  st->d->subblock_energy_acc[c[1]] += out[1];
+}
 #endif
 
+#ifdef EBUR128_FILTER_AVX
+static void ebur128_filter_channels_avx(ebur128_state* st, const double* src,
+                                        double* dest, size_t frames,
+                                        const size_t* c) {
+  const size_t channels = st->channels;
+  double* v[4];
+  const __m256d a1 = _mm256_set1_pd(st->d->a[1]);
+  const __m256d a2 = _mm256_set1_pd(st->d->a[2]);
+  const __m256d a3 = _mm256_set1_pd(st->d->a[3]);
+  const __m256d a4 = _mm256_set1_pd(st->d->a[4]);
+  const __m256d b0 = _mm256_set1_pd(st->d->b[0]);
+  const __m256d b1 = _mm256_set1_pd(st->d->b[1]);
+  const __m256d b2 = _mm256_set1_pd(st->d->b[2]);
+  const __m256d b3 = _mm256_set1_pd(st->d->b[3]);
+  const __m256d b4 = _mm256_set1_pd(st->d->b[4]);
+  __m256d v1, v2, v3, v4;
+  __m256d energy = _mm256_setzero_pd();
+  double out[4];
+  size_t i, k;
+  for (k = 0; k < 4; ++k) v[k] = st->d->v + c[k] * 5;
+  v1 = _mm256_set_pd(v[3][1], v[2][1], v[1][1], v[0][1]);
+  v2 = _mm256_set_pd(v[3][2], v[2][2], v[1][2], v[0][2]);
+  v3 = _mm256_set_pd(v[3][3], v[2][3], v[1][3], v[0][3]);
+  v4 = _mm256_set_pd(v[3][4], v[2][4], v[1][4], v[0][4]);
+  for (i = 0; i < frames; ++i) {
+    const double* in = src + i * channels;
+    double* o = dest + i * channels;
+    __m256d v0 = _mm256_set_pd(in[c[3]], in[c[2]], in[c[1]], in[c[0]]);
+    v0 = _mm256_sub_pd(v0, _mm256_mul_pd(a1, v1));
+    v0 = _mm256_sub_pd(v0, _mm256_mul_pd(a2, v2));
+    v0 = _mm256_sub_pd(v0, _mm256_mul_pd(a3, v3));
+    v0 = _mm256_sub_pd(v0, _mm256_mul_pd(a4, v4));
+    __m256d y = _mm256_mul_pd(b0, v0);
+    y = _mm256_add_pd(y, _mm256_mul_pd(b1, v1));
+    y = _mm256_add_pd(y, _mm256_mul_pd(b2, v2));
+    y = _mm256_add_pd(y, _mm256_mul_pd(b3, v3));
+    y = _mm256_add_pd(y, _mm256_mul_pd(b4, v4));
+    _mm256_storeu_pd(out, y);
+    o[c[0]] = out[0]; o[c[1]] = out[1]; o[c[2]] = out[2]; o[c[3]] = out[3];
+    energy = _mm256_add_pd(energy, _mm256_mul_pd(y, y));
+    v4 = v3; v3 = v2; v2 = v1; v1 = v0;
+  }
+  _mm256_storeu_pd(out, v1); for (k = 0; k < 4; ++k) v[k][0] = v[k][1] = out[k];
+  _mm256_storeu_pd(out, v2); for (k = 0; k < 4; ++k) v[k][2] = out[k];
+  _mm256_storeu_pd(out, v3); for (k = 0; k < 4; ++k) v[k][3] = out[k];
+  _mm256_storeu_pd(out, v4); for (k = 0; k < 4; ++k) v[k][4] = out[k];
+  _mm256_storeu_pd(out, energy);
+  for (k = 0; k < 4; ++k) st->d->subblock_energy_acc[c[k]] += out[k];
+}
+#endif
+
+#ifdef EBUR128_FILTER_NEON
+static void ebur128_filter_channels_neon(ebur128_state* st, const double* src,
+                                         double* dest, size_t frames,
+                                         const size_t* c) {
+  const size_t channels = st->channels;
+  double* va = st->d->v + c[0] * 5;
+  double* vb = st->d->v + c[1] * 5;
+  const float64x2_t a1 = vdupq_n_f64(st->d->a[1]), a2 = vdupq_n_f64(st->d->a[2]);
+  const float64x2_t a3 = vdupq_n_f64(st->d->a[3]), a4 = vdupq_n_f64(st->d->a[4]);
+  const float64x2_t b0 = vdupq_n_f64(st->d->b[0]), b1 = vdupq_n_f64(st->d->b[1]);
+  const float64x2_t b2 = vdupq_n_f64(st->d->b[2]), b3 = vdupq_n_f64(st->d->b[3]);
+  const float64x2_t b4 = vdupq_n_f64(st->d->b[4]);
+  float64x2_t v1 = vsetq_lane_f64(vb[1], vdupq_n_f64(va[1]), 1);
+  float64x2_t v2 = vsetq_lane_f64(vb[2], vdupq_n_f64(va[2]), 1);
+  float64x2_t v3 = vsetq_lane_f64(vb[3], vdupq_n_f64(va[3]), 1);
+  float64x2_t v4 = vsetq_lane_f64(vb[4], vdupq_n_f64(va[4]), 1);
+  float64x2_t energy = vdupq_n_f64(0.0);
+  size_t i;
+  /* separate multiply and add/sub (no vfmaq) to round like the scalar code */
+  for (i = 0; i < frames; ++i) {
+    const double* in = src + i * channels;
+    float64x2_t v0 = vsetq_lane_f64(in[c[1]], vdupq_n_f64(in[c[0]]), 1);
+    v0 = vsubq_f64(v0, vmulq_f64(a1, v1));
+    v0 = vsubq_f64(v0, vmulq_f64(a2, v2));
+    v0 = vsubq_f64(v0, vmulq_f64(a3, v3));
+    v0 = vsubq_f64(v0, vmulq_f64(a4, v4));
+    float64x2_t y = vmulq_f64(b0, v0);
+    y = vaddq_f64(y, vmulq_f64(b1, v1));
+    y = vaddq_f64(y, vmulq_f64(b2, v2));
+    y = vaddq_f64(y, vmulq_f64(b3, v3));
+    y = vaddq_f64(y, vmulq_f64(b4, v4));
+    dest[i * channels + c[0]] = vgetq_lane_f64(y, 0);
+    dest[i * channels + c[1]] = vgetq_lane_f64(y, 1);
+    energy = vaddq_f64(energy, vmulq_f64(y, y));
+    v4 = v3; v3 = v2; v2 = v1; v1 = v0;
+  }
+  va[0] = va[1] = vgetq_lane_f64(v1, 0); vb[0] = vb[1] = vgetq_lane_f64(v1, 1);
+  va[2] = vgetq_lane_f64(v2, 0);         vb[2] = vgetq_lane_f64(v2, 1);
+  va[3] = vgetq_lane_f64(v3, 0);         vb[3] = vgetq_lane_f64(v3, 1);
+  va[4] = vgetq_lane_f64(v4, 0);         vb[4] = vgetq_lane_f64(v4, 1);
+  st->d->subblock_energy_acc[c[0]] += vgetq_lane_f64(energy, 0);
+  st->d->subblock_energy_acc[c[1]] += vgetq_lane_f64(energy, 1);
+}
+#endif
+
+#if defined(EBUR128_FILTER_AVX)
+#define EBUR128_FILTER_GROUP 4
+#else
+#define EBUR128_FILTER_GROUP 2
+#endif
+
+static void ebur128_filter_group(ebur128_state* st, const double* src,
+                                 double* dest, size_t frames,
+                                 const size_t* c, size_t count) {
+  size_t k = 0;
+#if defined(EBUR128_FILTER_AVX)
+  if (count == 4) {
+    ebur128_filter_channels_avx(st, src, dest, frames, c);
+    return;
+  }
+#endif
+#if defined(EBUR128_FILTER_SSE2)
+  for (; k + 2 <= count; k += 2) {
+    ebur128_filter_channels_sse2(st, src, dest, frames, c + k);
+  }
+#elif defined(EBUR128_FILTER_NEON)
+  for (; k + 2 <= count; k += 2) {
+    ebur128_filter_channels_neon(st, src, dest, frames, c + k);
+  }
+#endif
+  for (; k < count; ++k) {
+    ebur128_filter_channel(st, src + c[k], dest + c[k], frames, c[k]);
+  }
+}
+
+/* Filters frames that don't cross a 100ms sub-block boundary. */
+static void ebur128_filter_subblock(ebur128_state* st, const double* src,
+                                    double* dest, size_t frames) {
+  size_t group[EBUR128_FILTER_GROUP];
+  size_t count = 0;
+  size_t c;
+  for (c = 0; c < st->channels; ++c) {
+    if (st->d->channel_map[c] == EBUR128_UNUSED) continue;
+    group[count++] = c;
+    if (count == EBUR128_FILTER_GROUP) {
+      ebur128_filter_group(st, src, dest, frames, group, count);
+      count = 0;
+    }
+  }
+  if (count) {
+    ebur128_filter_group(st, src, dest, frames, group, count);
+  }
+}
+
+/* Filters frames into audio_data starting at frame_index, storing the energy
+ * of every 100ms sub-block that gets completed. */
+static void ebur128_filter_kweighting(ebur128_state* st, const double* src,
+                                      size_t frame_index, size_t frames) {
+  const size_t subblock_frames = st->d->samples_in_100ms;
+  size_t c;
+  while (frames > 0) {
+    size_t offset = frame_index % subblock_frames;
+    size_t n = subblock_frames - offset;
+    if (n > frames) n = frames;
+    ebur128_filter_subblock(st, src,
+                            st->d->audio_data + frame_index * st->channels, n);
+    if (offset + n == subblock_frames) {
+      double* slot = st->d->subblock_energy +
+                     (frame_index / subblock_frames) * st->channels;
+      for (c = 0; c < st->channels; ++c) {
+        slot[c] = st->d->subblock_energy_acc[c];
+        st->d->subblock_energy_acc[c] = 0.0;
+      }
+    }
+    src += n * st->channels;
+    frame_index += n;
+    frames -= n;
+  }
+}
+
 #define EBUR128_FILTER(type, min_scale, max_scale)                             \
 static void ebur128_filter_##type(ebur128_state* st, const type* src,          \
                                   size_t frames) {                             \
   static double scaling_factor = -((double) min_scale) > (double) max_scale ?  \
                                  -((double) min_scale) : (double) max_scale;   \
-  double* audio_data = st->d->audio_data + st->d->audio_data_index;            \
+  size_t frame_index = st->d->audio_data_index / st->channels;                 \
   size_t i, c;                                                                 \
                                                                                \
   TURN_ON_FTZ                                                                  \
@@ -503,29 +830,23 @@ static void ebur128_filter_##type(ebur128_state* st, const type* src,          \
     }                                                                          \
     ebur128_check_true_peak(st, frames);                                       \
   }                                                                            \
-  for (c = 0; c < st->channels; ++c) {                                         \
-    int ci = st->d->channel_map[c] - 1;                                        \
-    if (ci < 0) continue;                                                      \
-    else if (ci > 4) ci = 0; /* dual mono */                                   \
-    for (i = 0; i < frames; ++i) {                                             \
-      st->d->v[ci][0] = (double) (src[i * st->channels + c] / scaling_factor)  \
-                   - st->d->a[1] * st->d->v[ci][1]                             \
-                   - st->d->a[2] * st->d->v[ci][2]                             \
-                   - st->d->a[3] * st->d->v[ci][3]                             \
-                   - st->d->a[4] * st->d->v[ci][4];                            \
-      audio_data[i * st->channels + c] =                                       \
-                     st->d->b[0] * st->d->v[ci][0]                             \
-                   + st->d->b[1] * st->d->v[ci][1]                             \
-                   + st->d->b[2] * st->d->v[ci][2]                             \
-                   + st->d->b[3] * st->d->v[ci][3]                             \
-                   + st->d->b[4] * st->d->v[ci][4];                            \
-      st->d->v[ci][4] = st->d->v[ci][3];                                       \
-      st->d->v[ci][3] = st->d->v[ci][2];                                       \
-      st->d->v[ci][2] = st->d->v[ci][1];                                       \
-      st->d->v[ci][1] = st->d->v[ci][0];                                       \
+  if (sizeof(type) == sizeof(double) && scaling_factor == 1.0) {               \
+    ebur128_filter_kweighting(st, (const double*) src, frame_index, frames);   \
+  } else {                                                                     \
+    /* convert to double in chunks of 100ms */                                 \
+    while (frames > 0) {                                                       \
+      size_t n = frames < st->d->samples_in_100ms ? frames                     \
+                                                  : st->d->samples_in_100ms;   \
+      for (i = 0; i < n * st->channels; ++i) {                                 \
+        st->d->filter_input[i] = (double) (src[i] / scaling_factor);           \
+      }                                                                        \
+      ebur128_filter_kweighting(st, st->d->filter_input, frame_index, n);      \
+      src += n * st->channels;                                                 \
+      frame_index += n;                                                        \
+      frames -= n;                                                             \
     }                                                                          \
-    FLUSH_MANUALLY                                                             \
   }                                                                            \
+  FLUSH_MANUALLY                                                               \
   TURN_OFF_FTZ                                                                 \
 }
 EBUR128_FILTER(short, SHRT_MIN, SHRT_MAX)
@@ -554,33 +875,52 @@ static size_t find_histogram_index(double energy) {
   return index_min;
 }
 
+/* Sum of squared filtered samples of channel c in audio_data, for the frames
+ * [start, start + frames) which must not wrap around. */
+static double ebur128_channel_energy(ebur128_state* st, size_t c,
+                                     size_t start, size_t frames) {
+  const double* audio_data = st->d->audio_data + start * st->channels + c;
+  double channel_sum = 0.0;
+  size_t i;
+  for (i = 0; i < frames; ++i) {
+    channel_sum += audio_data[i * st->channels] *
+                   audio_data[i * st->channels];
+  }
+  return channel_sum;
+}
+
+/* frames_per_block is always a multiple of 100ms. The block is split into
+ * the partially filled current sub-block, the complete sub-blocks before it
+ * (taken from subblock_energy) and the tail of the oldest sub-block, so only
+ * up to 100ms of audio has to be summed per channel instead of the whole
+ * block. */
 static int ebur128_calc_gating_block(ebur128_state* st, size_t frames_per_block,
                                      double* optional_output) {
+  const size_t subblock_frames = st->d->samples_in_100ms;
+  const size_t subblock_count = st->d->subblock_count;
+  const size_t current = st->d->audio_data_index / st->channels;
+  const size_t partial = current % subblock_frames;
+  const size_t current_subblock = current / subblock_frames;
+  const size_t full_subblocks = frames_per_block / subblock_frames -
+                                (partial ? 1 : 0);
   size_t i, c;
   double sum = 0.0;
   double channel_sum;
   for (c = 0; c < st->channels; ++c) {
     if (st->d->channel_map[c] == EBUR128_UNUSED) continue;
     channel_sum = 0.0;
-    if (st->d->audio_data_index < frames_per_block * st->channels) {
-      for (i = 0; i < st->d->audio_data_index / st->channels; ++i) {
-        channel_sum += st->d->audio_data[i * st->channels + c] *
-                       st->d->audio_data[i * st->channels + c];
-      }
-      for (i = st->d->audio_data_frames -
-              (frames_per_block -
-               st->d->audio_data_index / st->channels);
-           i < st->d->audio_data_frames; ++i) {
-        channel_sum += st->d->audio_data[i * st->channels + c] *
-                       st->d->audio_data[i * st->channels + c];
-      }
-    } else {
-      for (i = st->d->audio_data_index / st->channels - frames_per_block;
-           i < st->d->audio_data_index / st->channels;
-           ++i) {
-        channel_sum += st->d->audio_data[i * st->channels + c] *
-                       st->d->audio_data[i * st->channels + c];
-      }
+    for (i = 1; i <= full_subblocks; ++i) {
+      size_t subblock = (current_subblock + subblock_count - i) %
+                        subblock_count;
+      channel_sum += st->d->subblock_energy[subblock * st->channels + c];
+    }
+    if (partial) {
+      size_t oldest = (current_subblock + subblock_count - full_subblocks - 1) %
+                      subblock_count;
+      channel_sum += ebur128_channel_energy(st, c, current - partial, partial);
+      channel_sum += ebur128_channel_energy(st, c,
+                                            oldest * subblock_frames + partial,
+                                            subblock_frames - partial);
     }
     if (st->d->channel_map[c] == EBUR128_LEFT_SURROUND ||
         st->d->channel_map[c] == EBUR128_RIGHT_SURROUND) {
@@ -594,15 +934,16 @@ static int ebur128_calc_gating_block(ebur128_state* st, size_t frames_per_block,
   if (optional_output) {
     *optional_output = sum;
     return EBUR128_SUCCESS;
-  } else if (sum >= histogram_energy_boundaries[0]) {
+  }
+  if (st->d->use_block_log &&
+      ebur128_block_store_append(&st->d->block_log, sum)) {
+    return EBUR128_ERROR_NOMEM;
+  }
+  if (sum >= histogram_energy_boundaries[0]) {
     if (st->d->use_histogram) {
       ++st->d->block_energy_histogram[find_histogram_index(sum)];
     } else {
-      struct ebur128_dq_entry* block;
-      block = (struct ebur128_dq_entry*) malloc(sizeof(struct ebur128_dq_entry));
-      if (!block) return EBUR128_ERROR_NOMEM;
-      block->z = sum;
-      SLIST_INSERT_HEAD(&st->d->block_list, block, entries);
+      return ebur128_block_store_append(&st->d->block_list, sum);
     }
     return EBUR128_SUCCESS;
   } else {
@@ -635,6 +976,7 @@ int ebur128_change_parameters(ebur128_state* st,
   }
   free(st->d->audio_data);
   st->d->audio_data = NULL;
+  ebur128_free_channel_buffers(st);
 
   if (channels != st->channels) {
     unsigned int i;
@@ -671,10 +1013,7 @@ int ebur128_change_parameters(ebur128_state* st,
       st->d->true_peak_frame[i] = 0;
     }
   }
-  if (samplerate != st->samplerate) {
-    st->samplerate = samplerate;
-    ebur128_init_filter(st);
-  }
+  st->samplerate = samplerate;
   if ((st->mode & EBUR128_MODE_S) == EBUR128_MODE_S) {
     st->d->audio_data_frames = st->d->samples_in_100ms * 30;
   } else if ((st->mode & EBUR128_MODE_M) == EBUR128_MODE_M) {
@@ -690,6 +1029,10 @@ int ebur128_change_parameters(ebur128_state* st,
     st->d->audio_data[i] = 0.0;
   }
 
+  errcode = ebur128_init_channel_buffers(st);
+  CHECK_ERROR(errcode, EBUR128_ERROR_NOMEM, exit)
+  ebur128_init_filter(st);
+
   /* the first block needs 400ms of audio data */
   st->d->needed_frames = st->d->samples_in_100ms * 4;
   /* start at the beginning of the buffer */
@@ -724,19 +1067,19 @@ int ebur128_add_frames_##type(ebur128_state* st,                               \
       if ((st->mode & EBUR128_MODE_LRA) == EBUR128_MODE_LRA) {                 \
         st->d->short_term_frame_counter += st->d->needed_frames;               \
         if (st->d->short_term_frame_counter == st->d->samples_in_100ms * 30) { \
-          struct ebur128_dq_entry* block;                                      \
           double st_energy;                                                    \
           ebur128_energy_shortterm(st, &st_energy);                            \
+          if (st->d->use_block_log && ebur128_block_store_append(              \
+                           &st->d->short_term_block_log, st_energy)) {         \
+            return EBUR128_ERROR_NOMEM;                                        \
+          }                                                                    \
           if (st_energy >= histogram_energy_boundaries[0]) {                   \
             if (st->d->use_histogram) {                                        \
               ++st->d->short_term_block_energy_histogram[                      \
                                               find_histogram_index(st_energy)];\
-            } else {                                                           \
-              block = (struct ebur128_dq_entry*)                               \
-                      malloc(sizeof(struct ebur128_dq_entry));                 \
-              if (!block) return EBUR128_ERROR_NOMEM;                          \
-              block->z = st_energy;                                            \
-              SLIST_INSERT_HEAD(&st->d->short_term_block_list, block, entries);\
+            } else if (ebur128_block_store_append(                             \
+                           &st->d->short_term_block_list, st_energy)) {        \
+              return EBUR128_ERROR_NOMEM;                                      \
             }                                                                  \
           }                                                                    \
           st->d->short_term_frame_counter = st->d->samples_in_100ms * 20;      \
@@ -767,7 +1110,6 @@ EBUR128_ADD_FRAMES(double)
 
 static int ebur128_gated_loudness(ebur128_state** sts, size_t size,
                                   double* out) {
-  struct ebur128_dq_entry* it;
   double relative_threshold = 0.0;
   double gated_loudness = 0.0;
   size_t above_thresh_counter = 0;
@@ -788,10 +1130,11 @@ static int ebur128_gated_loudness(ebur128_state** sts, size_t size,
         above_thresh_counter += sts[i]->d->block_energy_histogram[j];
       }
     } else {
-      SLIST_FOREACH(it, &sts[i]->d->block_list, entries) {
-        ++above_thresh_counter;
-        relative_threshold += it->z;
+      const struct ebur128_block_store* blocks = &sts[i]->d->block_list;
+      for (j = 0; j < blocks->size; ++j) {
+        relative_threshold += blocks->z[j];
       }
+      above_thresh_counter += blocks->size;
     }
   }
   if (!above_thresh_counter) {
@@ -818,10 +1161,11 @@ static int ebur128_gated_loudness(ebur128_state** sts, size_t size,
         above_thresh_counter += sts[i]->d->block_energy_histogram[j];
       }
     } else {
-      SLIST_FOREACH(it, &sts[i]->d->block_list, entries) {
-        if (it->z >= relative_threshold) {
+      const struct ebur128_block_store* blocks = &sts[i]->d->block_list;
+      for (j = 0; j < blocks->size; ++j) {
+        if (blocks->z[j] >= relative_threshold) {
           ++above_thresh_counter;
-          gated_loudness += it->z;
+          gated_loudness += blocks->z[j];
         }
       }
     }
@@ -835,6 +1179,44 @@ static int ebur128_gated_loudness(ebur128_state** sts, size_t size,
   return EBUR128_SUCCESS;
 }
 
+int ebur128_loudness_global_blocks(const double* blocks, size_t size,
+                                   double* out) {
+  double relative_threshold = 0.0;
+  double gated_loudness = 0.0;
+  size_t above_thresh_counter = 0;
+  size_t i;
+
+  for (i = 0; i < size; ++i) {
+    if (blocks[i] >= histogram_energy_boundaries[0]) {
+      relative_threshold += blocks[i];
+      ++above_thresh_counter;
+    }
+  }
+  if (!above_thresh_counter) {
+    *out = -HUGE_VAL;
+    return EBUR128_SUCCESS;
+  }
+  relative_threshold /= (double) above_thresh_counter;
+  relative_threshold *= relative_gate_factor;
+  if (relative_threshold < histogram_energy_boundaries[0]) {
+    relative_threshold = histogram_energy_boundaries[0];
+  }
+  above_thresh_counter = 0;
+  for (i = 0; i < size; ++i) {
+    if (blocks[i] >= relative_threshold) {
+      ++above_thresh_counter;
+      gated_loudness += blocks[i];
+    }
+  }
+  if (!above_thresh_counter) {
+    *out = -HUGE_VAL;
+    return EBUR128_SUCCESS;
+  }
+  gated_loudness /= (double) above_thresh_counter;
+  *out = ebur128_energy_to_loudness(gated_loudness);
+  return EBUR128_SUCCESS;
+}
+
 int ebur128_loudness_global(ebur128_state* st, double* out) {
   return ebur128_gated_loudness(&st, 1, out);
 }
@@ -891,15 +1273,47 @@ static int ebur128_double_cmp(const void *p1, const void *p2) {
   return (*d1 > *d2) - (*d1 < *d2);
 }
 
+/* Sorts stl_vector in place, all energies have to be above the absolute gate */
+static double ebur128_range_of_energies(double* stl_vector, size_t stl_size) {
+  size_t i;
+  double* stl_relgated;
+  size_t stl_relgated_size;
+  double stl_power, stl_integrated;
+  /* High and low percentile energy */
+  double h_en, l_en;
+
+  qsort(stl_vector, stl_size, sizeof(double), ebur128_double_cmp);
+  stl_power = 0.0;
+  for (i = 0; i < stl_size; ++i) {
+    stl_power += stl_vector[i];
+  }
+  stl_power /= (double) stl_size;
+  stl_integrated = minus_twenty_decibels * stl_power;
+
+  stl_relgated = stl_vector;
+  stl_relgated_size = stl_size;
+  while (stl_relgated_size > 0 && *stl_relgated < stl_integrated) {
+    ++stl_relgated;
+    --stl_relgated_size;
+  }
+
+  if (stl_relgated_size) {
+    h_en = stl_relgated[(size_t) ((stl_relgated_size - 1) * 0.95 + 0.5)];
+    l_en = stl_relgated[(size_t) ((stl_relgated_size - 1) * 0.1 + 0.5)];
+    return ebur128_energy_to_loudness(h_en) - ebur128_energy_to_loudness(l_en);
+  } else {
+    return 0.0;
+  }
+}
+
 /* EBU - TECH 3342 */
 int ebur128_loudness_range_multiple(ebur128_state** sts, size_t size,
                                     double* out) {
   size_t i, j;
-  struct ebur128_dq_entry* it;
+  struct ebur128_block_store* stl_store = NULL;
+  size_t stl_store_count = 0;
   double* stl_vector;
   size_t stl_size;
-  double* stl_relgated;
-  size_t stl_relgated_size;
   double stl_power, stl_integrated;
   /* High and low percentile energy */
   double h_en, l_en;
@@ -978,57 +1392,76 @@ int ebur128_loudness_range_multiple(ebur128_state** sts, size_t size,
   } else {
     stl_size = 0;
     for (i = 0; i < size; ++i) {
-      if (!sts[i]) continue;
-      SLIST_FOREACH(it, &sts[i]->d->short_term_block_list, entries) {
-        ++stl_size;
-      }
+      if (!sts[i] || !sts[i]->d->short_term_block_list.size) continue;
+      stl_store = &sts[i]->d->short_term_block_list;
+      stl_size += stl_store->size;
+      ++stl_store_count;
     }
     if (!stl_size) {
       *out = 0.0;
       return EBUR128_SUCCESS;
     }
-    stl_vector = (double*) malloc(stl_size * sizeof(double));
-    if (!stl_vector)
-      return EBUR128_ERROR_NOMEM;
-
-    for (j = 0, i = 0; i < size; ++i) {
-      if (!sts[i]) continue;
-      SLIST_FOREACH(it, &sts[i]->d->short_term_block_list, entries) {
-        stl_vector[j] = it->z;
-        ++j;
+    if (stl_store_count == 1) {
+      /* short-term blocks are only used here and their order doesn't matter,
+       * so a single state gets sorted in place */
+      stl_vector = stl_store->z;
+    } else {
+      stl_vector = (double*) malloc(stl_size * sizeof(double));
+      if (!stl_vector)
+        return EBUR128_ERROR_NOMEM;
+
+      for (j = 0, i = 0; i < size; ++i) {
+        if (!sts[i]) continue;
+        stl_store = &sts[i]->d->short_term_block_list;
+        if (stl_store->size) {
+          memcpy(stl_vector + j, stl_store->z,
+                 stl_store->size * sizeof(double));
+          j += stl_store->size;
+        }
       }
     }
-    qsort(stl_vector, stl_size, sizeof(double), ebur128_double_cmp);
-    stl_power = 0.0;
-    for (i = 0; i < stl_size; ++i) {
-      stl_power += stl_vector[i];
-    }
-    stl_power /= (double) stl_size;
-    stl_integrated = minus_twenty_decibels * stl_power;
+    *out = ebur128_range_of_energies(stl_vector, stl_size);
+    if (stl_store_count > 1) free(stl_vector);
+    return EBUR128_SUCCESS;
+  }
+}
 
-    stl_relgated = stl_vector;
-    stl_relgated_size = stl_size;
-    while (stl_relgated_size > 0 && *stl_relgated < stl_integrated) {
-      ++stl_relgated;
-      --stl_relgated_size;
-    }
+int ebur128_loudness_range(ebur128_state* st, double* out) {
+  return ebur128_loudness_range_multiple(&st, 1, out);
+}
 
-    if (stl_relgated_size) {
-      h_en = stl_relgated[(size_t) ((stl_relgated_size - 1) * 0.95 + 0.5)];
-      l_en = stl_relgated[(size_t) ((stl_relgated_size - 1) * 0.1 + 0.5)];
-      free(stl_vector);
-      *out = ebur128_energy_to_loudness(h_en) - ebur128_energy_to_loudness(l_en);
-      return EBUR128_SUCCESS;
-    } else {
-      free(stl_vector);
-      *out = 0.0;
-      return EBUR128_SUCCESS;
+int ebur128_loudness_range_blocks(const double* short_term_blocks, size_t size,
+                                  double* out) {
+  double* stl_vector;
+  size_t i, stl_size = 0;
+
+  stl_vector = (double*) malloc((size ? size : 1) * sizeof(double));
+  if (!stl_vector)
+    return EBUR128_ERROR_NOMEM;
+  for (i = 0; i < size; ++i) {
+    if (short_term_blocks[i] >= histogram_energy_boundaries[0]) {
+      stl_vector[stl_size++] = short_term_blocks[i];
     }
   }
+  *out = stl_size ? ebur128_range_of_energies(stl_vector, stl_size) : 0.0;
+  free(stl_vector);
+  return EBUR128_SUCCESS;
 }
 
-int ebur128_loudness_range(ebur128_state* st, double* out) {
-  return ebur128_loudness_range_multiple(&st, 1, out);
+int ebur128_block_log(ebur128_state* st,
+                      const double** blocks, size_t* blocks_size,
+                      const double** short_term_blocks,
+                      size_t* short_term_blocks_size) {
+  if (!st->d->use_block_log) {
+    return EBUR128_ERROR_INVALID_MODE;
+  }
+  *blocks = st->d->block_log.z;
+  *blocks_size = st->d->block_log.size;
+  if (short_term_blocks) {
+    *short_term_blocks = st->d->short_term_block_log.z;
+    *short_term_blocks_size = st->d->short_term_block_log.size;
+  }
+  return EBUR128_SUCCESS;
 }
 
 int ebur128_sample_peak(ebur128_state* st,
@@ -82,7 +82,9 @@ enum mode {
   EBUR128_MODE_TRUE_PEAK   = (1 << 5) | EBUR128_MODE_M
                                       | EBUR128_MODE_SAMPLE_PEAK,
   /** uses histogram algorithm to calculate loudness */
-  EBUR128_MODE_HISTOGRAM   = (1 << 6)
+  EBUR128_MODE_HISTOGRAM   = (1 << 6),
+  /** can call ebur128_block_log */
+  EBUR128_MODE_BLOCK_LOG   = (1 << 7)
 };
 
 /** forward declaration of ebur128_state_internal */
@@ -264,6 +266,61 @@ int ebur128_loudness_range_multiple(ebur128_state** sts,
                                     size_t size,
                                     double* out);
 
+/** \brief Get energies of all gating and short-term blocks in time order.
+ *
+ *  Unlike the energies used internally, the log also keeps blocks below the
+ *  absolute gate, so block i always starts at i * 100ms (gating blocks) or at
+ *  i * 1s (short-term blocks) after the first added frame. Logs of separate
+ *  runs over the same audio can therefore be spliced together and measured
+ *  with \ref ebur128_loudness_global_blocks and
+ *  \ref ebur128_loudness_range_blocks.
+ *
+ *  @param st library state
+ *  @param blocks gating block energies, valid until next call that adds frames
+ *  @param blocks_size number of gating block energies
+ *  @param short_term_blocks short-term block energies (may be NULL)
+ *  @param short_term_blocks_size number of short-term block energies
+ *  @return
+ *    - EBUR128_SUCCESS on success.
+ *    - EBUR128_ERROR_INVALID_MODE if mode "EBUR128_MODE_BLOCK_LOG" has not
+ *      been set.
+ */
+int ebur128_block_log(ebur128_state* st,
+                      const double** blocks, size_t* blocks_size,
+                      const double** short_term_blocks,
+                      size_t* short_term_blocks_size);
+
+/** \brief Get global integrated loudness in LUFS from logged block energies.
+ *
+ *  Blocks below the absolute gate are skipped. Needs at least one state to be
+ *  initialized beforehand.
+ *
+ *  @param blocks gating block energies as returned by \ref ebur128_block_log
+ *  @param size number of gating block energies
+ *  @param out integrated loudness in LUFS. -HUGE_VAL if result is negative
+ *             infinity.
+ *  @return
+ *    - EBUR128_SUCCESS on success.
+ */
+int ebur128_loudness_global_blocks(const double* blocks, size_t size,
+                                   double* out);
+
+/** \brief Get loudness range (LRA) in LU from logged short-term energies.
+ *
+ *  Blocks below the absolute gate are skipped. Needs at least one state to be
+ *  initialized beforehand.
+ *
+ *  @param short_term_blocks short-term block energies as returned by
+ *                           \ref ebur128_block_log
+ *  @param size number of short-term block energies
+ *  @param out loudness range (LRA) in LU.
+ *  @return
+ *    - EBUR128_SUCCESS on success.
+ *    - EBUR128_ERROR_NOMEM on memory allocation error.
+ */
+int ebur128_loudness_range_blocks(const double* short_term_blocks, size_t size,
+                                  double* out);
+
 /** \brief Get maximum sample peak of selected channel in float format.
  *
  *  @param st library state
@@ -44,7 +44,6 @@
 #include "../SnM/SnM_Project.h" // GetProjectLoadAction, GetGlobalStartupAction
 #include "../SnM/SnM_Util.h" // SNM_NamedCommandLookup, CheckSwsMacroScriptNumCustomId
 #include "../Utility/Base64.h"
-#include "../Utility/ReaScript_Utility.hpp"
 #include "../Zoom.h" // HorizScroll
 
 // #781, peak/RMS
@@ -64,6 +63,7 @@ double DoGetMediaItemMaxPeakAndMaxPeakPos(MediaItem* item, double* maxPeakPosOut
 		memset(&a, 0, sizeof(a));
 		a.iChannels = iChannels;
 		a.dPeakVals = new double[iChannels];
+		NF_GetRMSOptions(NULL, &a.dWindowSize); // peak doesn't need it, but this way all NF_ peak/RMS functions share one analysis
 
 		if (AnalyzeItem(item, &a))
 		{
@@ -93,10 +93,10 @@ double DoGetMediaItemAverageRMS(MediaItem* item) // average RMS of all channels
 	{
 		ANALYZE_PCM a;
 		memset(&a, 0, sizeof(a));
-		a.dWindowSize = 0.0; // non-windowed
+		NF_GetRMSOptions(NULL, &a.dWindowSize); // share analysis with windowed functions, overall RMS is in dAvgRMS
 
 		if (AnalyzeItem(item, &a))
-			return VAL2DB(a.dRMS);
+			return VAL2DB(a.dAvgRMS);
 	}
 	else
 		return -150.0;
@@ -118,19 +118,20 @@ double DoGetMediaItemPeakRMS_NonWindowed(MediaItem* item) // highest RMS of all
 		ANALYZE_PCM a;
 		memset(&a, 0, sizeof(a));
 		a.iChannels = iChannels;
-		a.dRMSs = new double[iChannels];
+		a.dAvgRMSs = new double[iChannels];
+		NF_GetRMSOptions(NULL, &a.dWindowSize); // share analysis with windowed functions, non-windowed RMS is in dAvgRMSs
 
 		if (AnalyzeItem(item, &a))
 		{
 			for (int i = 0; i < iChannels; i++) {
-				curPeakRMS = VAL2DB(a.dRMSs[i]);
+				curPeakRMS = VAL2DB(a.dAvgRMSs[i]);
 				if (maxPeakRMS < curPeakRMS) {
 					maxPeakRMS = curPeakRMS;
 				}
 			}
 		}
 
-		delete[] a.dRMSs;
+		delete[] a.dAvgRMSs;
 		return maxPeakRMS;
 	}
 	else
@@ -262,6 +263,66 @@ bool NF_AnalyzeMediaItemPeakAndRMS(MediaItem* item, double windowSize, void* rea
 	return success;
 }
 
+// Everything in a single pass, cheap metrics are always returned, true peak and loudness on request.
+// Loudness goes through the take loudness analysis (take vol/pan/envelope applied, BR loudness cache)
+// so it's the same as NF_AnalyzeTakeLoudness(), not measured on the raw item samples
+bool NF_AnalyzeMediaItem(MediaItem* item, double windowSize, bool analyzeTruePeak, bool analyzeLoudness, double* peakOut, double* peakPosOut, double* truePeakOut, double* RMSOut, double* peakRMSOut, double* peakRMSPosOut, double* lufsIntegratedOut, double* DCOffsetOut, int* clipCountOut)
+{
+	if (peakOut)           *peakOut = -150.0;
+	if (peakPosOut)        *peakPosOut = -666;
+	if (truePeakOut)       *truePeakOut = -150.0;
+	if (RMSOut)            *RMSOut = -150.0;
+	if (peakRMSOut)        *peakRMSOut = -150.0;
+	if (peakRMSPosOut)     *peakRMSPosOut = -666;
+	if (lufsIntegratedOut) *lufsIntegratedOut = -150.0;
+	if (DCOffsetOut)       *DCOffsetOut = 0.0;
+	if (clipCountOut)      *clipCountOut = 0;
+
+	if (!item) return false;
+	const double samplerate = ((PCM_source*)item)->GetSampleRate();
+	const int iChannels = ((PCM_source*)item)->GetNumChannels();
+	if (!samplerate || !iChannels) return false;
+
+	ANALYZE_PCM a;
+	memset(&a, 0, sizeof(a));
+	a.dWindowSize = windowSize;
+	if (windowSize <= 0.0)
+		NF_GetRMSOptions(NULL, &a.dWindowSize);
+	if (analyzeTruePeak) a.iMetrics |= ANALYZE_TRUEPEAK;
+	a.iChannels = iChannels;
+	a.dDCOffsets = new double[iChannels];
+
+	bool success = AnalyzeItem(item, &a);
+	if (success)
+	{
+		if (peakOut)       *peakOut = VAL2DB(a.dPeakVal);
+		if (peakPosOut)    *peakPosOut = GetPosInItem(a.peakSample, samplerate);
+		if (RMSOut)        *RMSOut = VAL2DB(a.dAvgRMS);
+		if (peakRMSOut)    *peakRMSOut = VAL2DB(a.dRMS);
+		if (peakRMSPosOut) *peakRMSPosOut = GetPosInItem(a.peakRMSsample, samplerate);
+		if (clipCountOut)  *clipCountOut = (int)a.clipCount;
+
+		if (truePeakOut && analyzeTruePeak)
+			*truePeakOut = VAL2DB(a.dTruePeakVal);
+
+		if (DCOffsetOut) // channel with the greatest offset
+			for (int i = 0; i < iChannels; i++)
+				if (fabs(a.dDCOffsets[i]) > fabs(*DCOffsetOut))
+					*DCOffsetOut = a.dDCOffsets[i];
+
+		if (analyzeLoudness)
+		{
+			double lufsIntegrated = -150.0;
+			success = NFDoAnalyzeTakeLoudness_IntegratedOnly(GetActiveTake(item), &lufsIntegrated);
+			if (success && lufsIntegratedOut && lufsIntegrated > -150.0)
+				*lufsIntegratedOut = lufsIntegrated;
+		}
+	}
+
+	delete[] a.dDCOffsets;
+	return success;
+}
+
 void NF_GetSWS_RMSoptions(double* targetOut, double* windowSizeOut)
 {
 	NF_GetRMSOptions(targetOut, windowSizeOut);
@@ -481,14 +542,20 @@ void NF_ScrollHorizontallyByPercentage(int amount)
 // Base64
 bool NF_Base64_Decode(const char* base64_str, char* decodedStrOut, int)
 {
-	Base64 b64; int decodedSize;
-	if (char* decoded = b64.Decode(base64_str, &decodedSize))
+	const int encodedSize = (int)strlen(base64_str);
+	int decodedSize = Base64::DecodedSize(base64_str, encodedSize);
+	if (decodedSize < 0)
+		return false;
+
+	// decode in place, allow null bytes in output
+	if (!realloc_cmd_ptr(&decodedStrOut, &decodedSize, decodedSize))
+		return false;
+	if (Base64::DecodeTo(base64_str, encodedSize, decodedStrOut, decodedSize) < 0)
 	{
-		realloc_cmd_ptr(&decodedStrOut, &decodedSize, decodedSize); // allow null bytes in output
-		memcpy(decodedStrOut, decoded, decodedSize);
-		return true;
+		realloc_cmd_ptr(&decodedStrOut, &decodedSize, 0);
+		return false;
 	}
-	return false;
+	return true;
 }
 
 void NF_Base64_Encode(const char* str, int str_sz, const bool usePadding, char* encodedStrOut, const int encodedStrOut_sz)
@@ -498,9 +565,20 @@ void NF_Base64_Encode(const char* str, int str_sz, const bool usePadding, char*
 		--str_sz; // ignore the null terminator
 	else
 		str_sz = strlen(str);
-	Base64 b64;
-	const char* encoded = b64.Encode(str, str_sz, usePadding);
-	CopyToBuffer(encoded, encodedStrOut, encodedStrOut_sz);
+
+	// encode in place, no intermediate copy
+	int encodedSize = Base64::EncodedSize(str_sz, usePadding);
+	if (encodedSize < 0) // too big
+	{
+		if (encodedStrOut_sz > 0)
+			*encodedStrOut = '\0';
+	}
+	else if (encodedSize < encodedStrOut_sz)
+		encodedStrOut[Base64::EncodeTo(str, str_sz, usePadding, encodedStrOut, encodedSize)] = '\0';
+	else if (realloc_cmd_ptr(&encodedStrOut, &encodedSize, encodedSize)) // no null terminator after that
+		Base64::EncodeTo(str, str_sz, usePadding, encodedStrOut, encodedSize);
+	else if (encodedStrOut_sz > 0)
+		*encodedStrOut = '\0';
 }
 
 void NF_GetThemeDefaultTCPHeights(int* supercollapsedOut, int* smallOut, int* mediumOut, int* fullOut)
@@ -36,6 +36,7 @@ double          NF_GetMediaItemPeakRMS_NonWindowed(MediaItem* item);
 double          NF_GetMediaItemPeakRMS_Windowed(MediaItem* item);
                 // combines all above functions
 bool            NF_AnalyzeMediaItemPeakAndRMS(MediaItem* item, double windowSize, void* reaperarray_peaks, void* reaperarray_peakpositions, void* reaperarray_RMSs, void* reaperarray_RMSpositions);
+bool            NF_AnalyzeMediaItem(MediaItem* item, double windowSize, bool analyzeTruePeak, bool analyzeLoudness, double* peakOut, double* peakPosOut, double* truePeakOut, double* RMSOut, double* peakRMSOut, double* peakRMSPosOut, double* lufsIntegratedOut, double* DCOffsetOut, int* clipCountOut);
 void            NF_GetSWS_RMSoptions(double* targetOut, double* windowSizeOut);
 bool            NF_SetSWS_RMSoptions(double target, double windowSize);
 
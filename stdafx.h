@@ -66,6 +66,8 @@
 #include <list>
 #include <map>
 #include <set>
+#include <unordered_map>
+#include <unordered_set>
 #include <numeric>
 #include <ctime>
 #include <limits>
@@ -534,6 +534,8 @@ public:
 	// This is our only notification of active project tab change, so update everything
 	void SetTrackListChange()
 	{
+		InvalidateGuidIndex();
+		InvalidateFolderIndex();
 		m_bChanged = true;
 		m_bAutoColorTrackAsync = true;
 		AutoColorMarkerRegion(false);
@@ -1115,7 +1117,11 @@ error:
 		IMPAPI(stringToGuid);
 		IMPAPI(TakeFX_GetChainVisible);
 		IMPAPI(TakeFX_GetCount);
+		IMPAPI(TakeFX_GetEnabled);
 		IMPAPI(TakeFX_GetFloatingWindow);
+		IMPAPI(TakeFX_GetFXGUID);
+		IMPAPI(TakeFX_GetNumParams);
+		IMPAPI(TakeFX_GetParam);
 		IMPAPI(TakeFX_GetOffline); // v5.95+
 		IMPAPI(TakeFX_SetOffline); // v5.95+
 		IMPAPI(TakeFX_SetOpen);
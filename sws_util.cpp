@@ -33,6 +33,8 @@
 #include <WDL/sha.h>
 #include <WDL/localize/localize.h>
 
+#include <unordered_map>
+
 // Globals
 double g_d0 = 0.0;
 int  g_i0 = 0;
@@ -383,53 +385,126 @@ void ClearSelected()
 		GetSetMediaTrackInfo(CSurf_TrackFromID(i, false), "I_SELECTED", &iSel);
 }
 
-int GetFolderDepth(MediaTrack* tr, int* iType, MediaTrack** nextTr) // iType: 0=normal, 1=parent, < 0=last in folder
+// Folder hierarchy of the current project, built in one pass and cached until the
+// track list, the track count or the project state changes (see InvalidateFolderIndex())
+struct SWS_FolderNode
 {
-	//static MediaTrack* nextTr = NULL; Let calling fcn keep track so state is reset appropriately
-	static int iLastFolder = 0;
-	int iFolder;
-
-	if (tr == *nextTr)
-	{
-		*nextTr = CSurf_TrackFromID(CSurf_TrackToID(tr, false) + 1, false);
+	MediaTrack* tr;
+	int type;        // I_FOLDERDEPTH
+	int depth;       // -1 for the master
+	int parent;      // Track ID, -1 if none
+	int firstChild;  // Track ID, -1 if none
+	int subtreeEnd;  // Track ID of the last track of the folder, own ID if not a parent
+};
 
-		if (CSurf_TrackToID(tr, false) == 0) // Special case for master
-		{
-			if (iType)
-				*iType = 1;
-			return -1; // Master is at '-1' depth
+static struct
+{
+	ReaProject* project;
+	int stateCount;
+	bool valid;
+	std::vector<SWS_FolderNode> nodes; // By track ID, 0 is the master
+	std::unordered_map<MediaTrack*, int> ids;
+} g_folderIndex;
+
+static void BuildFolderIndex()
+{
+	g_folderIndex.project = EnumProjects(-1, nullptr, 0);
+	g_folderIndex.stateCount = GetProjectStateChangeCount(nullptr);
+	g_folderIndex.valid = true;
+	g_folderIndex.ids.clear();
+
+	const int trackCount = GetNumTracks();
+	std::vector<SWS_FolderNode>& nodes = g_folderIndex.nodes;
+	nodes.resize(trackCount + 1);
+	SWS_FolderNode master = { CSurf_TrackFromID(0, false), 1, -1, -1, trackCount ? 1 : -1, trackCount };
+	nodes[0] = master;
+	g_folderIndex.ids[master.tr] = 0;
+
+	std::vector<int> parents;
+	int depth = 0;
+	for (int id = 1; id <= trackCount; ++id) {
+		SWS_FolderNode& node = nodes[id];
+		node.tr = CSurf_TrackFromID(id, false);
+		node.type = *static_cast<int*>(GetSetMediaTrackInfo(node.tr, "I_FOLDERDEPTH", nullptr));
+		node.depth = depth; // Parents are at the "previous" level
+		node.parent = parents.empty() ? -1 : parents.back();
+		node.firstChild = -1;
+		node.subtreeEnd = id;
+		if (node.parent >= 0 && nodes[node.parent].firstChild < 0)
+			nodes[node.parent].firstChild = id;
+		g_folderIndex.ids[node.tr] = id;
+
+		depth += node.type;
+		if (node.type > 0)
+			parents.push_back(id);
+		for (int i = node.type; i < 0 && !parents.empty(); ++i) {
+			nodes[parents.back()].subtreeEnd = id;
+			parents.pop_back();
 		}
+	}
+	for (const int parent : parents)
+		nodes[parent].subtreeEnd = trackCount;
+}
 
-		iFolder = *(int*)GetSetMediaTrackInfo(tr, "I_FOLDERDEPTH", NULL);
-			
-		if (iType)
-			*iType = iFolder;
+static bool IsFolderIndexFresh()
+{
+	return g_folderIndex.valid &&
+		g_folderIndex.project == EnumProjects(-1, nullptr, 0) &&
+		(int)g_folderIndex.nodes.size() == GetNumTracks() + 1 &&
+		g_folderIndex.stateCount == GetProjectStateChangeCount(nullptr);
+}
 
-		if (iFolder == 0)
-			return iLastFolder;
-		else if (iFolder == 1)
-		{
-			iLastFolder++;
-			return iLastFolder - 1; // Count parent as at the "previous" level
-		}
-		else if (iFolder < 0)
-		{
-			int iCur = iLastFolder;
-			iLastFolder += iFolder;
-			return iCur;
-		}
+// Returns NULL if tr isn't in the current project
+static const SWS_FolderNode* GetFolderNode(MediaTrack* tr)
+{
+	bool built = false;
+	if (!IsFolderIndexFresh()) {
+		BuildFolderIndex();
+		built = true;
 	}
-	else
-	{
-		// Must iterate until reaching the track passed in
-		iLastFolder = 0;
-		*nextTr = CSurf_TrackFromID(0, false);
-		while (tr != *nextTr)
-			GetFolderDepth(*nextTr, NULL, nextTr);
 
-		return GetFolderDepth(tr, iType, nextTr);
-	}
-	return -1;
+	auto it = g_folderIndex.ids.find(tr);
+	if (it == g_folderIndex.ids.end())
+		return nullptr;
+
+	// Cheap check for a folder change not notified yet
+	if (built || !it->second || g_folderIndex.nodes[it->second].type == *static_cast<int*>(GetSetMediaTrackInfo(tr, "I_FOLDERDEPTH", nullptr)))
+		return &g_folderIndex.nodes[it->second];
+
+	BuildFolderIndex();
+	it = g_folderIndex.ids.find(tr);
+	return it != g_folderIndex.ids.end() ? &g_folderIndex.nodes[it->second] : nullptr;
+}
+
+void InvalidateFolderIndex()
+{
+	g_folderIndex.valid = false;
+}
+
+int GetFolderDepth(MediaTrack* tr, int* iType) // iType: 0=normal, 1=parent, < 0=last in folder
+{
+	const SWS_FolderNode* node = GetFolderNode(tr);
+	if (iType)
+		*iType = node ? node->type : 0;
+	return node ? node->depth : 0; // Master is at '-1' depth
+}
+
+MediaTrack* GetFolderParent(MediaTrack* tr)
+{
+	const SWS_FolderNode* node = GetFolderNode(tr);
+	return node && node->parent >= 0 ? g_folderIndex.nodes[node->parent].tr : nullptr;
+}
+
+MediaTrack* GetFolderFirstChild(MediaTrack* tr)
+{
+	const SWS_FolderNode* node = GetFolderNode(tr);
+	return node && node->firstChild >= 0 ? g_folderIndex.nodes[node->firstChild].tr : nullptr;
+}
+
+int GetFolderSubtreeEnd(MediaTrack* tr)
+{
+	const SWS_FolderNode* node = GetFolderNode(tr);
+	return node ? node->subtreeEnd : -1;
 }
 
 int GetTrackVis(MediaTrack* tr) // &1 == mcp, &2 == tcp
@@ -488,23 +563,196 @@ const GUID* TrackToGuid(ReaProject* proj, MediaTrack* tr)
 }
 
 
+// GUID -> track/item/take index, per project, built lazily and dropped on track
+// list changes (including project tab switches). Hits are always validated, misses
+// trigger a rebuild since chunk writes can change GUIDs, but at most once per
+// project state change: repeated misses (e.g. a deleted item) don't rescan.
+struct SWS_GuidHash
+{
+	size_t operator()(const GUID& g) const
+	{
+		unsigned long long a, b;
+		memcpy(&a, &g, sizeof(a));
+		memcpy(&b, reinterpret_cast<const char*>(&g) + sizeof(a), sizeof(b));
+		return static_cast<size_t>(a ^ (b * 0x9E3779B97F4A7C15ULL));
+	}
+};
+
+struct SWS_GuidEqual
+{
+	bool operator()(const GUID& g1, const GUID& g2) const { return !memcmp(&g1, &g2, sizeof(GUID)); }
+};
+
+struct SWS_GuidIndex
+{
+	ReaProject* project;
+	int trackCount; // < 0: not built
+	int itemCount;  // < 0: not built
+	int trackMissState; // project state change count when a rebuild last missed, -1: none
+	int itemMissState;  // same, for items and takes
+	std::unordered_map<GUID, MediaTrack*, SWS_GuidHash, SWS_GuidEqual> tracks;
+	std::unordered_map<GUID, MediaItem*, SWS_GuidHash, SWS_GuidEqual> items;
+	std::unordered_map<GUID, MediaItem_Take*, SWS_GuidHash, SWS_GuidEqual> takes;
+};
+
+static WDL_PtrList_DeleteOnDestroy<SWS_GuidIndex> g_guidIndexes;
+static SWS_Mutex g_guidIndexMutex;
+
+static SWS_GuidIndex* GetGuidIndex(ReaProject* project)
+{
+	if (!project)
+		project = EnumProjects(-1, nullptr, 0);
+
+	for (int i = 0; i < g_guidIndexes.GetSize(); ++i) {
+		if (g_guidIndexes.Get(i)->project == project)
+			return g_guidIndexes.Get(i);
+	}
+
+	SWS_GuidIndex* index = new SWS_GuidIndex;
+	index->project = project;
+	index->trackCount = index->itemCount = -1;
+	index->trackMissState = index->itemMissState = -1;
+	return g_guidIndexes.Add(index);
+}
+
+static void BuildTrackGuidIndex(SWS_GuidIndex* index)
+{
+	index->tracks.clear();
+	index->trackCount = CountTracks(index->project);
+	for (int i = 0; i < index->trackCount; ++i) {
+		if (MediaTrack* tr = GetTrack(index->project, i))
+			index->tracks[*static_cast<GUID*>(GetSetMediaTrackInfo(tr, "GUID", nullptr))] = tr;
+	}
+}
+
+static void BuildItemGuidIndex(SWS_GuidIndex* index)
+{
+	index->items.clear();
+	index->takes.clear();
+	index->itemCount = 0;
+	const int trackCount = CountTracks(index->project);
+	for (int i = 0; i < trackCount; ++i) {
+		MediaTrack* tr = GetTrack(index->project, i);
+		const int itemCount = tr ? GetTrackNumMediaItems(tr) : 0;
+		for (int j = 0; j < itemCount; ++j) {
+			MediaItem* item = GetTrackMediaItem(tr, j);
+			index->items[*static_cast<GUID*>(GetSetMediaItemInfo(item, "GUID", nullptr))] = item;
+			const int takeCount = GetMediaItemNumTakes(item);
+			for (int k = 0; k < takeCount; ++k) {
+				if (MediaItem_Take* take = GetMediaItemTake(item, k))
+					index->takes[*static_cast<GUID*>(GetSetMediaItemTakeInfo(take, "GUID", nullptr))] = take;
+			}
+		}
+		index->itemCount += itemCount;
+	}
+}
+
+void InvalidateGuidIndex()
+{
+	SWS_SectionLock lock(&g_guidIndexMutex);
+	g_guidIndexes.Empty(true);
+}
+
 MediaTrack* GuidToTrack(ReaProject* project, const GUID* guid)
 {
 	if (!guid)
 		return nullptr;
 
-	MediaTrack* master = GetMasterTrack(project);
-	if (master && TrackMatchesGuid(project, master, guid))
-		return master;
+	if (GuidsEqual(guid, &GUID_NULL))
+		return GetMasterTrack(project);
 
-	const int trackCount = CountTracks(project);
-	for (int i = 0; i < trackCount; ++i) {
-		MediaTrack* tr = GetTrack(project, i);
-		if (tr && TrackMatchesGuid(project, tr, guid))
-			return tr;
+	SWS_SectionLock lock(&g_guidIndexMutex);
+	SWS_GuidIndex* index = GetGuidIndex(project);
+	bool built = false;
+	if (index->trackCount < 0) {
+		BuildTrackGuidIndex(index);
+		built = true;
 	}
 
-	return nullptr;
+	for (;;) {
+		const auto it = index->tracks.find(*guid);
+		if (it != index->tracks.end()) {
+			if (ValidatePtr2(index->project, it->second, "MediaTrack*") &&
+				GuidsEqual(static_cast<GUID*>(GetSetMediaTrackInfo(it->second, "GUID", nullptr)), guid))
+				return it->second;
+		}
+
+		// A GUID can change without a track list change (chunk writes), rescan before
+		// giving up unless that was already done for the current project state
+		const int stateCount = GetProjectStateChangeCount(index->project);
+		if (built || index->trackMissState == stateCount) {
+			index->trackMissState = stateCount;
+			return nullptr;
+		}
+		BuildTrackGuidIndex(index);
+		built = true;
+	}
+}
+
+MediaItem* GuidToMediaItem(ReaProject* project, const GUID* guid)
+{
+	if (!guid)
+		return nullptr;
+
+	SWS_SectionLock lock(&g_guidIndexMutex);
+	SWS_GuidIndex* index = GetGuidIndex(project);
+	bool built = false;
+	if (index->itemCount < 0) {
+		BuildItemGuidIndex(index);
+		built = true;
+	}
+
+	for (;;) {
+		const auto it = index->items.find(*guid);
+		if (it != index->items.end()) {
+			if (ValidatePtr2(index->project, it->second, "MediaItem*") &&
+				GuidsEqual(static_cast<GUID*>(GetSetMediaItemInfo(it->second, "GUID", nullptr)), guid))
+				return it->second;
+		}
+
+		// A GUID can change without a track list change (chunk writes), rescan before
+		// giving up unless that was already done for the current project state
+		const int stateCount = GetProjectStateChangeCount(index->project);
+		if (built || index->itemMissState == stateCount) {
+			index->itemMissState = stateCount;
+			return nullptr;
+		}
+		BuildItemGuidIndex(index);
+		built = true;
+	}
+}
+
+MediaItem_Take* GuidToTake(ReaProject* project, const GUID* guid)
+{
+	if (!guid)
+		return nullptr;
+
+	SWS_SectionLock lock(&g_guidIndexMutex);
+	SWS_GuidIndex* index = GetGuidIndex(project);
+	bool built = false;
+	if (index->itemCount < 0) {
+		BuildItemGuidIndex(index);
+		built = true;
+	}
+
+	for (;;) {
+		const auto it = index->takes.find(*guid);
+		if (it != index->takes.end()) {
+			if (ValidatePtr2(index->project, it->second, "MediaItem_Take*") &&
+				GuidsEqual(static_cast<GUID*>(GetSetMediaItemTakeInfo(it->second, "GUID", nullptr)), guid))
+				return it->second;
+		}
+
+		// A GUID can change without a track list change (chunk writes), rescan before
+		// giving up unless that was already done for the current project state
+		const int stateCount = GetProjectStateChangeCount(index->project);
+		if (built || index->itemMissState == stateCount) {
+			index->itemMissState = stateCount;
+			return nullptr;
+		}
+		BuildItemGuidIndex(index);
+		built = true;
+	}
 }
 
 bool GuidsEqual(const GUID* g1, const GUID* g2)
@@ -230,7 +230,11 @@ int NumSelTracks();
 void SaveSelected();
 void RestoreSelected();
 void ClearSelected();
-int GetFolderDepth(MediaTrack* tr, int* iType, MediaTrack** nextTr);
+int GetFolderDepth(MediaTrack* tr, int* iType = NULL); // iType: 0=normal, 1=parent, < 0=last in folder
+MediaTrack* GetFolderParent(MediaTrack* tr);
+MediaTrack* GetFolderFirstChild(MediaTrack* tr);
+int GetFolderSubtreeEnd(MediaTrack* tr); // Track ID of the last track of tr's folder, tr's ID if not a parent
+void InvalidateFolderIndex(); // on track list or folder changes
 int GetTrackVis(MediaTrack* tr); // &1 == mcp, &2 == tcp
 void SetTrackVis(MediaTrack* tr, int vis); // &1 == mcp, &2 == tcp
 int AboutBoxInit(); // Not worth its own .h
@@ -241,6 +245,9 @@ const GUID* TrackToGuid(ReaProject*, MediaTrack*);
 inline const GUID* TrackToGuid(MediaTrack* tr) { return TrackToGuid(nullptr, tr); }
 MediaTrack* GuidToTrack(ReaProject*, const GUID*);
 inline MediaTrack* GuidToTrack(const GUID* guid) { return GuidToTrack(nullptr, guid); }
+MediaItem* GuidToMediaItem(ReaProject*, const GUID*);
+MediaItem_Take* GuidToTake(ReaProject*, const GUID*);
+void InvalidateGuidIndex(); // on track list changes
 bool GuidsEqual(const GUID* g1, const GUID* g2);
 bool TrackMatchesGuid(ReaProject*, MediaTrack*, const GUID*);
 inline bool TrackMatchesGuid(MediaTrack* tr, const GUID* g) { return TrackMatchesGuid(nullptr, tr, g); }
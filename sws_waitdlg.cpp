@@ -28,6 +28,8 @@
 // Display a progress bar with dProgress from 0.0 - 1.0.
 // The box closes and the constructor returns when dProgress >= 1.0.
 // ESC closes the box as well, but it blocks until dProgress >= 1.0.
+// If bCancel is given, closing the box sets it so the work (on other threads) can bail out early
+// (it still has to set dProgress to 1.0 when done).
 // You'll want to start a thread to do the work that updates dProgress.
 
 // Note, on Win7 the progress bar update is filtered (why??) such that
@@ -42,10 +44,11 @@
 
 const char SWS_WAITDLG_WNDPOS_KEY[] = "Wait Dialog Position";
 
-SWS_WaitDlg::SWS_WaitDlg(const char* cTitle, double* dProgress, HWND hParent)
+SWS_WaitDlg::SWS_WaitDlg(const char* cTitle, double* dProgress, HWND hParent, std::atomic<bool>* bCancel)
 {
 	m_hwnd = NULL;
 	m_dProgress = dProgress;
+	m_bCancel = bCancel;
 	m_cTitle = cTitle;
 	double dPrevProgress = *dProgress;
 	Sleep(0);
@@ -97,6 +100,8 @@ int SWS_WaitDlg::waitDlgWndProc(UINT uMsg, WPARAM wParam, LPARAM lParam)
 			{
 				case IDOK:
 				case IDCANCEL:
+					if (m_bCancel && *m_dProgress < 1.0) // closed by user
+						*m_bCancel = true;
 					SaveWindowPos(m_hwnd, SWS_WAITDLG_WNDPOS_KEY);
 					KillTimer(m_hwnd, 1);
 					EndDialog(m_hwnd, 0);
@@ -27,15 +27,18 @@
 
 #pragma once
 
+#include <atomic>
+
 class SWS_WaitDlg
 {
 public:
-	SWS_WaitDlg(const char* cTitle, double* dProgress, HWND hParent = NULL);
+	SWS_WaitDlg(const char* cTitle, double* dProgress, HWND hParent = NULL, std::atomic<bool>* bCancel = NULL);
 	~SWS_WaitDlg() {}
 private:
 	static INT_PTR WINAPI sWaitDlgWndProc(HWND hwndDlg, UINT uMsg, WPARAM wParam, LPARAM lParam); // static
 	int waitDlgWndProc(UINT uMsg, WPARAM wParam, LPARAM lParam);
 	const char* m_cTitle;
 	double* m_dProgress;
+	std::atomic<bool>* m_bCancel;
 	HWND m_hwnd;
 };
@@ -43,6 +43,8 @@
 #include "./Breeder/BR_Util.h"
 
 #include <WDL/localize/localize.h>
+
+#include <atomic>
 #ifndef _WIN32
 #  include <WDL/swell/swell-dlggen.h>
 #endif
@@ -713,6 +715,7 @@ void SWS_SetDockWndState(const char* _stateBuf, int _len, SWS_DockWnd_State* _st
 SWS_ListView::SWS_ListView(HWND hwndList, HWND hwndEdit, int iCols, SWS_LVColumn* pCols, const char* cINIKey, bool bTooltips, const char* cLocalizeSection, bool bDrawArrow)
 :m_hwndList(hwndList), m_hwndEdit(hwndEdit), m_hwndTooltip(NULL), m_iSortCol(1), m_iEditingItem(-1), m_iEditingCol(-1),
   m_iCols(iCols), m_pCols(NULL), m_pDefaultCols(NULL), m_bDisableUpdates(false), m_cINIKey(cINIKey), m_cLocalizeSection(cLocalizeSection),m_bDrawArrow(bDrawArrow),
+  m_bVirtual((GetWindowLongPtr(hwndList, GWL_STYLE) & LVS_OWNERDATA) != 0), m_bCustomSort(false),
 #ifndef _WIN32
   m_pClickedItem(NULL)
 #else
@@ -817,6 +820,12 @@ SWS_ListItem* SWS_ListView::GetListItem(int index, int* iState)
 {
 	if (index < 0)
 		return NULL;
+	if (m_bVirtual)
+	{
+		if (iState)
+			*iState = ListView_GetItemState(m_hwndList, index, LVIS_SELECTED | LVIS_FOCUSED);
+		return m_vItems.Get(index);
+	}
 	LVITEM li;
 	li.mask = LVIF_PARAM | (iState ? LVIF_STATE : 0);
 	li.stateMask = LVIS_SELECTED | LVIS_FOCUSED;
@@ -843,23 +852,16 @@ SWS_ListItem* SWS_ListView::EnumSelected(int* i, int iOffset)
 	int temp = 0;
 	if (!i)
 		i = &temp;
-	LVITEM li;
-	li.mask = LVIF_PARAM | LVIF_STATE;
-	li.stateMask = LVIS_SELECTED;
-	li.iSubItem = 0;
 
 	while (*i < ListView_GetItemCount(m_hwndList))
 	{
-		li.iItem = (*i)++;
-		ListView_GetItem(m_hwndList, &li);
-		if (li.state)
+		int iState;
+		SWS_ListItem* item = GetListItem((*i)++, &iState);
+		if (iState & LVIS_SELECTED)
 		{
 			if ((iOffset != 0) && (((*i - 1) + iOffset) >= 0) && (((*i - 1) + iOffset) < ListView_GetItemCount(m_hwndList)))  //sanitizing
-			{
-				li.iItem += iOffset;  //this allows the selection of another item besides the one clicked.
-				ListView_GetItem(m_hwndList, &li);
-			}
-			return (SWS_ListItem*)li.lParam;
+				item = GetListItem(*i - 1 + iOffset);  //this allows the selection of another item besides the one clicked.
+			return item;
 		}
 	}
 	return NULL;
@@ -1061,6 +1063,48 @@ int SWS_ListView::OnNotify(WPARAM wParam, LPARAM lParam)
 		EditListItemEnd(true);
 		OnBeginDrag(GetListItem(s->iItem));
 	}
+#ifdef _WIN32
+	// Virtual lists notify selection changes of several items at once
+	else if (m_bVirtual && !m_bDisableUpdates && s->hdr.code == LVN_ODSTATECHANGED)
+	{
+		NMLVODSTATECHANGE* os = (NMLVODSTATECHANGE*)lParam;
+		if ((os->uNewState ^ os->uOldState) & LVIS_SELECTED)
+			for (int i = os->iFrom; i <= os->iTo; i++)
+				OnItemSelChanged(GetListItem(i), os->uNewState);
+	}
+	else if (m_bVirtual && !m_bDisableUpdates && s->hdr.code == LVN_ITEMCHANGED && s->iItem < 0)
+	{
+		if (s->uChanged & LVIF_STATE && (s->uNewState ^ s->uOldState) & LVIS_SELECTED)
+			for (int i = 0; i < m_vItems.GetSize(); i++)
+				OnItemSelChanged(m_vItems.Get(i), s->uNewState);
+	}
+	else if (m_bVirtual && (s->hdr.code == LVN_GETDISPINFO || s->hdr.code == LVN_GETDISPINFOW))
+#else
+	else if (m_bVirtual && s->hdr.code == LVN_GETDISPINFO)
+#endif
+	{
+		NMLVDISPINFO* di = (NMLVDISPINFO*)lParam;
+		SWS_ListItem* item = m_vItems.Get(di->item.iItem);
+		if (item && (di->item.mask & LVIF_PARAM))
+			di->item.lParam = (LPARAM)item;
+		if (item && (di->item.mask & LVIF_TEXT) && di->item.pszText && di->item.cchTextMax > 0)
+		{
+			char str[CELL_MAX_LEN]="";
+			GetItemText(item, DisplayToDataCol(di->item.iSubItem), str, sizeof(str));
+#ifdef _WIN32
+			// unicode list views (see constructor) ask for wide strings
+			if (s->hdr.code == LVN_GETDISPINFOW)
+			{
+				LPWSTR wstr = (LPWSTR)di->item.pszText;
+				if (!MultiByteToWideChar(CP_UTF8, 0, str, -1, wstr, di->item.cchTextMax))
+					wstr[0] = 0;
+				wstr[di->item.cchTextMax - 1] = 0;
+			}
+			else
+#endif
+				lstrcpyn(di->item.pszText, str, di->item.cchTextMax);
+		}
+	}
 	return 0;
 }
 
@@ -1180,7 +1224,7 @@ void SWS_ListView::Update(const bool reassign)
 
 		char str[CELL_MAX_LEN]="";
 
-		bool bResort = false;
+		bool bResort = reassign;
 		static int iLastSortCol = -999;
 		if (m_iSortCol != iLastSortCol)
 		{
@@ -1188,16 +1232,38 @@ void SWS_ListView::Update(const bool reassign)
 			bResort = true;
 		}
 
+		// Resort on new rows or text changes in the sort column only, unless sorted with
+		// OnItemSort() (might not depend on texts) or the sort column is hidden
+		const int iSortCol = abs(m_iSortCol) - 1;
+		const bool bResortOnUpdate = m_bCustomSort || iSortCol < 0 || iSortCol >= m_iCols || m_pCols[iSortCol].iPos == -1;
+
+		if (m_bVirtual)
+		{
+			UpdateVirtual(bResort);
+			SendMessage(m_hwndList, WM_SETREDRAW, 1, 0);
+			InvalidateRect(m_hwndList, NULL, FALSE);
+			m_bDisableUpdates = false;
+			return;
+		}
+
 		SWS_ListItemList items;
 		GetItemList(&items);
 
 		if (!items.GetSize())
+		{
 			ListView_DeleteAllItems(m_hwndList);
+			m_rowStates.clear();
+		}
+
+		// Match listview items to the item list with a hashed lookup,
+		// items of the list that are not flagged as used at the end are new
+		std::vector<bool> used(items.GetSize(), false);
+		int iNextNew = 0;
+		bool bChanged = false, bUpdated = false;
 
-		// The list is sorted, use that to our advantage here:
 		int lvItemCount = ListView_GetItemCount(m_hwndList);
 		int newIndex = lvItemCount;
-		for (int i = 0; items.GetSize() || i < lvItemCount; i++)
+		for (int i = 0; ; i++)
 		{
 			bool bFound = false;
 			SWS_ListItem* pItem;
@@ -1205,29 +1271,39 @@ void SWS_ListView::Update(const bool reassign)
 			{	// First check items in the listview, match to item list
 				pItem = GetListItem(i);
 				int iIndex = items.Find(pItem);
-				if (iIndex == -1)
+				if (iIndex == -1 || used[iIndex])
 				{
 					// Delete items from listview that aren't in the item list
+					if (iIndex == -1)
+						m_rowStates.erase(pItem);
 					ListView_DeleteItem(m_hwndList, i);
 					i--;
 					lvItemCount--;
 					newIndex--;
+					bChanged = true;
 					continue;
 				}
 				else
 				{
-					// Delete item from item list to indicate "used"
-					items.Delete(iIndex);
+					// Flag item as "used"
+					used[iIndex] = true;
 					bFound = true;
 				}
 			}
 			else
 			{	// Items left in the item list are new
-				pItem = items.Remove();
+				while (iNextNew < items.GetSize() && used[iNextNew])
+					iNextNew++;
+				if (iNextNew >= items.GetSize())
+					break;
+				used[iNextNew] = true;
+				pItem = items.Get(iNextNew);
 			}
 
 			// We have an item pointer, and a listview index, add/edit the listview
-			// Update the list, no matter what, because text may have changed
+			// Update the text of new and dirty items (i.e. all existing items by default)
+			// note: IsItemDirty() is called for new items too, overrides can record their state
+			const bool bDirty = IsItemDirty(pItem) || !bFound;
 			LVITEM item;
 			item.mask = 0;
 			int iNewState = GetItemState(pItem);
@@ -1250,6 +1326,7 @@ void SWS_ListView::Update(const bool reassign)
 
 			item.iItem = bFound ? i : newIndex++;
 			item.pszText = str;
+			str[0] = 0;
 
 			if (reassign) {
 				// update list view item/internal data item association
@@ -1263,7 +1340,8 @@ void SWS_ListView::Update(const bool reassign)
 				if (m_pCols[k].iPos != -1)
 				{
 					item.iSubItem = iCol;
-					GetItemText(pItem, k, str, sizeof(str));
+					if (bDirty)
+						GetItemText(pItem, k, str, sizeof(str));
 					if (!bFound)
 					{
 						item.mask |= LVIF_TEXT;
@@ -1278,16 +1356,21 @@ void SWS_ListView::Update(const bool reassign)
 					}
 					else
 					{
-						char curStr[CELL_MAX_LEN]="";
-						ListView_GetItemText(m_hwndList, item.iItem, iCol, curStr, sizeof(curStr));
-						if (strcmp(str, curStr))
-							item.mask |= LVIF_TEXT;
+						if (bDirty)
+						{
+							char curStr[CELL_MAX_LEN]="";
+							ListView_GetItemText(m_hwndList, item.iItem, iCol, curStr, sizeof(curStr));
+							if (strcmp(str, curStr))
+								item.mask |= LVIF_TEXT;
+						}
 						if (item.mask)
 						{
 							// Only set if there's changes
 							// May be less efficient here, but less messages get sent for sure!
 							ListView_SetItem(m_hwndList, &item);
-							bResort = true;
+							if (k == iSortCol && (item.mask & LVIF_TEXT))
+								bResort = true;
+							bUpdated = true;
 						}
 					}
 					item.mask = 0;
@@ -1295,11 +1378,17 @@ void SWS_ListView::Update(const bool reassign)
 				}
 		}
 
-		if (bResort)
+		if (bResort || (bUpdated && bResortOnUpdate))
+		{
 			Sort();
+			bChanged = true;
+		}
+		else if (bUpdated)
+			bChanged = true;
 
 #ifdef _WIN32
-		if (m_hwndTooltip)
+		// Tooltips are per row: only rebuild them when rows have changed
+		if (m_hwndTooltip && bChanged)
 		{
 			TOOLINFO ti = { sizeof(TOOLINFO), };
 			ti.lpszText = str;
@@ -1333,6 +1422,95 @@ void SWS_ListView::Update(const bool reassign)
 	}
 }
 
+bool SWS_ListView::IsRowStateChanged(SWS_ListItem* item, const WDL_INT64* state, int iSize)
+{
+	WDL_UINT64 h = 0xCBF29CE484222325ULL; // FNV-1a
+	const unsigned char* p = (const unsigned char*)state;
+	for (int i = 0; i < iSize * (int)sizeof(WDL_INT64); i++)
+		h = (h ^ p[i]) * 0x100000001B3ULL;
+
+	std::unordered_map<SWS_ListItem*, WDL_UINT64>::iterator it = m_rowStates.find(item);
+	if (it != m_rowStates.end() && it->second == h)
+		return false;
+	m_rowStates[item] = h;
+	return true;
+}
+
+int SWS_ListView::NewItemRevision()
+{
+	static std::atomic<int> s_iRevision(0);
+	return ++s_iRevision;
+}
+
+// Virtual lists: no text is stored in the control, only rows (m_vItems) and selection states
+void SWS_ListView::UpdateVirtual(bool bResort)
+{
+	SWS_ListItemList items;
+	GetItemList(&items);
+
+	// Rows have changed? (selection states of virtual lists are stored by index)
+	bool bChanged = ListView_GetItemCount(m_hwndList) != m_vItems.GetSize() || items.GetSize() != m_vItems.GetSize();
+	for (int i = 0; !bChanged && i < m_vItems.GetSize(); i++)
+		if (items.Find(m_vItems.Get(i)) < 0)
+			bChanged = true;
+
+	if (bChanged)
+	{
+		std::unordered_set<SWS_ListItem*> sel;
+		GetSelectedItems(&sel);
+		m_vItems.Empty();
+		for (int i = 0; i < items.GetSize(); i++)
+			m_vItems.Add(items.Get(i));
+#ifdef _WIN32
+		ListView_SetItemCountEx(m_hwndList, m_vItems.GetSize(), LVSICF_NOSCROLL);
+#else
+		ListView_SetItemCount(m_hwndList, m_vItems.GetSize());
+#endif
+		SetSelectedItems(sel);
+	}
+
+	// Texts are not stored in the control: resort on new/removed rows or sort changes only,
+	// views whose rows can be modified in place opt in with ResortOnUpdate()
+	if (bChanged || bResort || ResortOnUpdate())
+		Sort();
+
+	// Selection states from the derived class
+	for (int i = 0; i < m_vItems.GetSize(); i++)
+	{
+		int iNewState = GetItemState(m_vItems.Get(i));
+		if (iNewState >= 0)
+		{
+			int iCurState = ListView_GetItemState(m_hwndList, i, LVIS_SELECTED | LVIS_FOCUSED);
+			if (iNewState && !(iCurState & LVIS_SELECTED))
+				ListView_SetItemState(m_hwndList, i, LVIS_SELECTED, LVIS_SELECTED);
+			else if (!iNewState && (iCurState & LVIS_SELECTED))
+				ListView_SetItemState(m_hwndList, i, 0, LVIS_SELECTED | ((iCurState & LVIS_FOCUSED) ? LVIS_FOCUSED : 0));
+		}
+	}
+}
+
+void SWS_ListView::GetSelectedItems(std::unordered_set<SWS_ListItem*>* pSel)
+{
+	pSel->clear();
+	int x = 0;
+	while (SWS_ListItem* item = EnumSelected(&x))
+		pSel->insert(item);
+}
+
+// Restores a selection, the derived class is not notified (the items' selection states are unchanged)
+void SWS_ListView::SetSelectedItems(const std::unordered_set<SWS_ListItem*>& sel)
+{
+	bool bSaveDisableUpdates = m_bDisableUpdates;
+	m_bDisableUpdates = true;
+	for (int i = 0; i < GetListItemCount(); i++)
+	{
+		bool bSel = sel.find(GetListItem(i)) != sel.end();
+		if (bSel != IsSelected(i))
+			ListView_SetItemState(m_hwndList, i, bSel ? LVIS_SELECTED : 0, LVIS_SELECTED);
+	}
+	m_bDisableUpdates = bSaveDisableUpdates;
+}
+
 // Return TRUE if a the column header was clicked
 bool SWS_ListView::DoColumnMenu(int x, int y)
 {
@@ -1405,6 +1583,7 @@ bool SWS_ListView::DoColumnMenu(int x, int y)
 			}
 
 			ListView_DeleteAllItems(m_hwndList);
+			m_rowStates.clear();
 			while(ListView_DeleteColumn(m_hwndList, 0));
 			ShowColumns();
 			Update();
@@ -1467,6 +1646,13 @@ SWS_ListItem* SWS_ListView::GetHitItem(int x, int y, int* iCol)
 void SWS_ListView::EditListItem(SWS_ListItem* item, int iCol)
 {
 	// Convert to index and call edit
+	if (m_bVirtual)
+	{
+		int iItem = m_vItems.Find(item);
+		if (iItem >= 0)
+			EditListItem(iItem, iCol);
+		return;
+	}
 #ifdef _WIN32
 	LVFINDINFO fi;
 	fi.flags = LVFI_PARAM;
@@ -1557,12 +1743,17 @@ bool SWS_ListView::EditListItemEnd(bool bSave, bool bResort)
 			if (strcmp(curStr, newStr))
 			{
 				SetItemText(item, editedCol, newStr);
-				GetItemText(item, editedCol, newStr, sizeof(newStr));
-				ListView_SetItemText(m_hwndList, m_iEditingItem, DataToDisplayCol(editedCol), newStr);
+				if (m_bVirtual)
+					InvalidateRect(m_hwndList, NULL, FALSE);
+				else
+				{
+					GetItemText(item, editedCol, newStr, sizeof(newStr));
+					ListView_SetItemText(m_hwndList, m_iEditingItem, DataToDisplayCol(editedCol), newStr);
+				}
 				updated = true;
 			}
 			if (bResort)
-				ListView_SortItems(m_hwndList, sListCompare, (LPARAM)this);
+				SortItems();
 			// TODO resort? Just call update?
 			// Update is likely called when SetItemText is called too...
 		}
@@ -1591,6 +1782,23 @@ int SWS_ListView::OnItemSort(SWS_ListItem* item1, SWS_ListItem* item2)
   return (m_iSortCol<0 ? -cmp : cmp);
 }
 
+// Sort key of the default OnItemSort(): the cell text, numeric if the whole column is
+bool SWS_ListView::GetTextSortKey(SWS_ListItem* item, int iCol, SWS_SortKey* key)
+{
+	char str[CELL_MAX_LEN]="";
+	GetItemText(item, iCol, str, sizeof(str));
+
+	char* end;
+	key->dNum = strtod(str, &end);
+	key->bNum = end != str && !*end;
+
+	// Normalized for case insensitive comparisons, see OnItemSort()
+	for (char* p = str; *p; p++)
+		*p = (char)toupper((unsigned char)*p);
+	key->str.Set(str);
+	return true;
+}
+
 void SWS_ListView::ShowColumns()
 {
 	LVCOLUMN col;
@@ -1624,7 +1832,7 @@ void SWS_ListView::ShowColumns()
 
 void SWS_ListView::Sort()
 {
-	ListView_SortItems(m_hwndList, sListCompare, (LPARAM)this);
+	SortItems();
 	int iCol = abs(m_iSortCol) - 1;
 	iCol = DataToDisplayCol(iCol) + 1;
 	if (m_iSortCol < 0)
@@ -1633,6 +1841,77 @@ void SWS_ListView::Sort()
 	OnItemSortEnd();
 }
 
+void SWS_ListView::SortItems()
+{
+	const int iCol = abs(m_iSortCol) - 1;
+	WDL_PtrList<SWS_ListItem> rows;
+	if (!m_bVirtual)
+		for (int i = 0; i < GetListItemCount(); i++)
+			rows.Add(GetListItem(i));
+	WDL_PtrList<SWS_ListItem>* items = m_bVirtual ? &m_vItems : &rows;
+
+	// Pull the sort keys once
+	std::vector<SWS_SortKey> keys(items->GetSize());
+	bool bNum = true;
+	m_bCustomSort = false;
+	for (int i = 0; !m_bCustomSort && i < items->GetSize(); i++)
+	{
+		m_bCustomSort = !GetItemSortKey(items->Get(i), iCol, &keys[i]);
+		bNum &= keys[i].bNum;
+	}
+
+	if (!m_bCustomSort)
+	{
+		// Sort indexes, ties are kept in the current order
+		std::vector<int> order(items->GetSize());
+		for (int i = 0; i < (int)order.size(); i++)
+			order[i] = i;
+		std::sort(order.begin(), order.end(), [&](int i1, int i2) {
+			int cmp = bNum ? (keys[i1].dNum > keys[i2].dNum) - (keys[i1].dNum < keys[i2].dNum) :
+				WDL_strcmp_logical(keys[i1].str.Get(), keys[i2].str.Get(), true);
+			if (m_iSortCol < 0) cmp = -cmp;
+			return cmp ? cmp < 0 : i1 < i2;
+		});
+
+		if (m_bVirtual)
+		{
+			// Selection states of virtual lists are stored by index: make them follow the items
+			std::unordered_set<SWS_ListItem*> sel;
+			GetSelectedItems(&sel);
+			WDL_PtrList<SWS_ListItem> sorted;
+			for (int i = 0; i < (int)order.size(); i++)
+				sorted.Add(m_vItems.Get(order[i]));
+			m_vItems.Empty();
+			for (int i = 0; i < sorted.GetSize(); i++)
+				m_vItems.Add(sorted.Get(i));
+			SetSelectedItems(sel);
+			InvalidateRect(m_hwndList, NULL, FALSE);
+		}
+		else
+		{
+			// The control sorts by item, compare their ranks
+			std::unordered_map<SWS_ListItem*,int> ranks;
+			ranks.reserve(order.size());
+			for (int i = 0; i < (int)order.size(); i++)
+				ranks[rows.Get(order[i])] = i;
+			ListView_SortItems(m_hwndList, sRankCompare, (LPARAM)&ranks);
+		}
+	}
+	else if (m_bVirtual)
+	{
+		// Selection states of virtual lists are stored by index: make them follow the items
+		std::unordered_set<SWS_ListItem*> sel;
+		GetSelectedItems(&sel);
+		SWS_ListItem** list = m_vItems.GetList();
+		std::stable_sort(list, list + m_vItems.GetSize(),
+			[this](SWS_ListItem* item1, SWS_ListItem* item2) { return OnItemSort(item1, item2) < 0; });
+		SetSelectedItems(sel);
+		InvalidateRect(m_hwndList, NULL, FALSE);
+	}
+	else
+		ListView_SortItems(m_hwndList, sListCompare, (LPARAM)this);
+}
+
 void SWS_ListView::SetListviewColumnArrows(int iSortCol)
 {
 	if (!m_bDrawArrow) return;
@@ -1679,6 +1958,15 @@ int SWS_ListView::sListCompare(LPARAM lParam1, LPARAM lParam2, LPARAM lSortParam
 	return 0;
 }
 
+int SWS_ListView::sRankCompare(LPARAM lParam1, LPARAM lParam2, LPARAM lSortParam)
+{
+	const std::unordered_map<SWS_ListItem*,int>* ranks = (const std::unordered_map<SWS_ListItem*,int>*)lSortParam;
+	std::unordered_map<SWS_ListItem*,int>::const_iterator it1 = ranks->find((SWS_ListItem*)lParam1);
+	std::unordered_map<SWS_ListItem*,int>::const_iterator it2 = ranks->find((SWS_ListItem*)lParam2);
+	int r1 = it1 != ranks->end() ? it1->second : -1, r2 = it2 != ranks->end() ? it2->second : -1;
+	return r1 > r2 ? 1 : r1 < r2 ? -1 : 0;
+}
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // Code bits courtesy of Cockos. Thank you Cockos!
@@ -48,6 +48,14 @@ typedef struct SWS_LVColumn
 	int iPos;
 } SWS_LVColumn;
 
+// Sort key of a row, pulled once per sort
+typedef struct SWS_SortKey
+{
+	bool bNum;				// numeric key (dNum) if true for all rows, text key (str) otherwise
+	double dNum;
+	WDL_FastString str;		// compared with WDL_strcmp_logical(), case sensitive: normalize when needed
+} SWS_SortKey;
+
 class SWS_ListItem; // abstract.  At some point it might make sense to make this a real class?
 
 class SWS_ListItemList
@@ -56,16 +64,24 @@ public:
 	SWS_ListItemList() {}
 	~SWS_ListItemList() {}
 	int GetSize() { return m_list.GetSize(); }
-	void Add(SWS_ListItem* item, bool sort = true) { if (sort) m_list.InsertSorted(item, ILIComp); else m_list.Add(item); }
-	SWS_ListItem* Get(int iIndex) { return (SWS_ListItem*)m_list.Get(iIndex); }
-	int Find(SWS_ListItem* item) { return m_list.FindSorted(item, ILIComp); }
-	void Delete(int iIndex) { m_list.Delete(iIndex); }
-	// Remove returns and also removes the last item.  It's the last because it's more efficient to remove at the end.
-	SWS_ListItem* Remove() { if (!m_list.GetSize()) return NULL; int last = m_list.GetSize()-1; SWS_ListItem* item = (SWS_ListItem*)m_list.Get(last); m_list.Delete(last); return item; }
-	void Empty() { m_list.Empty(); }
+	void Add(SWS_ListItem* item) { m_list.Add(item); m_index.clear(); }
+	SWS_ListItem* Get(int iIndex) { return m_list.Get(iIndex); }
+	// Hashed lookup, the index is built on first use
+	int Find(SWS_ListItem* item)
+	{
+		if (m_index.empty() && m_list.GetSize())
+		{
+			m_index.reserve(m_list.GetSize());
+			for (int i = 0; i < m_list.GetSize(); i++)
+				m_index.insert(std::make_pair(m_list.Get(i), i)); // 1st one wins
+		}
+		std::unordered_map<SWS_ListItem*,int>::const_iterator it = m_index.find(item);
+		return it != m_index.end() ? it->second : -1;
+	}
+	void Empty() { m_list.Empty(); m_index.clear(); }
 private:
-	static int ILIComp(const SWS_ListItem** a, const SWS_ListItem** b) { return (*a > *b ? 1 : *a < *b ? -1 : 0); };
 	WDL_PtrList<SWS_ListItem> m_list;
+	std::unordered_map<SWS_ListItem*,int> m_index;
 };
 
 class SWS_ListView
@@ -107,6 +123,9 @@ public:
 	HWND GetHWND() { return m_hwndList; }
 	HWND GetEditHWND() { return m_hwndEdit; }
 	virtual bool HideGridLines() {return false;}
+	// Virtual (owner data) lists: opt-in with the LVS_OWNERDATA style in the resource file,
+	// rows are kept here and the control only asks for the text of the visible ones
+	bool IsVirtual() { return m_bVirtual; }
 
 protected:
 	void EditListItem(int iIndex, int iCol);
@@ -117,6 +136,8 @@ protected:
 	virtual void GetItemTooltip(SWS_ListItem* item, char* str, int iStrMax) {}
 	virtual void GetItemList(SWS_ListItemList* pList) { pList->Empty(); }
 	virtual int  GetItemState(SWS_ListItem* item) { return -1; } // Selection state: -1 == unchanged, 0 == false, 1 == selected
+	virtual bool IsItemDirty(SWS_ListItem* item) { return true; } // Return false to skip the text refresh of an existing row, see IsRowStateChanged()
+	virtual bool ResortOnUpdate() { return false; } // Virtual lists: return true if sort keys of existing rows can change between updates
 	// These inform the derived class of user interaction
 	virtual bool OnItemSelChanging(SWS_ListItem* item, bool bSel) { return false; } // Returns TRUE to prevent the change, or FALSE to allow the change
 	virtual void OnItemSelChanged(SWS_ListItem* item, int iState) { }
@@ -124,12 +145,23 @@ protected:
 	virtual void OnItemBtnClk(SWS_ListItem* item, int iCol, int iKeyState) {}
 	virtual void OnItemDblClk(SWS_ListItem* item, int iCol) {}
 	virtual int  OnItemSort(SWS_ListItem* item1, SWS_ListItem* item2);
+	// Sort keys are opt-in: views sorting the same way as their OnItemSort() return true with a key
+	// (e.g. GetTextSortKey(), which matches the default OnItemSort()), others sort with OnItemSort()
+	virtual bool GetItemSortKey(SWS_ListItem* item, int iCol, SWS_SortKey* key) { return false; }
+	bool GetTextSortKey(SWS_ListItem* item, int iCol, SWS_SortKey* key);
 	virtual void OnItemSortEnd() {};
 	virtual void OnBeginDrag(SWS_ListItem* item) {}
 	virtual bool IsEditListItemAllowed(SWS_ListItem* item, int iCol) { return true; }
 
+	// For IsItemDirty() overrides: state holds whatever the row's texts derive from (e.g.
+	// a NewItemRevision() stamp, a project state change count), returns true if it differs
+	// from the state seen at the row's previous check
+	bool IsRowStateChanged(SWS_ListItem* item, const WDL_INT64* state, int iSize);
+	static int NewItemRevision(); // Unique stamps for list items, callable from any thread
+
 	void SetListviewColumnArrows(int iSortCol);
 	static int CALLBACK sListCompare(LPARAM lParam1, LPARAM lParam2, LPARAM lSortParam);
+	static int CALLBACK sRankCompare(LPARAM lParam1, LPARAM lParam2, LPARAM lSortParam);
 
 	HWND m_hwndList;
 	HWND m_hwndTooltip;
@@ -150,6 +182,10 @@ protected:
 private:
 	void ShowColumns();
 	void Sort();
+	void SortItems();
+	void UpdateVirtual(bool bResort);
+	void GetSelectedItems(std::unordered_set<SWS_ListItem*>* pSel);
+	void SetSelectedItems(const std::unordered_set<SWS_ListItem*>& sel);
 
 #ifndef _WIN32
 	int m_iClickedCol;
@@ -159,6 +195,10 @@ private:
 	bool m_bShiftSel;
 #endif
 	WDL_TypedBuf<int> m_pSavedSel;
+	const bool m_bVirtual;
+	bool m_bCustomSort; // last sort used OnItemSort() comparisons rather than sort keys
+	WDL_PtrList<SWS_ListItem> m_vItems; // rows of virtual lists, in display order
+	std::unordered_map<SWS_ListItem*, WDL_UINT64> m_rowStates; // see IsRowStateChanged()
 	HWND m_hwndEdit;
 	SWS_LVColumn* m_pDefaultCols;
 	const char* m_cINIKey;